@@ -0,0 +1,513 @@
+/* in-place update of broadcast-wave bext/iXML timecode references
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "bwf.h"
+#include "wavfile.h"
+
+#define BEXT_SIZE           602 ///< version 1, without coding history
+#define BEXT_TIME_REFERENCE 338
+#define BEXT_VERSION        346
+#define HEADER_MAX          (16 << 20)
+#define MAX_JUNK            8
+
+struct junkspace {
+	uint64_t offset; ///< file-offset of the chunk header
+	uint64_t span;   ///< header, data and padding
+	uint64_t used;
+	uint64_t last;   ///< last chunk carved from it
+	char fill;       ///< padding of the last chunk
+};
+
+static inline uint32_t rd_le32(const uint8_t *p) {
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline uint64_t rd_le64(const uint8_t *p) {
+	return rd_le32(p) | ((uint64_t)rd_le32(p + 4) << 32);
+}
+
+static inline void wr_le16(uint8_t *p, uint16_t v) {
+	p[0] = v; p[1] = v >> 8;
+}
+
+static inline void wr_le32(uint8_t *p, uint32_t v) {
+	p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24;
+}
+
+static inline void wr_le64(uint8_t *p, uint64_t v) {
+	wr_le32(p, v);
+	wr_le32(p + 4, v >> 32);
+}
+
+static int is_junk(const char *id) {
+	return !memcmp(id, "JUNK", 4) || !memcmp(id, "junk", 4) || !memcmp(id, "FLLR", 4) || !memcmp(id, "PAD ", 4);
+}
+
+static int read_at(int fd, uint8_t *buf, size_t len, uint64_t offset) {
+	while (len > 0) {
+		ssize_t rv = pread(fd, buf, len, offset);
+		if (rv <= 0) return -1;
+		buf += rv;
+		len -= rv;
+		offset += rv;
+	}
+	return 0;
+}
+
+static int write_at(int fd, const uint8_t *buf, size_t len, uint64_t offset) {
+	while (len > 0) {
+		ssize_t rv = pwrite(fd, buf, len, offset);
+		if (rv <= 0) return -1;
+		buf += rv;
+		len -= rv;
+		offset += rv;
+	}
+	return 0;
+}
+
+/* iXML */
+
+static const char *speed_tags[] = {
+	"TIMECODE_RATE",
+	"TIMECODE_FLAG",
+	"TIMESTAMP_SAMPLE_RATE",
+	"TIMESTAMP_SAMPLES_SINCE_MIDNIGHT_HI",
+	"TIMESTAMP_SAMPLES_SINCE_MIDNIGHT_LO",
+};
+
+#define N_SPEED_TAGS (sizeof(speed_tags) / sizeof(speed_tags[0]))
+
+static void speed_value(const struct bwfinfo *bi, unsigned int tag, char *val, size_t len) {
+	switch (tag) {
+		case 0: snprintf(val, len, "%d/%d", bi->fps_num, bi->fps_den); break;
+		case 1: snprintf(val, len, "%s", bi->drop ? "DF" : "NDF"); break;
+		case 2: snprintf(val, len, "%d", bi->samplerate); break;
+		case 3: snprintf(val, len, "%u", (uint32_t)(bi->time_reference >> 32)); break;
+		case 4: snprintf(val, len, "%u", (uint32_t)(bi->time_reference & 0xffffffff)); break;
+	}
+}
+
+/* replace s[from, to) with ins, returns the new string */
+static char *str_splice(char *s, size_t from, size_t to, const char *ins) {
+	const size_t len = strlen(s);
+	const size_t n = strlen(ins);
+	char *r = malloc(len - (to - from) + n + 1);
+	memcpy(r, s, from);
+	memcpy(r + from, ins, n);
+	memcpy(r + from + n, s + to, len - to + 1);
+	free(s);
+	return r;
+}
+
+static char *ixml_speed(const struct bwfinfo *bi) {
+	char *s = malloc(1024);
+	size_t len = 0;
+	unsigned int i;
+	char val[32];
+
+	len += sprintf(s + len, "<SPEED>\n");
+	for (i = 0; i < N_SPEED_TAGS; ++i) {
+		speed_value(bi, i, val, sizeof(val));
+		len += sprintf(s + len, "<%s>%s</%s>\n", speed_tags[i], val, speed_tags[i]);
+	}
+	sprintf(s + len, "</SPEED>\n");
+	return s;
+}
+
+static char *ixml_new(const struct bwfinfo *bi) {
+	char *speed = ixml_speed(bi);
+	char *s = malloc(strlen(speed) + 128);
+	sprintf(s, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<BWFXML>\n<IXML_VERSION>1.61</IXML_VERSION>\n%s</BWFXML>\n", speed);
+	free(speed);
+	return s;
+}
+
+/* set the SPEED timestamps of an existing document.
+ * returns NULL if the document has no BWFXML element.
+ */
+static char *ixml_update(const uint8_t *data, size_t size, const struct bwfinfo *bi) {
+	char *s = malloc(size + 1);
+	char *p, *q;
+	unsigned int i;
+
+	memcpy(s, data, size);
+	s[size] = '\0';
+	/* strip padding */
+	for (i = strlen(s); i > 0 && (s[i - 1] == ' ' || s[i - 1] == '\n' || s[i - 1] == '\r'); --i) {
+		s[i - 1] = '\0';
+	}
+	if (!strstr(s, "</BWFXML>")) {
+		free(s);
+		return NULL;
+	}
+
+	p = strstr(s, "<SPEED>");
+	q = p ? strstr(p, "</SPEED>") : NULL;
+	if (!p || !q) {
+		char *speed = ixml_speed(bi);
+		p = strstr(s, "</BWFXML>");
+		s = str_splice(s, p - s, p - s, speed);
+		free(speed);
+		return s;
+	}
+
+	for (i = 0; i < N_SPEED_TAGS; ++i) {
+		char open[48], close[48], val[32];
+		char *a, *b;
+		snprintf(open, sizeof(open), "<%s>", speed_tags[i]);
+		snprintf(close, sizeof(close), "</%s>", speed_tags[i]);
+		speed_value(bi, i, val, sizeof(val));
+
+		p = strstr(s, "<SPEED>");
+		q = strstr(p, "</SPEED>");
+		a = strstr(p, open);
+		b = a ? strstr(a, close) : NULL;
+		if (a && b && b < q) {
+			s = str_splice(s, a + strlen(open) - s, b - s, val);
+		} else {
+			char elem[128];
+			snprintf(elem, sizeof(elem), "%s%s%s\n", open, val, close);
+			s = str_splice(s, q - s, q - s, elem);
+		}
+	}
+	return s;
+}
+
+/* put a new chunk into the JUNK space, returns 0 on success */
+static int junk_carve(uint8_t *image, struct junkspace *junk, int n_junk,
+		const char *id, const uint8_t *data, size_t size, char fill, uint64_t *offset) {
+	const uint64_t need = 8 + size;
+	int i;
+	for (i = 0; i < n_junk; ++i) {
+		struct junkspace *j = &junk[i];
+		uint8_t *p;
+		if (j->span - j->used < need) {
+			continue;
+		}
+		p = image + j->offset + j->used;
+		memcpy(p, id, 4);
+		wr_le32(p + 4, size);
+		memcpy(p + 8, data, size);
+		*offset = j->offset + j->used;
+		j->last = j->used;
+		j->fill = fill;
+		j->used += need;
+		return 0;
+	}
+	return -1;
+}
+
+/* turn the unused space back into JUNK */
+static void junk_finalize(uint8_t *image, struct junkspace *junk, int n_junk) {
+	int i;
+	for (i = 0; i < n_junk; ++i) {
+		struct junkspace *j = &junk[i];
+		const uint64_t rem = j->span - j->used;
+		if (j->used == 0) {
+			continue;
+		}
+		if (rem >= 8) {
+			uint8_t *p = image + j->offset + j->used;
+			memcpy(p, "JUNK", 4);
+			wr_le32(p + 4, rem - 8);
+			memset(p + 8, 0, rem - 8);
+		} else if (rem > 0) {
+			/* too small for a chunk: extend the last one */
+			uint8_t *p = image + j->offset + j->last;
+			wr_le32(p + 4, rd_le32(p + 4) + rem);
+			memset(image + j->offset + j->used, j->fill, rem);
+		}
+	}
+}
+
+int bwf_plan(int fd, const struct bwfinfo *bi, struct bwfplan *plan) {
+	struct stat st;
+	struct wavchunk chunk;
+	struct junkspace junk[MAX_JUNK];
+	struct wavchunk bext, ixml;
+	int have_bext = 0, have_ixml = 0, have_data = 0;
+	int n_junk = 0;
+	uint64_t ds64_data_size = 0;
+	uint64_t data_size = 0;
+	uint64_t pos;
+	size_t len;
+	uint8_t *buf = NULL;
+	char *xml = NULL;
+
+	memset(plan, 0, sizeof(struct bwfplan));
+	memset(&bext, 0, sizeof(bext));
+	memset(&ixml, 0, sizeof(ixml));
+	if (fstat(fd, &st) || st.st_size < 12) {
+		return BWF_ERR_FORMAT;
+	}
+
+	/* read the file up to the data chunk */
+	len = st.st_size < 65536 ? st.st_size : 65536;
+	for (;;) {
+		buf = realloc(buf, len);
+		if (read_at(fd, buf, len, 0)) {
+			free(buf);
+			return BWF_ERR_IO;
+		}
+		if (memcmp(buf + 8, "WAVE", 4) || (memcmp(buf, "RIFF", 4) && memcmp(buf, "RF64", 4))) {
+			free(buf);
+			return BWF_ERR_FORMAT;
+		}
+		pos = 12;
+		have_bext = have_ixml = n_junk = 0;
+		while (!wav_next_chunk(buf, len, &pos, &chunk)) {
+			if (!memcmp(chunk.id, "data", 4)) {
+				have_data = 1;
+				break;
+			}
+			if (!memcmp(chunk.id, "ds64", 4) && chunk.offset + 16 <= len) {
+				ds64_data_size = rd_le64(buf + chunk.offset + 8);
+			} else if (!memcmp(chunk.id, "bext", 4) && !have_bext) {
+				memcpy(&bext, &chunk, sizeof(chunk));
+				have_bext = 1;
+			} else if (!memcmp(chunk.id, "iXML", 4) && !have_ixml) {
+				memcpy(&ixml, &chunk, sizeof(chunk));
+				have_ixml = 1;
+			} else if (is_junk(chunk.id) && n_junk < MAX_JUNK) {
+				junk[n_junk].offset = chunk.offset - 8;
+				junk[n_junk].span = 8 + chunk.size + (chunk.size & 1);
+				junk[n_junk].used = 0;
+				++n_junk;
+			}
+		}
+		if (have_data) {
+			break;
+		}
+		if (len == (size_t) st.st_size || len >= HEADER_MAX) {
+			free(buf);
+			return BWF_ERR_FORMAT;
+		}
+		len = 2 * len < (size_t) st.st_size ? 2 * len : (size_t) st.st_size;
+	}
+
+	plan->data_offset = chunk.offset;
+	plan->image_len = chunk.offset;
+	plan->image = buf;
+	data_size = chunk.size;
+	if (!memcmp(buf, "RF64", 4) && chunk.size == 0xffffffff) {
+		data_size = ds64_data_size;
+	}
+	if (plan->data_offset + data_size > (uint64_t) st.st_size) {
+		data_size = st.st_size - plan->data_offset;
+	}
+	plan->data_size = data_size;
+
+	/* chunks after the audio data */
+	pos = plan->data_offset + data_size + (data_size & 1);
+	while (pos + 8 <= (uint64_t) st.st_size) {
+		uint8_t hdr[8];
+		if (read_at(fd, hdr, 8, pos)) {
+			break;
+		}
+		memcpy(chunk.id, hdr, 4);
+		chunk.size = rd_le32(hdr + 4);
+		chunk.offset = pos + 8;
+		if (!memcmp(chunk.id, "bext", 4) && !have_bext) {
+			memcpy(&bext, &chunk, sizeof(chunk));
+			have_bext = 1;
+		} else if (!memcmp(chunk.id, "iXML", 4) && !have_ixml) {
+			memcpy(&ixml, &chunk, sizeof(chunk));
+			have_ixml = 1;
+		}
+		pos = chunk.offset + chunk.size + (chunk.size & 1);
+	}
+
+	/* bext */
+	if (have_bext) {
+		if (bext.size < BEXT_VERSION) {
+			return BWF_ERR_FORMAT;
+		}
+		plan->bext = BWF_UPDATE;
+		plan->bext_offset = bext.offset - 8;
+		if (bext.offset < plan->image_len) {
+			wr_le64(plan->image + bext.offset + BEXT_TIME_REFERENCE, bi->time_reference);
+		} else {
+			struct bwfpatch *tp = &plan->tail[plan->n_tail++];
+			tp->offset = bext.offset + BEXT_TIME_REFERENCE;
+			tp->len = 8;
+			tp->data = malloc(8);
+			wr_le64(tp->data, bi->time_reference);
+		}
+	} else {
+		uint8_t data[BEXT_SIZE];
+		memset(data, 0, sizeof(data));
+		wr_le64(data + BEXT_TIME_REFERENCE, bi->time_reference);
+		wr_le16(data + BEXT_VERSION, 1);
+		if (junk_carve(plan->image, junk, n_junk, "bext", data, BEXT_SIZE, 0, &plan->bext_offset)) {
+			return BWF_ERR_NO_ROOM;
+		}
+		plan->bext = BWF_FROM_JUNK;
+	}
+
+	/* iXML */
+	if (bi->ixml && have_ixml) {
+		uint8_t *data = malloc(ixml.size);
+		if (ixml.offset < plan->image_len) {
+			memcpy(data, plan->image + ixml.offset, ixml.size);
+		} else if (read_at(fd, data, ixml.size, ixml.offset)) {
+			free(data);
+			return BWF_ERR_IO;
+		}
+		xml = ixml_update(data, ixml.size, bi);
+		if (!xml) {
+			free(data);
+			return BWF_ERR_FORMAT;
+		}
+		plan->ixml = BWF_NO_ROOM;
+		if (strlen(xml) <= ixml.size) {
+			/* pad with white-space, the chunk keeps its size */
+			memset(data, ' ', ixml.size);
+			memcpy(data, xml, strlen(xml));
+			plan->ixml = BWF_UPDATE;
+			plan->ixml_offset = ixml.offset - 8;
+			if (ixml.offset < plan->image_len) {
+				memcpy(plan->image + ixml.offset, data, ixml.size);
+				free(data);
+			} else {
+				struct bwfpatch *tp = &plan->tail[plan->n_tail++];
+				tp->offset = ixml.offset;
+				tp->len = ixml.size;
+				tp->data = data;
+			}
+		} else {
+			free(data);
+		}
+	} else if (bi->ixml) {
+		size_t size;
+		xml = ixml_new(bi);
+		size = strlen(xml);
+		if (size & 1) {
+			xml[size++] = ' ';
+		}
+		plan->ixml = BWF_NO_ROOM;
+		if (!junk_carve(plan->image, junk, n_junk, "iXML", (uint8_t *) xml, size, ' ', &plan->ixml_offset)) {
+			plan->ixml = BWF_FROM_JUNK;
+		}
+	}
+	free(xml);
+
+	junk_finalize(plan->image, junk, n_junk);
+	return BWF_OK;
+}
+
+/* parse the planned header and read back the timestamps */
+int bwf_check(const struct bwfplan *plan, const struct bwfinfo *bi) {
+	struct wavchunk chunk;
+	uint64_t pos = 12;
+	int found_bext = 0;
+
+	while (!wav_next_chunk(plan->image, plan->image_len, &pos, &chunk)) {
+		if (!memcmp(chunk.id, "data", 4)) {
+			break;
+		}
+		if (chunk.offset + chunk.size > plan->image_len) {
+			return BWF_ERR_VERIFY;
+		}
+		if (!memcmp(chunk.id, "bext", 4) && !found_bext) {
+			if (rd_le64(plan->image + chunk.offset + BEXT_TIME_REFERENCE) != bi->time_reference) {
+				return BWF_ERR_VERIFY;
+			}
+			found_bext = 1;
+		}
+		if (!memcmp(chunk.id, "iXML", 4) && plan->ixml != BWF_NO_ROOM) {
+			char lo[80];
+			char *xml = malloc(chunk.size + 1);
+			memcpy(xml, plan->image + chunk.offset, chunk.size);
+			xml[chunk.size] = '\0';
+			snprintf(lo, sizeof(lo), "<TIMESTAMP_SAMPLES_SINCE_MIDNIGHT_LO>%u<", (uint32_t)(bi->time_reference & 0xffffffff));
+			if (!strstr(xml, lo)) {
+				free(xml);
+				return BWF_ERR_VERIFY;
+			}
+			free(xml);
+		}
+	}
+	/* the audio data must not move */
+	if (memcmp(chunk.id, "data", 4) || chunk.offset != plan->data_offset) {
+		return BWF_ERR_VERIFY;
+	}
+	if (!found_bext) {
+		int i;
+		for (i = 0; i < plan->n_tail; ++i) {
+			if (plan->tail[i].len == 8 && rd_le64(plan->tail[i].data) == bi->time_reference) {
+				found_bext = 1;
+			}
+		}
+	}
+	return found_bext ? BWF_OK : BWF_ERR_VERIFY;
+}
+
+/* write the modified parts of the header, then read them back */
+int bwf_write(int fd, const struct bwfplan *plan) {
+	uint8_t *disk = malloc(plan->image_len);
+	size_t first, last;
+	int i, rv = BWF_OK;
+
+	if (read_at(fd, disk, plan->image_len, 0)) {
+		free(disk);
+		return BWF_ERR_IO;
+	}
+	for (first = 0; first < plan->image_len && disk[first] == plan->image[first]; ++first) ;
+	for (last = plan->image_len; last > first && disk[last - 1] == plan->image[last - 1]; --last) ;
+
+	if (last > first && write_at(fd, plan->image + first, last - first, first)) {
+		rv = BWF_ERR_IO;
+	}
+	for (i = 0; rv == BWF_OK && i < plan->n_tail; ++i) {
+		if (write_at(fd, plan->tail[i].data, plan->tail[i].len, plan->tail[i].offset)) {
+			rv = BWF_ERR_IO;
+		}
+	}
+	if (rv == BWF_OK && fsync(fd)) {
+		rv = BWF_ERR_IO;
+	}
+
+	if (rv == BWF_OK) {
+		if (read_at(fd, disk, plan->image_len, 0) || memcmp(disk, plan->image, plan->image_len)) {
+			rv = BWF_ERR_VERIFY;
+		}
+		for (i = 0; rv == BWF_OK && i < plan->n_tail; ++i) {
+			uint8_t *p = malloc(plan->tail[i].len);
+			if (read_at(fd, p, plan->tail[i].len, plan->tail[i].offset) || memcmp(p, plan->tail[i].data, plan->tail[i].len)) {
+				rv = BWF_ERR_VERIFY;
+			}
+			free(p);
+		}
+	}
+	free(disk);
+	return rv;
+}
+
+void bwf_plan_free(struct bwfplan *plan) {
+	int i;
+	free(plan->image);
+	for (i = 0; i < plan->n_tail; ++i) {
+		free(plan->tail[i].data);
+	}
+	plan->image = NULL;
+	plan->n_tail = 0;
+}
@@ -0,0 +1,69 @@
+#ifndef BWF_H
+#define BWF_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* in-place update of the timecode reference of a broadcast-wave file.
+ *
+ * Only the header is rewritten, never the audio data:
+ * An existing bext chunk is modified in place. Otherwise the bext (and
+ * iXML) chunk is carved from a JUNK (or FLLR, PAD) chunk before the data
+ * chunk, the remaining space stays JUNK. An existing iXML chunk is
+ * updated if the result fits into the chunk.
+ */
+
+enum BWF_ACTION {
+	BWF_NONE = 0,
+	BWF_UPDATE,    ///< existing chunk, modified in place
+	BWF_FROM_JUNK, ///< new chunk in place of a JUNK chunk
+	BWF_NO_ROOM,   ///< the chunk can not be written without moving the data
+};
+
+enum BWF_ERROR {
+	BWF_OK = 0,
+	BWF_ERR_IO = -1,
+	BWF_ERR_FORMAT = -2,  ///< not a RIFF/RF64 WAVE file
+	BWF_ERR_NO_ROOM = -3, ///< no bext and not enough JUNK
+	BWF_ERR_VERIFY = -4,
+};
+
+struct bwfinfo {
+	uint64_t time_reference; ///< samples since midnight
+	int samplerate;
+	int fps_num;
+	int fps_den;
+	int drop;
+	int ixml;                ///< also write iXML
+};
+
+struct bwfpatch {
+	uint64_t offset;
+	size_t   len;
+	uint8_t *data;
+};
+
+struct bwfplan {
+	enum BWF_ACTION bext;
+	enum BWF_ACTION ixml;
+	uint64_t bext_offset;    ///< file-offset of the chunk header
+	uint64_t ixml_offset;
+
+	uint64_t data_offset;
+	uint64_t data_size;
+
+	/* the file up to the data chunk, with the changes applied.
+	 * bwf_plan_free() must be called even if bwf_plan() fails */
+	uint8_t *image;
+	size_t   image_len;
+	/* changes after the data chunk */
+	struct bwfpatch tail[2];
+	int n_tail;
+};
+
+int  bwf_plan(int fd, const struct bwfinfo *bi, struct bwfplan *plan);
+int  bwf_check(const struct bwfplan *plan, const struct bwfinfo *bi);
+int  bwf_write(int fd, const struct bwfplan *plan);
+void bwf_plan_free(struct bwfplan *plan);
+
+#endif
@@ -1,3 +1,4 @@
+#include <string.h>
 #include "common_ltcdump.h"
 
 void
@@ -6,3 +7,105 @@ print_user_bits (FILE* outfile, LTCFrame* f)
 	unsigned long user_bits = ltc_frame_get_user_bits(f);
 	fprintf (outfile, "%08lx" "%-3s", user_bits, "");
 }
+
+static void wr_le(uint8_t *p, uint64_t v, int n) {
+	int i;
+	for (i = 0; i < n; ++i, v >>= 8) p[i] = v & 0xff;
+}
+
+static uint64_t rd_le(const uint8_t *p, int n) {
+	uint64_t v = 0;
+	while (n-- > 0) v = (v << 8) | p[n];
+	return v;
+}
+
+void
+ltcbin_write_header (FILE *outfile, uint32_t flags, uint32_t samplerate, uint32_t fps_num, uint32_t fps_den)
+{
+	uint8_t hdr[LTCBIN_HEADER_SIZE];
+	memset(hdr, 0, sizeof(hdr));
+	memcpy(hdr, "LTCFRAME", 8);
+	wr_le(hdr + 8, LTCBIN_VERSION, 2);
+	wr_le(hdr + 10, LTCBIN_RECORD_SIZE, 2);
+	wr_le(hdr + 12, flags, 4);
+	wr_le(hdr + 16, samplerate, 4);
+	wr_le(hdr + 20, fps_num, 4);
+	wr_le(hdr + 24, fps_den, 4);
+	fwrite(hdr, LTCBIN_HEADER_SIZE, 1, outfile);
+}
+
+void
+ltcbin_write_frame (FILE *outfile, LTCFrameExt *frame, int flags, const struct timespec *start, const struct timespec *end)
+{
+	uint8_t rec[LTCBIN_RECORD_SIZE];
+	const float volume = frame->volume;
+	uint32_t vol;
+
+	memcpy(&vol, &volume, sizeof(uint32_t));
+	memcpy(rec, &frame->ltc, 10);
+	rec[10] = frame->reverse ? 1 : 0;
+	rec[11] = flags;
+	wr_le(rec + 12, vol, 4);
+	wr_le(rec + 16, frame->off_start, 8);
+	wr_le(rec + 24, frame->off_end, 8);
+	wr_le(rec + 32, start ? start->tv_sec * 1000000000LL + start->tv_nsec : 0, 8);
+	wr_le(rec + 40, end ? end->tv_sec * 1000000000LL + end->tv_nsec : 0, 8);
+	fwrite(rec, LTCBIN_RECORD_SIZE, 1, outfile);
+}
+
+void
+ltcbin_write_event (FILE *outfile, int flags, long long int sample, const struct timespec *when)
+{
+	LTCFrameExt frame;
+	memset(&frame, 0, sizeof(LTCFrameExt));
+	frame.off_start = frame.off_end = sample;
+	ltcbin_write_frame(outfile, &frame, flags, when, when);
+}
+
+int
+ltcbin_read_header (FILE *infile, struct ltcbin_header *hdr)
+{
+	uint8_t buf[LTCBIN_HEADER_SIZE];
+	if (fread(buf, LTCBIN_HEADER_SIZE, 1, infile) != 1 || memcmp(buf, "LTCFRAME", 8)) {
+		return -1;
+	}
+	hdr->version = rd_le(buf + 8, 2);
+	hdr->record_size = rd_le(buf + 10, 2);
+	hdr->flags = rd_le(buf + 12, 4);
+	hdr->samplerate = rd_le(buf + 16, 4);
+	hdr->fps_num = rd_le(buf + 20, 4);
+	hdr->fps_den = rd_le(buf + 24, 4);
+	/* newer versions may only append fields */
+	if (hdr->version < 1 || hdr->record_size < LTCBIN_RECORD_SIZE) {
+		return -1;
+	}
+	return 0;
+}
+
+int
+ltcbin_read_frame (FILE *infile, const struct ltcbin_header *hdr, struct ltcbin_record *rec)
+{
+	uint8_t buf[LTCBIN_RECORD_SIZE];
+	uint32_t vol;
+	float volume;
+
+	if (fread(buf, LTCBIN_RECORD_SIZE, 1, infile) != 1) {
+		return -1;
+	}
+	if (hdr->record_size > LTCBIN_RECORD_SIZE
+			&& fseek(infile, hdr->record_size - LTCBIN_RECORD_SIZE, SEEK_CUR)) {
+		return -1;
+	}
+	memset(rec, 0, sizeof(struct ltcbin_record));
+	memcpy(&rec->frame.ltc, buf, 10);
+	rec->frame.reverse = buf[10];
+	rec->flags = buf[11];
+	vol = rd_le(buf + 12, 4);
+	memcpy(&volume, &vol, sizeof(float));
+	rec->frame.volume = volume;
+	rec->frame.off_start = rd_le(buf + 16, 8);
+	rec->frame.off_end = rd_le(buf + 24, 8);
+	rec->start_ns = rd_le(buf + 32, 8);
+	rec->end_ns = rd_le(buf + 40, 8);
+	return 0;
+}
@@ -2,9 +2,68 @@
 #define COMMON_LTCDUMP_H
 
 #include <stdio.h>
+#include <stdint.h>
+#include <time.h>
 #include <ltc.h>
 
 void print_user_bits(FILE *outfile, LTCFrame *f);
 
+/* binary frame-record format (--format=bin)
+ *
+ * header (32 bytes), all values little-endian
+ *   0  char[8]  "LTCFRAME"
+ *   8  uint16   version
+ *  10  uint16   record size
+ *  12  uint32   flags (LTCBIN_HAS_TIME)
+ *  16  uint32   sample-rate (0: unknown)
+ *  20  uint32   fps numerator
+ *  24  uint32   fps denominator
+ *  28  uint32   reserved
+ *
+ * record (48 bytes)
+ *   0  uint8[10] LTC frame, 80 bits in transmission order
+ *  10  uint8    reverse
+ *  11  uint8    flags (LTCBIN_DISCONTINUITY, LTCBIN_EVENT_*)
+ *  12  float32  volume [dBFS]
+ *  16  int64    off_start [samples]
+ *  24  int64    off_end [samples]
+ *  32  int64    unix time of off_start [ns] (LTCBIN_HAS_TIME)
+ *  40  int64    unix time of off_end [ns] (LTCBIN_HAS_TIME)
+ *
+ * An event record (jltcdump) has LTCBIN_EVENT_START or
+ * LTCBIN_EVENT_END set and carries no LTC frame: off_start and off_end
+ * are the audio-sample of the event, both unix times the time of it.
+ */
+
+#define LTCBIN_VERSION 1
+#define LTCBIN_HEADER_SIZE 32
+#define LTCBIN_RECORD_SIZE 48
+
+#define LTCBIN_HAS_TIME      1 ///< header flag: records carry unix timestamps
+#define LTCBIN_DISCONTINUITY 1 ///< record flag: timecode discontinuity before this frame
+#define LTCBIN_EVENT_START   2 ///< record flag: start of a recording, no frame
+#define LTCBIN_EVENT_END     4 ///< record flag: end of a recording, no frame
+
+struct ltcbin_header {
+	int version;
+	int record_size;
+	uint32_t flags;
+	uint32_t samplerate;
+	uint32_t fps_num;
+	uint32_t fps_den;
+};
+
+struct ltcbin_record {
+	LTCFrameExt frame;
+	int flags;
+	int64_t start_ns;
+	int64_t end_ns;
+};
+
+void ltcbin_write_header(FILE *outfile, uint32_t flags, uint32_t samplerate, uint32_t fps_num, uint32_t fps_den);
+void ltcbin_write_frame(FILE *outfile, LTCFrameExt *frame, int flags, const struct timespec *start, const struct timespec *end);
+void ltcbin_write_event(FILE *outfile, int flags, long long int sample, const struct timespec *when);
+int ltcbin_read_header(FILE *infile, struct ltcbin_header *hdr);
+int ltcbin_read_frame(FILE *infile, const struct ltcbin_header *hdr, struct ltcbin_record *rec);
+
 #endif
-/* vi:set ts=8 sts=2 sw=2: */
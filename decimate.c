@@ -0,0 +1,148 @@
+/* FIR decimator
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "decimate.h"
+
+#define MAX_RATE 48000
+#define DECIMATE_CHUNK 256 ///< input samples per step
+
+/* smallest factor that brings the rate down to 48kHz or less */
+int decimator_factor(int samplerate) {
+	if (samplerate <= MAX_RATE) return 1;
+	return (samplerate + MAX_RATE - 1) / MAX_RATE;
+}
+
+int decimator_init(struct decimator *d, int factor) {
+	double sum = 0;
+	double *h;
+	int i;
+
+	memset(d, 0, sizeof(struct decimator));
+	d->factor = 1;
+	if (factor < 2) {
+		return 0;
+	}
+
+	/* odd length: linear phase with an integer group-delay */
+	d->factor = factor;
+	d->taps = DECIMATE_TAPS_PER_PHASE * factor + 1;
+	d->coeff = malloc(d->taps * sizeof(float));
+	d->line = calloc(d->taps - 1 + DECIMATE_CHUNK, sizeof(float));
+	h = malloc(d->taps * sizeof(double));
+	if (!d->coeff || !d->line || !h) {
+		free(h);
+		decimator_free(d);
+		return -1;
+	}
+
+	/* windowed sinc (Blackman), cutoff at 0.45 of the output Nyquist-frequency.
+	 * The transition band is wide, but only content that aliases below ~10kHz
+	 * matters to the decoder, and that is well inside the stop-band. */
+	{
+		const double fc = 0.45 / factor; // relative to the input Nyquist frequency
+		const int c = d->taps / 2;
+		for (i = 0; i < d->taps; ++i) {
+			const double x = i - c;
+			const double w = 0.42 - 0.5 * cos(2 * M_PI * i / (d->taps - 1)) + 0.08 * cos(4 * M_PI * i / (d->taps - 1));
+			h[i] = w * (x == 0 ? fc : sin(M_PI * fc * x) / (M_PI * x));
+			sum += h[i];
+		}
+		/* unity gain at DC, the decoder's input level is unchanged */
+		for (i = 0; i < d->taps; ++i) {
+			d->coeff[i] = h[i] / sum;
+		}
+	}
+	free(h);
+	return 0;
+}
+
+void decimator_free(struct decimator *d) {
+	free(d->coeff);
+	free(d->line);
+	memset(d, 0, sizeof(struct decimator));
+	d->factor = 1;
+}
+
+void decimator_reset(struct decimator *d, int64_t in_pos) {
+	if (d->line) {
+		memset(d->line, 0, (d->taps - 1) * sizeof(float));
+	}
+	d->phase = 0;
+	d->in_base = in_pos;
+	d->out_pos = 0;
+}
+
+/* polyphase: only every factor'th output is computed, directly from
+ * the input. line holds the last taps - 1 input samples followed by up
+ * to DECIMATE_CHUNK new ones. The filter is symmetric, the samples that
+ * share a coefficient are added first.
+ * out may be the same as in. returns the number of output samples.
+ */
+size_t decimator_process(struct decimator *d, float *out, const float *in, size_t n) {
+	const int taps = d->taps;
+	const int mid = taps / 2;
+	const float *c = d->coeff;
+	size_t n_out = 0;
+
+	if (d->factor < 2) {
+		memmove(out, in, n * sizeof(float));
+		d->out_pos += n;
+		return n;
+	}
+
+	while (n > 0) {
+		const size_t m = n < DECIMATE_CHUNK ? n : DECIMATE_CHUNK;
+		size_t e;
+
+		memcpy(d->line + taps - 1, in, m * sizeof(float));
+
+		/* e: last input sample of the next output, relative to this chunk */
+		for (e = d->factor - 1 - d->phase; e < m; e += d->factor) {
+			const float *x = d->line + e;
+			/* independent partial sums, the additions don't wait for each other */
+			float a0 = c[mid] * x[mid], a1 = 0, a2 = 0, a3 = 0;
+			int k;
+			for (k = 0; k + 3 < mid; k += 4) {
+				a0 += c[k]     * (x[k]     + x[taps - 1 - k]);
+				a1 += c[k + 1] * (x[k + 1] + x[taps - 2 - k]);
+				a2 += c[k + 2] * (x[k + 2] + x[taps - 3 - k]);
+				a3 += c[k + 3] * (x[k + 3] + x[taps - 4 - k]);
+			}
+			for (; k < mid; ++k) {
+				a0 += c[k] * (x[k] + x[taps - 1 - k]);
+			}
+			out[n_out++] = (a0 + a1) + (a2 + a3);
+		}
+
+		d->phase = (d->phase + m) % d->factor;
+		memmove(d->line, d->line + m, (taps - 1) * sizeof(float));
+		in += m;
+		n -= m;
+	}
+	d->out_pos += n_out;
+	return n_out;
+}
+
+/* map a position in the decimated stream back to the input stream.
+ * Output j is computed after input in_base + (j + 1) * factor - 1 and
+ * is centred taps / 2 samples before it. */
+int64_t decimator_input_pos(const struct decimator *d, int64_t out_pos) {
+	if (d->factor < 2) return out_pos;
+	return d->in_base + out_pos * d->factor + d->factor - 1 - d->taps / 2;
+}
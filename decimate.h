@@ -0,0 +1,36 @@
+#ifndef DECIMATE_H
+#define DECIMATE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* FIR decimator for the LTC decoder input.
+ *
+ * LTC occupies only a few kHz, high sample-rates are reduced to 48kHz
+ * or less before decoding. Only every factor'th output is computed.
+ * Positions in the decimated stream are mapped back to the input
+ * with decimator_input_pos(), this includes the filter's group-delay.
+ */
+
+#ifndef DECIMATE_TAPS_PER_PHASE
+#define DECIMATE_TAPS_PER_PHASE 8
+#endif
+
+struct decimator {
+	int factor;       ///< 1: pass-through
+	int taps;
+	float *coeff;
+	float *line;      ///< history and input
+	int phase;        ///< input samples since the last output
+	int64_t in_base;  ///< input position at reset
+	int64_t out_pos;  ///< output samples since reset
+};
+
+int decimator_factor(int samplerate);
+int decimator_init(struct decimator *d, int factor);
+void decimator_free(struct decimator *d);
+void decimator_reset(struct decimator *d, int64_t in_pos);
+size_t decimator_process(struct decimator *d, float *out, const float *in, size_t n);
+int64_t decimator_input_pos(const struct decimator *d, int64_t out_pos);
+
+#endif
@@ -40,6 +40,7 @@
 #include <ltc.h>
 
 #include "ltcframeutil.h"
+#include "sampleconv.h"
 
 #ifndef WIN32
 #include <signal.h>
@@ -64,6 +65,7 @@ static int fps_num = 25;
 static int fps_den = 1;
 static int use30df = 0;
 static int detected_fps;
+static LTCFpsDetector fps_detector;
 static char *ltcportname = NULL;
 static char *mtcportname = NULL;
 
@@ -240,7 +242,7 @@ static void generate_mtc(LTCDecoder *d, int latency) {
     memset(&stime, 0, sizeof(SMPTETimecode)); // libltc <= 1.0.1, may not zero date
     ltc_frame_to_time(&stime, &frame.ltc, 0);
     if (detect_framerate) {
-      detect_fps(&detected_fps, &frame, &stime, stdout);
+      fps_detector_add(&fps_detector, &detected_fps, &frame, &stime, stdout);
     }
 
     moving = memcmp(&stime, &ptime, sizeof(SMPTETimecode));
@@ -343,14 +345,10 @@ static void generate_mtc(LTCDecoder *d, int latency) {
 }
 
 static int parse_ltc(const jack_nframes_t nframes, const jack_default_audio_sample_t * const in, const long long int posinfo) {
-  jack_nframes_t i;
   unsigned char sound[8192];
   if (nframes > 8192) return 1;
 
-  for (i = 0; i < nframes; i++) {
-    const int snd=(int)rint((127.0*in[i])+128.0);
-    sound[i] = (unsigned char) (snd&0xff);
-  }
+  conv_float_rint(sound, in, nframes);
 
   ltc_decoder_write(decoder, sound, nframes, posinfo);
   return 0;
@@ -620,6 +618,8 @@ int main (int argc, char **argv) {
 
   // -=-=-= INITIALIZE =-=-=-
 
+  sampleconv_init();
+
   if (init_jack("jltc2mtc"))
     goto out;
   if (jack_portsetup())
@@ -630,6 +630,7 @@ int main (int argc, char **argv) {
   }
 
   detected_fps = ceil((double)fps_num/fps_den);
+  fps_detector_init(&fps_detector, 0); // the MTC rate follows the frame-numbers only
 
   if (!detect_framerate && (rint(100.0*(double)fps_num/fps_den) == 2997.0) )
     use30df=1;
@@ -50,6 +50,8 @@
 
 #include "common_ltcdump.h"
 #include "ltcframeutil.h"
+#include "sampleconv.h"
+#include "decimate.h"
 #include "myclock.h"
 
 static jack_port_t **input_port = NULL;
@@ -80,7 +82,15 @@ static int fps_den = 1;
 static float rs_thresh = 0.01;
 static float hpf_alpha = 0.6;  // =  ( 1 + (2*M_Pi * fc / fs) )^-1  ;; fc=cutoff-freq, fs=sampling-frew
 static int detected_fps;
+static LTCFpsDetector fps_detector;
+static LTCDiscontinuity discontinuity; // zero-filled: no date, exact fps
 static int use_date = 0; // TODO
+static int bin_format = 0;
+static int use_decimation = 0;
+static struct decimator dec;
+static ltc_off_t dec_next_pos = 0; // expected posinfo of the next process cycle
+
+#define BIN_OUTPUT_BUFFER (1 << 20)
 #ifdef DEBUG_RS_SIGNAL
 static int debug_rs = 0;
 #endif
@@ -169,6 +179,7 @@ static void cleanup(int sig) {
   }
 
   ltc_decoder_free(decoder);
+  decimator_free(&dec);
   free(in);
   free(input_port);
   if (rb) jack_ringbuffer_free(rb);
@@ -201,11 +212,18 @@ void event_end (long long int fcnt) {
   event_info.state = Stopped;
 }
 
+/* map frame positions from the decimated stream back to jack's frame-count */
+static void frame_rescale(LTCFrameExt *frame) {
+  if (dec.factor > 1) {
+    frame->off_start = decimator_input_pos(&dec, frame->off_start);
+    frame->off_end = decimator_input_pos(&dec, frame->off_end);
+  }
+}
+
 /**
  *
  */
 static void my_decoder_read(LTCDecoder *d) {
-  static LTCFrameExt prev_time;
   static int frames_in_sequence = 0;
   static char *path = NULL;
   LTCFrameExt frame;
@@ -221,14 +239,15 @@ static void my_decoder_read(LTCDecoder *d) {
     for (i=LTC_QUEUE_LEN/2; i < frames_in_queue; i++) {
       SMPTETimecode stime;
       ltc_decoder_read(d,&frame);
+      frame_rescale(&frame);
       ltc_frame_to_time(&stime, &frame.ltc, 0);
       if (detect_framerate) {
-	if (detect_fps(&detected_fps, &frame, &stime, output) > 0) fps_locked = 1;
+	if (fps_detector_add(&fps_detector, &detected_fps, &frame, &stime, bin_format ? NULL : output) > 0) fps_locked = 1;
 	if (fps_locked || !detect_framerate) {
-	  if (detect_discontinuity(&frame, &prev_time, detected_fps, 0, 0)) fps_locked=0;
+	  if (discontinuity_add(&discontinuity, &frame, detected_fps)) fps_locked=0;
 	}
       }
-      memcpy(&prev_time, &frame, sizeof(LTCFrameExt));
+      discontinuity_set(&discontinuity, &frame);
     }
 
     processed_tc = avail_tc > 8 ? 1 : 0;
@@ -236,11 +255,13 @@ static void my_decoder_read(LTCDecoder *d) {
   }
   if (event_info.state == Stopped) {
     // keep processing frames until (frame.off_end > event_info.audio_frame_end)
-    if (prev_time.off_end > event_info.audio_frame_end) {
+    if (discontinuity.prev.off_end > event_info.audio_frame_end) {
       event_info.state = Idle;
 
       // close TME file
-      if (output)
+      if (output && bin_format)
+	ltcbin_write_event(output, LTCBIN_EVENT_END, event_info.audio_frame_end, (struct timespec*) &event_info.ev_end);
+      else if (output)
 	fprintf(output, "#End: sample: %lld tme: %ld.%09ld\n",
 	    event_info.audio_frame_end,
 	    event_info.ev_end.tv_sec, event_info.ev_end.tv_nsec
@@ -295,7 +316,19 @@ static void my_decoder_read(LTCDecoder *d) {
       output = fopen(fileprefix, "a");
     }
 
-    if (output) {
+    if (output && bin_format) {
+      if (output != stdout) {
+	setvbuf(output, NULL, _IOFBF, BIN_OUTPUT_BUFFER);
+	// appending to an existing file: the header is already there
+	fseek(output, 0, SEEK_END);
+	if (ftell(output) == 0) {
+	  ltcbin_write_header(output, LTCBIN_HAS_TIME, j_samplerate, fps_num, fps_den);
+	}
+      }
+      ltcbin_write_event(output, LTCBIN_EVENT_START, event_info.audio_frame_start, (struct timespec*) &event_info.ev_start);
+      fflush(output);
+    }
+    else if (output) {
       fprintf(output, "#Start: sample: %lld tme: %ld.%09ld\n",
 	  event_info.audio_frame_start,
 	  event_info.ev_start.tv_sec, event_info.ev_start.tv_nsec
@@ -311,16 +344,17 @@ static void my_decoder_read(LTCDecoder *d) {
 
   while (ltc_decoder_read(d,&frame)) {
     SMPTETimecode stime;
+    frame_rescale(&frame);
     ltc_frame_to_time(&stime, &frame.ltc, use_date? LTC_USE_DATE : 0);
     if (detect_framerate) {
-      if (detect_fps(&detected_fps, &frame, &stime, output) > 0) fps_locked = 1;
+      if (fps_detector_add(&fps_detector, &detected_fps, &frame, &stime, bin_format ? NULL : output) > 0) fps_locked = 1;
     }
 
     int discontinuity_detected = 0;
     if (fps_locked || !detect_framerate) {
-      discontinuity_detected = detect_discontinuity(&frame, &prev_time, detected_fps, 0, 0);
+      discontinuity_detected = discontinuity_add(&discontinuity, &frame, detected_fps);
     } else {
-      memcpy(&prev_time, &frame, sizeof(LTCFrameExt));
+      discontinuity_set(&discontinuity, &frame);
     }
     if (discontinuity_detected) {
       fps_locked = 0;
@@ -337,7 +371,7 @@ static void my_decoder_read(LTCDecoder *d) {
 
     /* notify about discontinuities */
     if (frames_in_sequence > 0 && discontinuity_detected) {
-      if (output)
+      if (output && !bin_format)
 	fprintf(output, "#DISCONTINUITY\n");
     }
     frames_in_sequence++;
@@ -393,7 +427,12 @@ static void my_decoder_read(LTCDecoder *d) {
       }
     }
 
-    if (output) {
+    if (output && bin_format) {
+      ltcbin_write_frame(output, &frame,
+	  (frames_in_sequence > 1 && discontinuity_detected) ? LTCBIN_DISCONTINUITY : 0,
+	  &tc_start, &tc_end);
+    }
+    else if (output) {
       if (use_date)
 	fprintf(output, "%02d-%02d-%02d ",
 	    stime.years,
@@ -427,20 +466,33 @@ out:
   }
   free(tcs);
 
+  /* once per process-cycle, in text and binary format alike */
   if (output) {
     fflush(output);
   }
 }
 
 static int parse_ltc(jack_nframes_t nframes, jack_default_audio_sample_t *in, ltc_off_t posinfo) {
-  jack_nframes_t i;
   unsigned char sound[8192];
   if (nframes > 8192) return 1;
 
-  for (i = 0; i < nframes; i++) {
-    const int snd=(int)rint((127.0*in[i])+128.0);
-    sound[i] = (unsigned char) (snd&0xff);
+  if (dec.factor > 1) {
+    static float decimated[8192]; // process-thread only
+    ltc_off_t pos = dec.out_pos;
+    size_t n;
+    /* first cycle or latency change: keep the mapping to posinfo */
+    if (posinfo != dec_next_pos) {
+      dec.in_base += posinfo - dec_next_pos;
+    }
+    dec_next_pos = posinfo + nframes;
+
+    n = decimator_process(&dec, decimated, in, nframes);
+    conv_float_rint(sound, decimated, n);
+    ltc_decoder_write(decoder, sound, n, pos);
+    return 0;
   }
+
+  conv_float_rint(sound, in, nframes);
   ltc_decoder_write(decoder, sound, nframes, posinfo);
   return 0;
 }
@@ -619,7 +671,16 @@ static int jack_portsetup(void) {
   input_port = (jack_port_t **) malloc (sizeof (jack_port_t *) * nports);
   in = (jack_default_audio_sample_t **) calloc (nports,sizeof (jack_default_audio_sample_t *));
 
-  decoder = ltc_decoder_create(j_samplerate * fps_den / fps_num, LTC_QUEUE_LEN);
+  if (use_decimation && decimator_init(&dec, decimator_factor(j_samplerate))) {
+    fprintf (stderr, "cannot allocate decimator\n");
+    return (-1);
+  }
+  decimator_reset(&dec, 0);
+  if (dec.factor > 1) {
+    fprintf (stderr, "decimating input by 1/%d\n", dec.factor);
+  }
+
+  decoder = ltc_decoder_create(j_samplerate * fps_den / fps_num / (dec.factor > 1 ? dec.factor : 1), LTC_QUEUE_LEN);
 
   for (i = 0; i < nports; i++) {
     char name[64];
@@ -647,6 +708,7 @@ static void jack_port_connect(char **jack_port, int argc) {
  */
 static void main_loop(void) {
   detected_fps = ceil((double)fps_num/fps_den);
+  fps_detector_init(&fps_detector, j_samplerate);
 
   pthread_mutex_lock (&ltc_thread_lock);
   while (client_state != Exit) {
@@ -685,6 +747,8 @@ static struct option const long_options[] =
   {"help", no_argument, 0, 'h'},
   {"output", required_argument, 0, 'o'},
   {"highpass", required_argument, 0, 'H'},
+  {"decimate", no_argument, 0, 'd'},
+  {"format", required_argument, 0, 'O'},
   {"fps", required_argument, 0, 'f'},
   {"detectfps", no_argument, 0, 'F'},
   {"runstop", no_argument, 0, 'r'},
@@ -698,12 +762,15 @@ static void usage (int status) {
   printf ("jltcdump - JACK app to parse linear time code.\n\n");
   printf ("Usage: jltcdump [ OPTIONS ] [ JACK-PORTS ]\n\n");
   printf ("Options:\n\
+  -d, --decimate             decimate high sample-rate input to <= 48kHz\n\
+                             before decoding\n\
   -f, --fps  <num>[/den]     set expected [initial] framerate (default 25/1)\n\
   -F, --detectfps            autodetect framerate from LTC\n\
   -H  <alpha>\n\
   --highpass <alpha>         set R/S highpass filter coefficient (dflt 0.6)\n\
   -h, --help                 display this help and exit\n\
   -o, --output <path>        write to file(s)\n\
+  -O, --format <fmt>         output format: 'text' (default) or 'bin'\n\
   -s, --signals              start/stop parser using SIGUSR1/SIGUSR2\n\
   -r, --runstop              parse R/S signal on 2nd channel\n\
   -R  <float>,\n\
@@ -715,6 +782,10 @@ If both -s and -o are given, <path> is used a prefix:\n\
 The filename will be <path>YYMMDD-HHMMSS.tme.XXXXX .\n\
 If only -o is set, <path> is as filename.\n\
 \n\
+The 'bin' format writes fixed-size little-endian frame-records\n\
+including the unix-time, and event-records for #Start and #End;\n\
+use ltcbin2txt to convert them to text.\n\
+\n\
 In 'signal' mode, the application starts in 'idle' state\n\
 and won't record LTC until it receives SIGUSR1.\n\
 \n\
@@ -735,11 +806,13 @@ static int decode_switches (int argc, char **argv) {
 
   while ((c = getopt_long (argc, argv,
 			   "h"	/* help */
+			   "d"	/* decimate */
 			   "D"	/* debug R/S*/
 			   "F"	/* detect framerate */
 			   "f:"	/* fps */
 			   "H:"	/* high-pass */
 			   "o:"	/* output-prefix */
+			   "O:"	/* output format */
 			   "r "	/* parse R/S */
 			   "R:"	/* R/S signal threshold */
 			   "s"	/* signals */
@@ -748,6 +821,10 @@ static int decode_switches (int argc, char **argv) {
     {
       switch (c)
 	{
+	case 'd':
+	  use_decimation = 1;
+	  break;
+
 	case 'D':
 #ifdef DEBUG_RS_SIGNAL
 	  debug_rs=1;
@@ -778,6 +855,17 @@ static int decode_switches (int argc, char **argv) {
 	  fileprefix = strdup(optarg);
 	  break;
 
+	case 'O':
+	  if (!strcmp(optarg, "bin")) {
+	    bin_format = 1;
+	  } else if (!strcmp(optarg, "text")) {
+	    bin_format = 0;
+	  } else {
+	    fprintf(stderr, "unknown output format '%s'\n", optarg);
+	    usage (EXIT_FAILURE);
+	  }
+	  break;
+
 	case 'r':
 	  nports = 2;
 	  break;
@@ -816,6 +904,8 @@ int main (int argc, char **argv) {
 
   // -=-=-= INITIALIZE =-=-=-
 
+  sampleconv_init();
+
   if (init_jack("jltcdump"))
     goto out;
   if (jack_portsetup())
@@ -851,7 +941,11 @@ int main (int argc, char **argv) {
 
   output = stdout;
 
-  if (!fileprefix) {
+  if (!fileprefix && bin_format) {
+    setvbuf(output, NULL, _IOFBF, BIN_OUTPUT_BUFFER);
+    ltcbin_write_header(output, LTCBIN_HAS_TIME, j_samplerate, fps_num, fps_den);
+  }
+  else if (!fileprefix) {
     if (use_date) {
       fprintf(output,"##  SMPTE   | audio-sample-num REV|             unix-system-time\n");
       fprintf(output,"##time-code |  start      end  ERS|       start                   end   \n");
@@ -63,6 +63,7 @@ static int fps_locked = 0;
 static int fps_num = 25;
 static int fps_den = 1;
 static int detected_fps;
+static LTCFpsDetector fps_detector;
 static int want_verbose = 0;
 
 /* a simple state machine for this client */
@@ -123,7 +124,7 @@ static void action (float t0, float t1) {
  * called in main (non-realtime) thread. parse and process LTC
  */
 static void my_decoder_read (LTCDecoder *d) {
-  static LTCFrameExt prev_frame;
+  static LTCDiscontinuity discontinuity; // zero-filled: no date, exact fps
   static int frames_in_sequence = 0;
   LTCFrameExt frame;
 
@@ -133,13 +134,13 @@ static void my_decoder_read (LTCDecoder *d) {
     ltc_frame_to_time(&stime, &frame.ltc, 0);
 
     if (detect_framerate) {
-      if (detect_fps (&detected_fps, &frame, &stime, output) > 0) {
+      if (fps_detector_add (&fps_detector, &detected_fps, &frame, &stime, output) > 0) {
 	fps_locked = 1;
       }
     }
 
     if (frames_in_sequence > 0) {
-      float t0 = ltcframe_to_framecnt(&prev_frame.ltc, detected_fps) / detected_fps;
+      float t0 = ltcframe_to_framecnt(&discontinuity.prev.ltc, detected_fps) / detected_fps;
       float t1 = ltcframe_to_framecnt(&frame.ltc, detected_fps) / detected_fps;
       action (t0, t1);
     }
@@ -147,9 +148,9 @@ static void my_decoder_read (LTCDecoder *d) {
     /* detect discontinuities in LTC */
     int discontinuity_detected = 0;
     if (fps_locked || !detect_framerate) {
-      discontinuity_detected = detect_discontinuity (&frame, &prev_frame, detected_fps, 0, 0);
+      discontinuity_detected = discontinuity_add (&discontinuity, &frame, detected_fps);
     } else {
-      memcpy(&prev_frame, &frame, sizeof(LTCFrameExt));
+      discontinuity_set (&discontinuity, &frame);
     }
     if (discontinuity_detected) {
       fps_locked = 0;
@@ -252,6 +253,7 @@ static void jack_port_connect(char *jack_port) {
 
 static void main_loop(void) {
   detected_fps = ceil((double)fps_num/fps_den);
+  fps_detector_init(&fps_detector, j_samplerate);
 
   pthread_mutex_lock (&ltc_thread_lock);
   while (client_state != Exit) {
@@ -0,0 +1,195 @@
+/*
+ * convert ltcdump/jltcdump binary frame-records to text
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <ltc.h>
+
+#include "common_ltcdump.h"
+
+int use_date = 0;
+
+static void print_header(const struct ltcbin_header *hdr) {
+	if (hdr->flags & LTCBIN_HAS_TIME) {
+		/* jltcdump */
+		if (use_date) {
+			printf("##  SMPTE   | audio-sample-num REV|             unix-system-time\n");
+			printf("##time-code |  start      end  ERS|       start                   end   \n");
+		} else {
+			printf("##        SMPTE        | audio-sample-num REV|             unix-system-time\n");
+			printf("##u-bits    time-code  |  start      end  ERS|       start                   end   \n");
+		}
+		return;
+	}
+	/* ltcdump */
+	printf("#");
+	if (use_date)
+		printf("%-10s %-5s ", "Date", "Zone");
+	else
+		printf("%-11s", "User bits");
+	printf("%-10s | %17s\n", "Timecode", "Pos. (samples)");
+}
+
+static void print_record(const struct ltcbin_header *hdr, struct ltcbin_record *rec) {
+	SMPTETimecode stime;
+	LTCFrameExt *frame = &rec->frame;
+
+	if (rec->flags & (LTCBIN_EVENT_START | LTCBIN_EVENT_END)) {
+		printf("#%s: sample: %lld tme: %lld.%09lld\n",
+				(rec->flags & LTCBIN_EVENT_START) ? "Start" : "End",
+				frame->off_start,
+				(long long int) (rec->start_ns / 1000000000), (long long int) (rec->start_ns % 1000000000));
+		return;
+	}
+
+	ltc_frame_to_time(&stime, &frame->ltc, use_date ? LTC_USE_DATE : 0);
+
+	if (rec->flags & LTCBIN_DISCONTINUITY) {
+		printf("#DISCONTINUITY\n");
+	}
+
+	if (hdr->flags & LTCBIN_HAS_TIME) {
+		if (use_date)
+			printf("%02d-%02d-%02d ", stime.years, stime.months, stime.days);
+		else
+			print_user_bits(stdout, &frame->ltc);
+		printf("%02d:%02d:%02d%c%02d | %8lld %8lld%s | %lld.%09lld  %lld.%09lld | %.1fdB\n",
+				stime.hours,
+				stime.mins,
+				stime.secs,
+				(frame->ltc.dfbit) ? '.' : ':',
+				stime.frame,
+				frame->off_start,
+				frame->off_end,
+				frame->reverse ? " R" : "  ",
+				(long long int) (rec->start_ns / 1000000000), (long long int) (rec->start_ns % 1000000000),
+				(long long int) (rec->end_ns / 1000000000), (long long int) (rec->end_ns % 1000000000),
+				frame->volume
+				);
+		return;
+	}
+
+	if (use_date)
+		printf("%04d-%02d-%02d %s ",
+				((stime.years < 67) ? 2000+stime.years : 1900+stime.years),
+				stime.months,
+				stime.days,
+				stime.timezone
+				);
+	else
+		print_user_bits(stdout, &frame->ltc);
+	printf("%02d:%02d:%02d%c%02d | %8lld %8lld%s\n",
+			stime.hours,
+			stime.mins,
+			stime.secs,
+			(frame->ltc.dfbit) ? '.' : ':',
+			stime.frame,
+			frame->off_start,
+			frame->off_end,
+			frame->reverse ? " R" : "  "
+			);
+}
+
+static int convert(FILE *infile, const char *name) {
+	struct ltcbin_header hdr;
+	struct ltcbin_record rec;
+
+	if (ltcbin_read_header(infile, &hdr)) {
+		fprintf(stderr, "Error: '%s' is not a LTC frame-record file\n", name);
+		return -1;
+	}
+	print_header(&hdr);
+	while (!ltcbin_read_frame(infile, &hdr, &rec)) {
+		print_record(&hdr, &rec);
+	}
+	return 0;
+}
+
+static void usage (int status) {
+	printf ("ltcbin2txt - convert binary LTC frame-records to text.\n\n");
+	printf ("Usage: ltcbin2txt [ OPTIONS ] [ <filename> ... ]\n\n");
+	printf ("Options:\n\
+  -d, --decodedate           decode date from LTC frame\n\
+  -h, --help                 display this help and exit\n\
+  -V, --version              print version information and exit\n\
+\n");
+	printf ("\n\
+Reads files written by 'ltcdump --format=bin' or 'jltcdump --format=bin'\n\
+and prints them in the text-format of the respective tool.\n\
+If no file is given, the records are read from stdin.\n\
+\n");
+	printf ("Report bugs to Robin Gareus <robin@gareus.org>\n"
+	        "Website and manual: <https://github.com/x42/ltc-tools>\n");
+	exit (status);
+}
+
+static struct option const long_options[] =
+{
+	{"help", no_argument, 0, 'h'},
+	{"decodedate", no_argument, 0, 'd'},
+	{"version", no_argument, 0, 'V'},
+	{NULL, 0, NULL, 0}
+};
+
+int main(int argc, char **argv) {
+	int rv = 0;
+	int c;
+
+	while ((c = getopt_long (argc, argv,
+			   "d"
+			   "h"  /* help */
+			   "V", /* version */
+			   long_options, (int *) 0)) != EOF)
+	{
+		switch (c) {
+			case 'd':
+				use_date=1;
+				break;
+
+			case 'V':
+				printf ("ltcbin2txt version %s\n\n", VERSION);
+				printf ("Copyright (C) GPL 2006,2012 Robin Gareus <robin@gareus.org>\n");
+				exit (0);
+
+			case 'h':
+				usage (0);
+
+			default:
+				usage (EXIT_FAILURE);
+		}
+	}
+
+	if (optind >= argc) {
+		return convert(stdin, "stdin");
+	}
+
+	for (; optind < argc; ++optind) {
+		FILE *f = fopen(argv[optind], "rb");
+		if (!f) {
+			fprintf(stderr, "Error: cannot open '%s'\n", argv[optind]);
+			rv = -1;
+			continue;
+		}
+		if (convert(f, argv[optind])) {
+			rv = -1;
+		}
+		fclose(f);
+	}
+	return rv;
+}
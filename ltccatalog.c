@@ -0,0 +1,617 @@
+/* append-only catalog of the timecode in many audio-files
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* File format, all values little-endian:
+ *
+ *  header (16 bytes)
+ *   0  char[8]  "LTCCATLG"
+ *   8  uint32   version
+ *  12  uint32   reserved
+ *
+ *  followed by any number of file-records
+ *   0  char[4]  "FILE"
+ *   4  uint32   size of the record, including this header
+ *   8  uint64   size of the audio-file
+ *  16  int64    mtime of the audio-file, seconds
+ *  24  uint32   mtime, nanoseconds
+ *  28  uint32   sample-rate
+ *  32  uint64   fingerprint
+ *  40  uint32   framerate numerator, 0: unknown
+ *  44  uint32   framerate denominator
+ *  48  uint8    drop-frame
+ *  49  uint8    audio-channel, first = 1
+ *  50  uint8    status
+ *  51  uint8    reserved
+ *  52  uint32   number of runs
+ *  56  uint32   length of the path
+ *  60  uint32   reserved
+ *  64  char[]   path, zero-padded to a multiple of 8 bytes
+ *
+ *   runs (40 bytes each), in file order
+ *   0  ...      as in the index-file, see ltcindex.c
+ *  32  uint8    year, month, day of the first frame
+ *  35  uint8[5] reserved
+ *
+ * Records are only ever appended, the last record of a path is valid.
+ * A file that was deleted is recorded with status "removed" and no runs.
+ * A partial record at the end (interrupted write) is discarded when the
+ * catalog is opened for writing. A writer holds an exclusive flock(2)
+ * on the catalog until it is closed, readers don't lock.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+
+#ifdef __APPLE__
+#define st_mtim st_mtimespec
+#endif
+
+#include "ltccatalog.h"
+#include "timecode.h"
+
+#define LTCCATALOG_VERSION 1
+#define HEADER_SIZE 16
+#define RECORD_SIZE 64
+#define RUN_SIZE 40
+#define RECORD_MAX (1 << 28)
+
+#define FP_BLOCK 65536 ///< bytes hashed at the start, middle and end of a file
+
+static void wr_le(uint8_t *p, uint64_t v, int n) {
+	int i;
+	for (i = 0; i < n; ++i, v >>= 8) p[i] = v & 0xff;
+}
+
+static uint64_t rd_le(const uint8_t *p, int n) {
+	uint64_t v = 0;
+	while (n-- > 0) v = (v << 8) | p[n];
+	return v;
+}
+
+static size_t pad8(size_t n) {
+	return (n + 7) & ~(size_t) 7;
+}
+
+void ltccatalog_file_init(struct ltccatalog_file *cf) {
+	memset(cf, 0, sizeof(struct ltccatalog_file));
+}
+
+void ltccatalog_file_free(struct ltccatalog_file *cf) {
+	free(cf->path);
+	free(cf->runs);
+	ltccatalog_file_init(cf);
+}
+
+static struct ltccatalog_run *file_new_run(struct ltccatalog_file *cf) {
+	if (cf->n_runs == cf->n_alloc) {
+		cf->n_alloc = cf->n_alloc ? cf->n_alloc * 2 : 16;
+		cf->runs = realloc(cf->runs, cf->n_alloc * sizeof(struct ltccatalog_run));
+	}
+	return &cf->runs[cf->n_runs++];
+}
+
+void ltccatalog_file_add(struct ltccatalog_file *cf, const struct ltcrun *run) {
+	struct ltccatalog_run *r = file_new_run(cf);
+	SMPTETimecode st;
+
+	ltcindex_run_set(&r->r, run);
+	ltc_frame_to_time(&st, (LTCFrame *) &run->first.ltc, LTC_USE_DATE);
+	r->year = st.years;
+	r->month = st.months;
+	r->day = st.days;
+}
+
+/* copy the decoding result of a file that was moved */
+void ltccatalog_file_copy_runs(struct ltccatalog_file *cf, const struct ltccatalog_file *src) {
+	uint32_t i;
+	cf->samplerate = src->samplerate;
+	cf->fps_num = src->fps_num;
+	cf->fps_den = src->fps_den;
+	cf->drop = src->drop;
+	cf->channel = src->channel;
+	cf->status = src->status;
+	cf->n_runs = 0;
+	for (i = 0; i < src->n_runs; ++i) {
+		*file_new_run(cf) = src->runs[i];
+	}
+}
+
+/* set the framerate from the longest run.
+ * The nominal rate is known from the frame-numbers, the duration of the
+ * run tells 24 from 23.976 and 30 from 29.97 fps.
+ */
+void ltccatalog_file_rate(struct ltccatalog_file *cf) {
+	const struct ltcindex_run *r = NULL;
+	double rate;
+	uint32_t i;
+
+	cf->fps_num = cf->fps_den = 0;
+	for (i = 0; i < cf->n_runs; ++i) {
+		if (!r || cf->runs[i].r.n_frames > r->n_frames) {
+			r = &cf->runs[i].r;
+		}
+	}
+	if (!r || r->fps == 0) {
+		return;
+	}
+
+	cf->fps_num = r->fps;
+	cf->fps_den = 1;
+	cf->drop = r->drop;
+	if (r->drop) {
+		cf->fps_num = r->fps * 1000;
+		cf->fps_den = 1001;
+		return;
+	}
+	if (r->n_frames < 2u * r->fps || r->end_sample <= r->start_sample || cf->samplerate == 0) {
+		return;
+	}
+	rate = (double) r->n_frames * cf->samplerate / (r->end_sample - r->start_sample + 1);
+	if ((r->fps == 24 || r->fps == 30) && fabs(rate - r->fps / 1.001) < fabs(rate - r->fps)) {
+		cf->fps_num = r->fps * 1000;
+		cf->fps_den = 1001;
+	}
+}
+
+int ltccatalog_stat(struct ltccatalog_file *cf, const char *path) {
+	struct stat st;
+	if (stat(path, &st)) {
+		return -1;
+	}
+	cf->file_size = st.st_size;
+	cf->file_mtime = st.st_mtim.tv_sec;
+	cf->file_mtime_ns = st.st_mtim.tv_nsec;
+	return 0;
+}
+
+static uint64_t fnv1a(uint64_t h, const uint8_t *p, size_t n) {
+	while (n-- > 0) {
+		h ^= *p++;
+		h *= 0x100000001b3ULL;
+	}
+	return h;
+}
+
+/* content fingerprint: 64 bit FNV-1a of the file-size and of the
+ * first, middle and last FP_BLOCK bytes (the whole of small files).
+ * This only samples the file, it is used to recognize a file that was
+ * moved, together with the size and mtime, see ltccatalog_lookup_moved().
+ * cf->file_size must be set, see ltccatalog_stat().
+ */
+int ltccatalog_fingerprint(struct ltccatalog_file *cf, const char *path) {
+	uint8_t buf[FP_BLOCK];
+	uint8_t sz[8];
+	uint64_t h = 0xcbf29ce484222325ULL;
+	off_t pos[3];
+	int i, n_pos, fd;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		return -1;
+	}
+
+	wr_le(sz, cf->file_size, 8);
+	h = fnv1a(h, sz, 8);
+
+	if (cf->file_size <= 3 * FP_BLOCK) {
+		pos[0] = 0;
+		n_pos = 1;
+	} else {
+		pos[0] = 0;
+		pos[1] = (cf->file_size / 2) & ~(uint64_t)(FP_BLOCK - 1);
+		pos[2] = cf->file_size - FP_BLOCK;
+		n_pos = 3;
+	}
+
+	for (i = 0; i < n_pos; ++i) {
+		ssize_t n;
+		off_t off = pos[i];
+		while ((n = pread(fd, buf, FP_BLOCK, off)) > 0) {
+			h = fnv1a(h, buf, n);
+			off += n;
+			if (n_pos > 1) break;
+		}
+		if (n < 0) {
+			close(fd);
+			return -1;
+		}
+	}
+
+	close(fd);
+	cf->fingerprint = h;
+	return 0;
+}
+
+/* read one file-record. returns 0 on success, -1 at the end of the catalog
+ * or if the record is incomplete */
+static int read_record(FILE *f, struct ltccatalog_file *cf) {
+	uint8_t hdr[8];
+	uint8_t *rec;
+	uint32_t size, path_len, i;
+
+	if (fread(hdr, 8, 1, f) != 1 || memcmp(hdr, "FILE", 4)) {
+		return -1;
+	}
+	size = rd_le(hdr + 4, 4);
+	if (size < RECORD_SIZE || size > RECORD_MAX) {
+		return -1;
+	}
+	rec = malloc(size);
+	memcpy(rec, hdr, 8);
+	if (fread(rec + 8, size - 8, 1, f) != 1) {
+		free(rec);
+		return -1;
+	}
+
+	ltccatalog_file_init(cf);
+	cf->n_runs = rd_le(rec + 52, 4);
+	path_len = rd_le(rec + 56, 4);
+	if (path_len == 0 || path_len > size
+			|| (uint64_t) RECORD_SIZE + pad8(path_len) + (uint64_t) cf->n_runs * RUN_SIZE != size) {
+		free(rec);
+		return -1;
+	}
+
+	cf->file_size = rd_le(rec + 8, 8);
+	cf->file_mtime = rd_le(rec + 16, 8);
+	cf->file_mtime_ns = rd_le(rec + 24, 4);
+	cf->samplerate = rd_le(rec + 28, 4);
+	cf->fingerprint = rd_le(rec + 32, 8);
+	cf->fps_num = rd_le(rec + 40, 4);
+	cf->fps_den = rd_le(rec + 44, 4);
+	cf->drop = rec[48];
+	cf->channel = rec[49];
+	cf->status = rec[50];
+
+	cf->path = malloc(path_len + 1);
+	memcpy(cf->path, rec + RECORD_SIZE, path_len);
+	cf->path[path_len] = '\0';
+
+	cf->n_alloc = cf->n_runs;
+	cf->runs = malloc((cf->n_runs > 0 ? cf->n_runs : 1) * sizeof(struct ltccatalog_run));
+	for (i = 0; i < cf->n_runs; ++i) {
+		const uint8_t *p = rec + RECORD_SIZE + pad8(path_len) + i * RUN_SIZE;
+		struct ltccatalog_run *r = &cf->runs[i];
+		r->r.start_sample = rd_le(p, 8);
+		r->r.end_sample = rd_le(p + 8, 8);
+		r->r.start_frame = rd_le(p + 16, 8);
+		r->r.n_frames = rd_le(p + 24, 4);
+		r->r.fps = p[28];
+		r->r.drop = p[29];
+		r->r.reverse = p[30];
+		r->r.end = p[31];
+		r->year = p[32];
+		r->month = p[33];
+		r->day = p[34];
+	}
+	free(rec);
+	return 0;
+}
+
+static int cmp_by_path(const void *a, const void *b) {
+	const struct ltccatalog_file *fa = (const struct ltccatalog_file *) a;
+	const struct ltccatalog_file *fb = (const struct ltccatalog_file *) b;
+	const int c = strcmp(fa->path, fb->path);
+	if (c) return c;
+	return fa->seq < fb->seq ? -1 : (fa->seq > fb->seq ? 1 : 0);
+}
+
+static int cmp_by_content(const void *a, const void *b) {
+	const struct ltccatalog_file *fa = *(const struct ltccatalog_file * const *) a;
+	const struct ltccatalog_file *fb = *(const struct ltccatalog_file * const *) b;
+	if (fa->file_size != fb->file_size) return fa->file_size < fb->file_size ? -1 : 1;
+	if (fa->file_mtime != fb->file_mtime) return fa->file_mtime < fb->file_mtime ? -1 : 1;
+	if (fa->file_mtime_ns != fb->file_mtime_ns) return fa->file_mtime_ns < fb->file_mtime_ns ? -1 : 1;
+	if (fa->fingerprint != fb->fingerprint) return fa->fingerprint < fb->fingerprint ? -1 : 1;
+	return 0;
+}
+
+/* keep the latest record of every path, unless the file was removed */
+static void catalog_sort(struct ltccatalog *cat) {
+	uint32_t i, n = 0;
+
+	qsort(cat->files, cat->n_files, sizeof(struct ltccatalog_file), cmp_by_path);
+	for (i = 0; i < cat->n_files; ++i) {
+		if ((i + 1 < cat->n_files && !strcmp(cat->files[i].path, cat->files[i + 1].path))
+				|| cat->files[i].status == LTCCATALOG_REMOVED) {
+			ltccatalog_file_free(&cat->files[i]);
+			continue;
+		}
+		cat->files[n++] = cat->files[i];
+	}
+	cat->n_files = n;
+
+	cat->by_content = malloc((n > 0 ? n : 1) * sizeof(struct ltccatalog_file *));
+	for (i = 0; i < n; ++i) {
+		cat->by_content[i] = &cat->files[i];
+	}
+	qsort(cat->by_content, n, sizeof(struct ltccatalog_file *), cmp_by_content);
+}
+
+static int write_all(int fd, const uint8_t *buf, size_t len) {
+	while (len > 0) {
+		const ssize_t n = write(fd, buf, len);
+		if (n < 0) {
+			if (errno == EINTR) continue;
+			return -1;
+		}
+		buf += n;
+		len -= n;
+	}
+	return 0;
+}
+
+int ltccatalog_open(struct ltccatalog *cat, const char *path, int writable) {
+	uint8_t hdr[HEADER_SIZE];
+	off_t good = 0;
+	size_t n;
+	FILE *f;
+	int fd = -1;
+
+	memset(cat, 0, sizeof(struct ltccatalog));
+	cat->fd = -1;
+
+	if (writable) {
+		/* lock before reading, a concurrent writer may be appending */
+		fd = open(path, O_RDWR | O_CREAT | O_APPEND, 0666);
+		if (fd < 0) {
+			return -1;
+		}
+		while (flock(fd, LOCK_EX)) {
+			if (errno != EINTR) {
+				close(fd);
+				return -1;
+			}
+		}
+	}
+
+	f = fopen(path, "rb");
+	if (!f) {
+		if (fd >= 0) close(fd);
+		return -1;
+	}
+	n = fread(hdr, 1, HEADER_SIZE, f);
+	if (n > 0 && (n != HEADER_SIZE
+				|| memcmp(hdr, "LTCCATLG", 8)
+				|| rd_le(hdr + 8, 4) != LTCCATALOG_VERSION)) {
+		/* not a catalog, don't touch it */
+		fclose(f);
+		if (fd >= 0) close(fd);
+		return -1;
+	}
+	if (n > 0) {
+		struct ltccatalog_file cf;
+		good = HEADER_SIZE;
+		while (!read_record(f, &cf)) {
+			if (cat->n_files == cat->n_alloc) {
+				cat->n_alloc = cat->n_alloc ? cat->n_alloc * 2 : 256;
+				cat->files = realloc(cat->files, cat->n_alloc * sizeof(struct ltccatalog_file));
+			}
+			cf.seq = cat->n_records++;
+			cat->files[cat->n_files++] = cf;
+			good = ftello(f);
+		}
+	}
+	fclose(f);
+	catalog_sort(cat);
+
+	if (!writable) {
+		return 0;
+	}
+
+	/* discard a partial record, or start a new catalog */
+	if (ftruncate(fd, good)) {
+		close(fd);
+		ltccatalog_close(cat);
+		return -1;
+	}
+	if (good == 0) {
+		memset(hdr, 0, sizeof(hdr));
+		memcpy(hdr, "LTCCATLG", 8);
+		wr_le(hdr + 8, LTCCATALOG_VERSION, 4);
+		if (write_all(fd, hdr, HEADER_SIZE)) {
+			close(fd);
+			ltccatalog_close(cat);
+			return -1;
+		}
+	}
+	cat->fd = fd;
+	return 0;
+}
+
+void ltccatalog_close(struct ltccatalog *cat) {
+	uint32_t i;
+	if (cat->fd >= 0) {
+		close(cat->fd); /* releases the lock */
+	}
+	for (i = 0; i < cat->n_files; ++i) {
+		ltccatalog_file_free(&cat->files[i]);
+	}
+	free(cat->files);
+	free(cat->by_content);
+	memset(cat, 0, sizeof(struct ltccatalog));
+	cat->fd = -1;
+}
+
+static int cmp_key_path(const void *key, const void *b) {
+	return strcmp((const char *) key, ((const struct ltccatalog_file *) b)->path);
+}
+
+/* the catalog's record of a path, as it was when the catalog was opened */
+const struct ltccatalog_file *ltccatalog_lookup(const struct ltccatalog *cat, const char *path) {
+	if (cat->n_files == 0) {
+		return NULL;
+	}
+	return bsearch(path, cat->files, cat->n_files, sizeof(struct ltccatalog_file), cmp_key_path);
+}
+
+/* the record of a file that was moved or renamed to cf->path: another path
+ * with the same size, mtime and fingerprint. mv(1) and cp -p keep the mtime,
+ * a file that was modified in place has a new one.
+ */
+const struct ltccatalog_file *ltccatalog_lookup_moved(const struct ltccatalog *cat, const struct ltccatalog_file *cf) {
+	uint32_t lo = 0, hi = cat->n_files;
+
+	/* first record that is not less than cf */
+	while (lo < hi) {
+		const uint32_t mid = lo + (hi - lo) / 2;
+		if (cmp_by_content(&cat->by_content[mid], &cf) < 0) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	for (; lo < cat->n_files && !cmp_by_content(&cat->by_content[lo], &cf); ++lo) {
+		if (strcmp(cat->by_content[lo]->path, cf->path)) {
+			return cat->by_content[lo];
+		}
+	}
+	return NULL;
+}
+
+/* append a record. The record is written at once, the caller serializes
+ * concurrent appends of its threads, the lock those of other processes. */
+int ltccatalog_append(struct ltccatalog *cat, const struct ltccatalog_file *cf) {
+	const size_t path_len = strlen(cf->path);
+	const size_t size = RECORD_SIZE + pad8(path_len) + (size_t) cf->n_runs * RUN_SIZE;
+	uint8_t *rec;
+	uint32_t i;
+	int rv = 0;
+
+	if (cat->fd < 0 || path_len == 0 || size > RECORD_MAX) {
+		return -1;
+	}
+
+	rec = calloc(1, size);
+	memcpy(rec, "FILE", 4);
+	wr_le(rec + 4, size, 4);
+	wr_le(rec + 8, cf->file_size, 8);
+	wr_le(rec + 16, cf->file_mtime, 8);
+	wr_le(rec + 24, cf->file_mtime_ns, 4);
+	wr_le(rec + 28, cf->samplerate, 4);
+	wr_le(rec + 32, cf->fingerprint, 8);
+	wr_le(rec + 40, cf->fps_num, 4);
+	wr_le(rec + 44, cf->fps_den, 4);
+	rec[48] = cf->drop;
+	rec[49] = cf->channel;
+	rec[50] = cf->status;
+	wr_le(rec + 52, cf->n_runs, 4);
+	wr_le(rec + 56, path_len, 4);
+	memcpy(rec + RECORD_SIZE, cf->path, path_len);
+
+	for (i = 0; i < cf->n_runs; ++i) {
+		uint8_t *p = rec + RECORD_SIZE + pad8(path_len) + i * RUN_SIZE;
+		const struct ltccatalog_run *r = &cf->runs[i];
+		wr_le(p, r->r.start_sample, 8);
+		wr_le(p + 8, r->r.end_sample, 8);
+		wr_le(p + 16, r->r.start_frame, 8);
+		wr_le(p + 24, r->r.n_frames, 4);
+		p[28] = r->r.fps;
+		p[29] = r->r.drop;
+		p[30] = r->r.reverse;
+		p[31] = r->r.end;
+		p[32] = r->year;
+		p[33] = r->month;
+		p[34] = r->day;
+	}
+
+	if (write_all(cat->fd, rec, size)) {
+		rv = -1;
+	}
+	free(rec);
+	++cat->n_records;
+	return rv;
+}
+
+/* record that a file was deleted */
+int ltccatalog_remove(struct ltccatalog *cat, const char *path) {
+	struct ltccatalog_file cf;
+	ltccatalog_file_init(&cf);
+	cf.path = (char *) path;
+	cf.status = LTCCATALOG_REMOVED;
+	return ltccatalog_append(cat, &cf);
+}
+
+/* does a run overlap the queried timecode range? */
+static int run_matches(const struct ltcindex_run *r, const struct ltccatalog_query *q) {
+	int64_t day, lo, hi, q0, q1;
+	int k;
+
+	if (q->any_tc) {
+		return 1;
+	}
+	if (r->fps == 0 || r->n_frames == 0) {
+		return 0;
+	}
+
+	day = smpte_to_framecnt(r->fps, r->drop, 24, 0, 0, 0);
+	lo = r->start_frame;
+	if (r->reverse) {
+		lo -= r->n_frames - 1;
+		if (lo < 0) lo += day;
+	}
+	hi = lo + r->n_frames - 1;
+
+	q0 = smpte_to_framecnt(r->fps, r->drop, q->from[0], q->from[1], q->from[2], q->from[3]);
+	q1 = smpte_to_framecnt(r->fps, r->drop, q->to[0], q->to[1], q->to[2], q->to[3]);
+	if (q1 < q0) q1 += day;
+
+	/* either one may wrap at midnight */
+	for (k = -1; k <= 1; ++k) {
+		if (lo + k * day <= q1 && hi + k * day >= q0) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/* find runs which overlap a timecode range on a given date.
+ * cb is called for every match, in path and file order, a non-zero
+ * return value stops the search. returns the number of matches.
+ */
+int ltccatalog_query(const struct ltccatalog *cat, const struct ltccatalog_query *q,
+		int (*cb)(void *arg, const struct ltccatalog_file *cf, const struct ltccatalog_run *run), void *arg) {
+	int found = 0;
+	uint32_t i, j;
+
+	for (i = 0; i < cat->n_files; ++i) {
+		const struct ltccatalog_file *cf = &cat->files[i];
+		if (cf->status != LTCCATALOG_OK) {
+			continue;
+		}
+		for (j = 0; j < cf->n_runs; ++j) {
+			const struct ltccatalog_run *r = &cf->runs[j];
+			if (q->year >= 0 && (r->year != q->year || r->month != q->month || r->day != q->day)) {
+				continue;
+			}
+			if (!run_matches(&r->r, q)) {
+				continue;
+			}
+			++found;
+			if (cb && cb(arg, cf, r)) {
+				return found;
+			}
+		}
+	}
+	return found;
+}
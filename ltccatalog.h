@@ -0,0 +1,85 @@
+#ifndef LTCCATALOG_H
+#define LTCCATALOG_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "ltcrun.h"
+#include "ltcindex.h"
+
+/* catalog of many audio-files: per file the LTC channel, framerate and
+ * the list of runs of continuous timecode, in a single append-only file.
+ * The latest record of a path replaces earlier ones.
+ */
+
+enum LTCCATALOG_STATUS {
+	LTCCATALOG_OK = 0,
+	LTCCATALOG_NO_LTC,     ///< decoded, but no timecode found
+	LTCCATALOG_UNREADABLE, ///< not an audio-file, or decoding failed
+	LTCCATALOG_REMOVED,    ///< the file no longer exists
+};
+
+struct ltccatalog_run {
+	struct ltcindex_run r;
+	uint8_t year;  ///< date of the first frame (SMPTE 309 user-bits), 0..99
+	uint8_t month;
+	uint8_t day;
+};
+
+struct ltccatalog_file {
+	char *path;
+	uint64_t file_size;
+	int64_t  file_mtime;
+	uint32_t file_mtime_ns;
+	uint64_t fingerprint;  ///< see ltccatalog_fingerprint()
+	uint32_t samplerate;
+	uint32_t fps_num;      ///< detected framerate, 0: unknown
+	uint32_t fps_den;
+	uint8_t  drop;
+	uint8_t  channel;      ///< audio-channel with LTC, first = 1
+	uint8_t  status;       ///< enum LTCCATALOG_STATUS
+
+	struct ltccatalog_run *runs; ///< in file order
+	uint32_t n_runs;
+	uint32_t n_alloc;
+
+	uint64_t seq;          ///< record-number in the catalog
+};
+
+struct ltccatalog {
+	int fd;  ///< open for appending and locked, -1: read-only
+	struct ltccatalog_file *files; ///< latest record of every path, sorted by path
+	struct ltccatalog_file **by_content; ///< the same, sorted by size, mtime and fingerprint
+	uint32_t n_files;
+	uint32_t n_alloc;
+	uint64_t n_records;
+};
+
+struct ltccatalog_query {
+	int any_tc;    ///< match every run, ignore from/to
+	int from[4];   ///< h, m, s, f
+	int to[4];     ///< inclusive, may be smaller than from (midnight)
+	int year;      ///< 0..99, -1: any date
+	int month;
+	int day;
+};
+
+void ltccatalog_file_init(struct ltccatalog_file *cf);
+void ltccatalog_file_free(struct ltccatalog_file *cf);
+void ltccatalog_file_add(struct ltccatalog_file *cf, const struct ltcrun *run);
+void ltccatalog_file_copy_runs(struct ltccatalog_file *cf, const struct ltccatalog_file *src);
+void ltccatalog_file_rate(struct ltccatalog_file *cf);
+
+int ltccatalog_stat(struct ltccatalog_file *cf, const char *path);
+int ltccatalog_fingerprint(struct ltccatalog_file *cf, const char *path);
+
+int ltccatalog_open(struct ltccatalog *cat, const char *path, int writable);
+void ltccatalog_close(struct ltccatalog *cat);
+const struct ltccatalog_file *ltccatalog_lookup(const struct ltccatalog *cat, const char *path);
+const struct ltccatalog_file *ltccatalog_lookup_moved(const struct ltccatalog *cat, const struct ltccatalog_file *cf);
+int ltccatalog_append(struct ltccatalog *cat, const struct ltccatalog_file *cf);
+int ltccatalog_remove(struct ltccatalog *cat, const char *path);
+
+int ltccatalog_query(const struct ltccatalog *cat, const struct ltccatalog_query *q,
+		int (*cb)(void *arg, const struct ltccatalog_file *cf, const struct ltccatalog_run *run), void *arg);
+
+#endif
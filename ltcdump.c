@@ -22,18 +22,36 @@
 #include <string.h>
 #include <math.h>
 #include <getopt.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
 #include <sndfile.h>
 #include <ltc.h>
 
+#include "bwf.h"
 #include "common_ltcdump.h"
+#include "decimate.h"
+#include "ltccatalog.h"
+#include "ltcfind.h"
+#include "ltcfollow.h"
 #include "ltcframeutil.h"
+#include "ltcindex.h"
+#include "ltcorigin.h"
+#include "ltcsource.h"
+#include "timecode.h"
+#include "sampleconv.h"
+#include "wavfile.h"
 
 #define FPRNT_TIME "%lf"
 #define TIME_DELIM	"\t"
 
 #define LTC_QUEUE_LENGTH 16
 
-#define BUFFER_SIZE 1024
+#define BUFFER_SIZE LTCSOURCE_BUFFER_SIZE
+#define BIN_OUTPUT_BUFFER (1 << 20)
 #define TIME_CODE_STRING_SIZE 12
 
 int print_audacity_labels = 0;
@@ -41,9 +59,96 @@ int detect_discontinuities = 1;
 int detect_framerate = 0;
 int verbosity = 1;
 int use_date = 0;
+int all_channels = 0;
+int n_jobs = 1;
+int use_mmap = 1;
+char *sidecar_suffix = NULL;
+int batch_mode = 0;
+int write_index = 0;
+int use_gate = 0;
+int use_decimation = 0;
+char *range_from = NULL;
+char *range_to = NULL;
+int follow = 0;
+int channel_auto = 0;
+sf_count_t read_blocksize = LTC_READAHEAD_DEFAULT_BLOCKSIZE; ///< --blocksize, for the read-ahead
+double gate_threshold = 0; ///< peak, in units of the 8 bit decoder input
+
+enum OUTPUT_FORMAT {
+	OUT_FRAMES = 0, ///< one line per LTC frame
+	OUT_SEGMENTS,   ///< one line per run of continuous timecode
+	OUT_BIN,        ///< binary frame-records, see common_ltcdump.h
+	OUT_NONE,       ///< only build the index
+};
+
+enum OUTPUT_FORMAT output_format = OUT_FRAMES;
+
+/* energy gate: skip decoding silent blocks */
+struct ltcgate {
+	int open;
+	long int hold;    ///< remaining hang-over, in samples
+	long int hangover;
+	int apv;
+	ltcsnd_sample_t preroll[BUFFER_SIZE];
+	size_t preroll_n;
+	ltc_off_t preroll_pos;
+};
+
+/* per audio-channel decoder state */
+struct ltcchannel {
+	int channel; ///< audio-channel, first = 1; 0: don't tag output
+	LTCDecoder *decoder;
+	LTCDiscontinuity disc;
+	LTCFpsDetector fps_detector;
+	int expected_fps;
+	int detect_fps; ///< detect the framerate, regardless of -F
+	LTCFrameExt fps_hold[2 * LTC_FPS_PERIOD_FRAMES]; ///< frames held back from the run-tracker until the framerate is known
+	int n_fps_hold; ///< -1: framerate is known
+	long int prev_read;
+	int track_runs;
+	struct ltcrun_tracker runs;
+	struct ltcindex *index; ///< NULL: don't index
+	struct ltccatalog_file *catalog; ///< NULL: not cataloguing
+	struct ltcgate gate;
+	struct decimator dec;
+	sf_count_t range_start; ///< only print frames starting in [range_start, range_end)
+	sf_count_t range_end;
+};
+
+/* reusable decoding context, one per thread */
+struct ltcdump_ctx {
+	ltcsnd_sample_t sound[BUFFER_SIZE];
+	float decimated[BUFFER_SIZE];
+	struct ltcsource_buf buf;
+	struct ltcchannel *chn;
+	int chn_alloc;
+	struct ltccatalog_file *catalog; ///< collect the runs of the next file
+};
+
+static void ctx_init(struct ltcdump_ctx *ctx) {
+	memset(ctx, 0, sizeof(struct ltcdump_ctx));
+}
+
+static void ctx_free(struct ltcdump_ctx *ctx) {
+	ltcsource_buf_free(&ctx->buf);
+	free(ctx->chn);
+	ctx_init(ctx);
+}
+
+static struct ltcchannel *ctx_channels(struct ltcdump_ctx *ctx, int n_chn) {
+	if (n_chn > ctx->chn_alloc) {
+		free(ctx->chn);
+		ctx->chn = malloc(n_chn * sizeof(struct ltcchannel));
+		ctx->chn_alloc = n_chn;
+	}
+	memset(ctx->chn, 0, n_chn * sizeof(struct ltcchannel));
+	return ctx->chn;
+}
 
 void print_header(FILE *outfile) {
 	fprintf(outfile, "#");
+	if (all_channels)
+		fprintf(outfile, "%-3s ", "Ch");
 	if (use_date)
 		fprintf(outfile, "%-10s %-5s ", "Date", "Zone");
 	else
@@ -51,192 +156,1950 @@ void print_header(FILE *outfile) {
 	fprintf(outfile, "%-10s | %17s\n", "Timecode", "Pos. (samples)");
 }
 
-void print_audacity_label(FILE *outfile, int samplerate, long int startInt, long int endInt, char *label) {
-	double start, end;
-	start = (double) startInt / samplerate;
-	end = (double) endInt / samplerate;
-	fprintf(outfile, "" FPRNT_TIME TIME_DELIM FPRNT_TIME TIME_DELIM "%s\n", start, end, label);
-}
+void print_audacity_label(FILE *outfile, int samplerate, long int startInt, long int endInt, char *label) {
+	double start, end;
+	start = (double) startInt / samplerate;
+	end = (double) endInt / samplerate;
+	fprintf(outfile, "" FPRNT_TIME TIME_DELIM FPRNT_TIME TIME_DELIM "%s\n", start, end, label);
+}
+
+void print_LTC_error(FILE *outfile, int samplerate, int chn, long int startInt, long int endInt, char *label) {
+	if (print_audacity_labels) {
+		if (chn > 0) {
+			char chnLabel[64];
+			snprintf(chnLabel, sizeof(chnLabel), "%d: %s", chn, label);
+			print_audacity_label(outfile, samplerate, startInt, endInt, chnLabel);
+		} else {
+			print_audacity_label(outfile, samplerate, startInt, endInt, label);
+		}
+	} else {
+		if (chn > 0)
+			fprintf(outfile, "%3d ", chn);
+		if (use_date)
+			fprintf(outfile, "%-16s ", "");
+		fprintf(outfile, "%-20s %8lu %8lu\n", label, startInt, endInt);
+	}
+}
+
+void print_LTC_info(FILE *outfile, int samplerate, int chn, LTCFrameExt frame, SMPTETimecode stime) {
+	if (print_audacity_labels) {
+		char timeCodeString[TIME_CODE_STRING_SIZE + 8];
+		if (chn > 0)
+			snprintf(timeCodeString, sizeof(timeCodeString),
+					 "%d: %02d:%02d:%02d:%02d", chn % 1000,
+					 stime.hours % 100, stime.mins % 100,
+					 stime.secs % 100, stime.frame % 100
+					 );
+		else
+			snprintf(timeCodeString, sizeof(timeCodeString),
+					 "%02d:%02d:%02d:%02d",
+					 stime.hours % 100, stime.mins % 100,
+					 stime.secs % 100, stime.frame % 100
+					 );
+		print_audacity_label(outfile, samplerate, frame.off_start, frame.off_end, timeCodeString);
+	} else {
+		if (chn > 0)
+			fprintf(outfile, "%3d ", chn);
+		if (use_date)
+			fprintf(outfile, "%04d-%02d-%02d %s ",
+				((stime.years < 67) ? 2000+stime.years : 1900+stime.years),
+				stime.months,
+				stime.days,
+				stime.timezone
+				);
+		else
+			print_user_bits(outfile, &frame.ltc);
+		fprintf(outfile, "%02d:%02d:%02d%c%02d | %8lld %8lld%s\n",
+				stime.hours,
+				stime.mins,
+				stime.secs,
+				(frame.ltc.dfbit) ? '.' : ':',
+				stime.frame,
+				frame.off_start,
+				frame.off_end,
+				frame.reverse ? " R" : "  "
+				);
+	}
+}
+
+void print_segment_header(FILE *outfile) {
+	fprintf(outfile, "#");
+	if (all_channels)
+		fprintf(outfile, "%-3s ", "Ch");
+	fprintf(outfile, "%-11s %-11s | %17s %17s %8s %s %s\n",
+			"Start", "End", "First sample", "Last sample", "Frames", "Dir", "End of run");
+}
+
+static const char *run_end_str(int end) {
+	switch (end) {
+		case LTCRUN_DISCONTINUITY: return "discontinuity";
+		case LTCRUN_DROPOUT: return "dropout";
+		default: return "eof";
+	}
+}
+
+void print_LTC_run(FILE *outfile, int samplerate, int chn, struct ltcrun *run) {
+	SMPTETimecode first, last;
+	ltc_frame_to_time(&first, &run->first.ltc, use_date);
+	ltc_frame_to_time(&last, &run->last.ltc, use_date);
+
+	if (print_audacity_labels) {
+		char label[64];
+		snprintf(label, sizeof(label), "%02d:%02d:%02d:%02d - %02d:%02d:%02d:%02d",
+				first.hours % 100, first.mins % 100, first.secs % 100, first.frame % 100,
+				last.hours % 100, last.mins % 100, last.secs % 100, last.frame % 100);
+		if (chn > 0) {
+			char chnLabel[80];
+			snprintf(chnLabel, sizeof(chnLabel), "%d: %s", chn % 1000, label);
+			print_audacity_label(outfile, samplerate, run->first.off_start, run->last.off_end, chnLabel);
+		} else {
+			print_audacity_label(outfile, samplerate, run->first.off_start, run->last.off_end, label);
+		}
+		return;
+	}
+
+	if (chn > 0)
+		fprintf(outfile, "%3d ", chn);
+	fprintf(outfile, "%02d:%02d:%02d%c%02d %02d:%02d:%02d%c%02d | %17lld %17lld %8u  %s  %s\n",
+			first.hours, first.mins, first.secs, (run->first.ltc.dfbit) ? '.' : ':', first.frame,
+			last.hours, last.mins, last.secs, (run->last.ltc.dfbit) ? '.' : ':', last.frame,
+			run->first.off_start,
+			run->last.off_end,
+			run->n_frames,
+			run->first.reverse ? "R" : "F",
+			run_end_str(run->end)
+			);
+}
+
+static void gate_init(struct ltcgate *g, int apv, long int ltc_frame_length_samples) {
+	memset(g, 0, sizeof(struct ltcgate));
+	g->apv = apv;
+	g->hangover = 2 * ltc_frame_length_samples;
+	g->open = 1;
+	g->hold = g->hangover;
+}
+
+/* write a block to the decoder unless the gate is closed.
+ *
+ * The gate opens when the peak of a block exceeds the threshold,
+ * and closes after a hang-over of two LTC frames. When it opens,
+ * the last silent block is written first, so that a frame starting
+ * at the edge of the signal is not lost, and the decoder is
+ * re-created to discard the partial frame from before the gap.
+ * The missing frames report is not affected: it is driven by the
+ * position of the last decoded frame.
+ */
+static void gate_decoder_write(struct ltcgate *g, LTCDecoder **decoder, ltcsnd_sample_t *sound, size_t n, ltc_off_t pos) {
+	int peak = 0;
+	size_t i;
+
+	if (!use_gate) {
+		ltc_decoder_write(*decoder, sound, n, pos);
+		return;
+	}
+
+	for (i = 0; i < n; ++i) {
+		const int v = abs((int)sound[i] - 128);
+		if (v > peak) peak = v;
+	}
+
+	if (peak >= gate_threshold) {
+		if (!g->open) {
+			ltc_decoder_free(*decoder);
+			*decoder = ltc_decoder_create(g->apv, LTC_QUEUE_LENGTH);
+			if (g->preroll_n > 0) {
+				ltc_decoder_write(*decoder, g->preroll, g->preroll_n, g->preroll_pos);
+			}
+			g->open = 1;
+		}
+		g->hold = g->hangover;
+	}
+	else if (g->open) {
+		g->hold -= n;
+		if (g->hold < 0) {
+			g->open = 0;
+		}
+	}
+
+	if (g->open) {
+		ltc_decoder_write(*decoder, sound, n, pos);
+	} else {
+		memcpy(g->preroll, sound, n * sizeof(ltcsnd_sample_t));
+		g->preroll_n = n;
+		g->preroll_pos = pos;
+	}
+}
+
+/* pass one channel of the current block to the decoder, decimated
+ * if the decimator is active. returns the number of samples written.
+ */
+static size_t decoder_write_block(struct ltcsource *src, int channel, struct decimator *dec, struct ltcgate *gate,
+		LTCDecoder **decoder, ltcsnd_sample_t *sound, float *decimated) {
+	if (dec->factor > 1) {
+		const int64_t pos = dec->out_pos;
+		size_t n;
+		ltcsource_channel_float(src, channel, decimated);
+		n = decimator_process(dec, decimated, decimated, src->n);
+		conv_float_trunc(sound, decimated, n, 1);
+		gate_decoder_write(gate, decoder, sound, n, pos);
+		return n;
+	}
+	ltcsource_channel(src, channel, sound);
+	gate_decoder_write(gate, decoder, sound, src->n, src->pos);
+	return src->n;
+}
+
+/* map frame positions from the decimated stream back to the file */
+static void frame_rescale(struct decimator *dec, LTCFrameExt *frame) {
+	if (dec->factor > 1) {
+		frame->off_start = decimator_input_pos(dec, frame->off_start);
+		frame->off_end = decimator_input_pos(dec, frame->off_end);
+	}
+}
+
+static void run_done(FILE *outfile, int samplerate, struct ltcchannel *lc, struct ltcrun *run) {
+	if (lc->index) {
+		ltcindex_add(lc->index, run);
+	}
+	if (lc->catalog) {
+		ltccatalog_file_add(lc->catalog, run);
+	}
+	if (output_format == OUT_SEGMENTS) {
+		print_LTC_run(outfile, samplerate, lc->channel, run);
+	}
+}
+
+static void runs_add(FILE *outfile, int samplerate, struct ltcchannel *lc, LTCFrameExt *frame) {
+	struct ltcrun run;
+	if (ltcrun_add(&lc->runs, frame, lc->expected_fps, &run)) {
+		run_done(outfile, samplerate, lc, &run);
+	}
+}
+
+/* pass the frames held back during framerate detection on to the run-tracker */
+static void runs_release(FILE *outfile, int samplerate, struct ltcchannel *lc) {
+	int i;
+	if (!lc->track_runs || lc->n_fps_hold < 0) {
+		return;
+	}
+	for (i = 0; i < lc->n_fps_hold; ++i) {
+		runs_add(outfile, samplerate, lc, &lc->fps_hold[i]);
+	}
+	lc->n_fps_hold = -1;
+}
+
+static void handle_frame(FILE *outfile, int samplerate, struct ltcchannel *lc, LTCFrameExt *frame, long int ltc_frame_length_samples) {
+	SMPTETimecode stime;
+
+	ltc_frame_to_time(&stime, &frame->ltc, use_date);
+
+	if (detect_framerate || lc->detect_fps) {
+		const int rv = fps_detector_add(&lc->fps_detector, &lc->expected_fps, frame, &stime,
+				(print_audacity_labels || output_format == OUT_BIN || !detect_framerate || lc->catalog) ? NULL : outfile);
+		if (rv & (LTC_FPS_MEASURED | LTC_FPS_CONFIRMED)) {
+			runs_release(outfile, samplerate, lc);
+		}
+	}
+
+	if (lc->track_runs) {
+		if (lc->detect_fps && lc->n_fps_hold >= 0) {
+			/* track runs at the detected framerate, not at -f */
+			memcpy(&lc->fps_hold[lc->n_fps_hold++], frame, sizeof(LTCFrameExt));
+			if (lc->n_fps_hold == sizeof(lc->fps_hold) / sizeof(LTCFrameExt)) {
+				runs_release(outfile, samplerate, lc);
+			}
+		} else {
+			runs_add(outfile, samplerate, lc, frame);
+		}
+	}
+
+	if (output_format == OUT_BIN) {
+		int flags = 0;
+		if (detect_discontinuities && lc->expected_fps > 0
+				&& discontinuity_add(&lc->disc, frame, lc->expected_fps)) {
+			flags |= LTCBIN_DISCONTINUITY;
+		}
+		ltcbin_write_frame(outfile, frame, flags, NULL, NULL);
+		return;
+	}
+
+	if (output_format != OUT_FRAMES) {
+		return;
+	}
+
+	if (detect_discontinuities && lc->expected_fps > 0) {
+		if (discontinuity_add(&lc->disc, frame, lc->expected_fps)) {
+			if (lc->channel > 0)
+				fprintf(outfile, "#DISCONTINUITY (channel %d)\n", lc->channel);
+			else
+				fprintf(outfile, "#DISCONTINUITY\n");
+		}
+	}
+
+	print_LTC_info(outfile, samplerate, lc->channel, *frame, stime);
+	lc->prev_read = frame->off_end;
+	if (frame->reverse) lc->prev_read += ltc_frame_length_samples;
+}
+
+static void check_missing_frames(FILE *outfile, int samplerate, struct ltcchannel *lc, long long int total, long int ltc_frame_length_samples) {
+	long int ltc_frame_length_fudge = (ltc_frame_length_samples * 101 / 100);
+	long int fudge = lc->prev_read + ltc_frame_length_fudge;
+	if (total > fudge) {
+		print_LTC_error(outfile, samplerate, lc->channel, lc->prev_read, lc->prev_read + ltc_frame_length_samples, "No LTC frame found");
+		lc->prev_read = total;
+	}
+}
+
+static void decode_frames(FILE *outfile, int samplerate, struct ltcchannel *lc, long int ltc_frame_length_samples) {
+	LTCFrameExt frame;
+
+	while (ltc_decoder_read(lc->decoder, &frame)) {
+		frame_rescale(&lc->dec, &frame);
+		if (frame.off_start < lc->range_start || frame.off_start >= lc->range_end) {
+			continue;
+		}
+		handle_frame(outfile, samplerate, lc, &frame, ltc_frame_length_samples);
+	}
+}
+
+#define RANGE_PREROLL_FRAMES 4 ///< decode this many frames before --from
+
+/* a decoded frame and the block that completed it.
+ * A serial run handles the frames of a block after the block's missing
+ * frames report, with the block the frames are replayed in that order. */
+struct ltcframe_blk {
+	LTCFrameExt frame;
+	sf_count_t blk; ///< file-position of the block that completed the frame
+};
+
+static void frames_blk_add(struct ltcframe_blk **frames, size_t *n, size_t *n_alloc, LTCFrameExt *frame, sf_count_t blk) {
+	if (*n == *n_alloc) {
+		*n_alloc = *n_alloc ? *n_alloc * 2 : 256;
+		*frames = realloc(*frames, *n_alloc * sizeof(struct ltcframe_blk));
+	}
+	memcpy(&(*frames)[*n].frame, frame, sizeof(LTCFrameExt));
+	(*frames)[(*n)++].blk = blk;
+}
+
+/* handle the frames completed by the block at blk, after the block's
+ * missing frames report, as a serial run does. returns the next frame */
+static size_t replay_block(FILE *outfile, int samplerate, struct ltcchannel *lc, struct ltcframe_blk *frames, size_t n_frames,
+		size_t f, sf_count_t blk, long int ltc_frame_length_samples, int print_missing_frame_info) {
+	if (print_missing_frame_info) {
+		check_missing_frames(outfile, samplerate, lc, blk, ltc_frame_length_samples);
+	}
+	for (; f < n_frames && frames[f].blk == blk; ++f) {
+		LTCFrameExt *frame = &frames[f].frame;
+		if (frame->off_start >= lc->range_start && frame->off_start < lc->range_end) {
+			handle_frame(outfile, samplerate, lc, frame, ltc_frame_length_samples);
+		}
+	}
+	return f;
+}
+
+/* parallel segmented decoding
+ *
+ * The file is split into segments which are decoded by worker-threads,
+ * each with its own sndfile handle and LTCDecoder. Segments start and
+ * end on the block-grid of a serial run and own the frames completed by
+ * their blocks, which removes duplicates. Every segment is decoded from
+ * an overlap before its start, long enough for the decoder to be in the
+ * state of a serial run when the segment starts.
+ * The main thread collects the segments in order, replays the blocks
+ * for the "No LTC frame found" report and runs the discontinuity and
+ * framerate detection over the merged stream.
+ */
+
+#define SEGMENT_MAX_LENGTH_SEC 60
+
+/* worst case until the decoder emits its first frame: it starts right
+ * after a sync word, and needs the rest of that frame, a complete one,
+ * and one more for the bit-period estimate to settle. Varispeed LTC
+ * down to SEGMENT_MIN_SPEED has longer frames. */
+#define SEGMENT_LOCK_FRAMES 3
+#define SEGMENT_MIN_SPEED 0.25
+
+struct ltcsegment {
+	sf_count_t start; ///< first block owned by this segment
+	sf_count_t end;   ///< first block owned by the next segment
+	struct ltcframe_blk *frames;
+	size_t n_frames;
+	size_t n_alloc;
+	int done;
+};
+
+struct ltcsegment_job {
+	const char *filename;
+	int channel; ///< first = 0
+	int apv;            ///< audio-frames per video-frame, at the decoder's rate
+	int dec_factor;
+	sf_count_t origin;  ///< start of a serial run, the block-grid and the decimator's phase are aligned to it
+	long int frame_length;
+	sf_count_t overlap;
+
+	struct ltcsegment *segments;
+	int n_segments;
+	int next_segment;   ///< next segment to be decoded
+	int next_output;    ///< next segment to be printed
+	int max_inflight;
+
+	pthread_mutex_t lock;
+	pthread_cond_t  cond;
+};
+
+static void decode_segment(struct ltcsource *src, struct ltcsegment_job *job, struct ltcsegment *seg,
+		ltcsnd_sample_t *sound, float *decimated) {
+	LTCDecoder *decoder;
+	LTCFrameExt frame;
+	struct ltcgate gate;
+	struct decimator dec;
+
+	/* read the same blocks and decimate the same samples as a serial run */
+	sf_count_t pos = seg->start - job->overlap;
+	if (pos < job->origin) pos = job->origin;
+	pos -= (pos - job->origin) % BUFFER_SIZE;
+	while ((pos - job->origin) % job->dec_factor) pos -= BUFFER_SIZE;
+
+	if (ltcsource_seek(src, pos)) {
+		return;
+	}
+	if (decimator_init(&dec, job->dec_factor)) {
+		return;
+	}
+	decimator_reset(&dec, pos);
+
+	decoder = ltc_decoder_create(job->apv, LTC_QUEUE_LENGTH);
+	gate_init(&gate, job->apv, job->frame_length / dec.factor);
+
+	while (src->pos + src->n < seg->end) {
+		sf_count_t n = seg->end - src->pos - src->n;
+		if (n > BUFFER_SIZE) n = BUFFER_SIZE;
+		if (ltcsource_read(src, n) <= 0) break;
+
+		decoder_write_block(src, job->channel, &dec, &gate, &decoder, sound, decimated);
+
+		while (ltc_decoder_read(decoder, &frame)) {
+			if (src->pos < seg->start) {
+				continue;
+			}
+			frame_rescale(&dec, &frame);
+			frames_blk_add(&seg->frames, &seg->n_frames, &seg->n_alloc, &frame, src->pos);
+		}
+	}
+	ltc_decoder_free(decoder);
+	decimator_free(&dec);
+}
+
+static void *segment_worker(void *arg) {
+	struct ltcsegment_job *job = (struct ltcsegment_job *) arg;
+	ltcsnd_sample_t sound[BUFFER_SIZE];
+	float decimated[BUFFER_SIZE];
+	struct ltcsource src;
+	int ok = !ltcsource_open(&src, job->filename, use_mmap, NULL);
+
+	pthread_mutex_lock(&job->lock);
+	while (job->next_segment < job->n_segments) {
+		struct ltcsegment *seg;
+		if (job->next_segment >= job->next_output + job->max_inflight) {
+			/* bound memory: wait for the main thread to catch up */
+			pthread_cond_wait(&job->cond, &job->lock);
+			continue;
+		}
+		seg = &job->segments[job->next_segment++];
+		pthread_mutex_unlock(&job->lock);
+
+		if (ok) {
+			decode_segment(&src, job, seg, sound, decimated);
+		}
+
+		pthread_mutex_lock(&job->lock);
+		seg->done = 1;
+		pthread_cond_broadcast(&job->cond);
+	}
+	pthread_mutex_unlock(&job->lock);
+
+	ltcsource_close(&src);
+	return NULL;
+}
+
+static void ltcdump_parallel(FILE *outfile, const char *filename, SF_INFO *sfinfo, struct ltcchannel *lc,
+		int channel, int apv, struct decimator *dec, sf_count_t seekpos, long int ltc_frame_length_samples, int print_missing_frame_info) {
+	struct ltcsegment_job job;
+	pthread_t *threads;
+	sf_count_t seglen;
+	/* as a serial run: from seekpos, a bit past the end to complete the last frame */
+	const sf_count_t start = seekpos;
+	sf_count_t end = lc->range_end + RANGE_PREROLL_FRAMES * ltc_frame_length_samples;
+	int i, n_threads;
+
+	if (end > sfinfo->frames) end = sfinfo->frames;
+
+	seglen = (end - start + n_jobs - 1) / n_jobs;
+	if (seglen > (sf_count_t) sfinfo->samplerate * SEGMENT_MAX_LENGTH_SEC) {
+		seglen = (sf_count_t) sfinfo->samplerate * SEGMENT_MAX_LENGTH_SEC;
+	}
+	/* align to the block-size of a serial run */
+	seglen = ((seglen + BUFFER_SIZE - 1) / BUFFER_SIZE) * BUFFER_SIZE;
+
+	memset(&job, 0, sizeof(job));
+	job.filename = filename;
+	job.channel = channel;
+	job.apv = apv;
+	job.dec_factor = dec->factor;
+	job.origin = start;
+	job.frame_length = ltc_frame_length_samples;
+	/* the decoder locks, the gate's hang-over and preroll block and
+	 * the decimator's filter see the same audio as in a serial run */
+	job.overlap = SEGMENT_LOCK_FRAMES / SEGMENT_MIN_SPEED * ltc_frame_length_samples
+		+ 2 * ltc_frame_length_samples + BUFFER_SIZE + dec->taps;
+	job.n_segments = (end - start + seglen - 1) / seglen;
+	job.max_inflight = 4 * n_jobs;
+	job.segments = calloc(job.n_segments, sizeof(struct ltcsegment));
+	for (i = 0; i < job.n_segments; ++i) {
+		job.segments[i].start = start + i * seglen;
+		job.segments[i].end = start + (i + 1) * seglen;
+		if (job.segments[i].end > end) job.segments[i].end = end;
+	}
+	pthread_mutex_init(&job.lock, NULL);
+	pthread_cond_init(&job.cond, NULL);
+
+	n_threads = n_jobs < job.n_segments ? n_jobs : job.n_segments;
+	threads = calloc(n_threads, sizeof(pthread_t));
+	for (i = 0; i < n_threads; ++i) {
+		if (pthread_create(&threads[i], NULL, segment_worker, &job)) {
+			fprintf(stderr, "Error: cannot create worker thread\n");
+			break;
+		}
+	}
+	n_threads = i;
+	if (n_threads == 0) {
+		/* decode in this thread, the output loop below won't block */
+		job.max_inflight = job.n_segments;
+		segment_worker(&job);
+	}
+
+	/* merge: print segments in order, replaying the blocks of a serial run */
+	for (i = 0; i < job.n_segments; ++i) {
+		struct ltcsegment *seg = &job.segments[i];
+		sf_count_t blk;
+		size_t f = 0;
+
+		pthread_mutex_lock(&job.lock);
+		while (!seg->done) {
+			pthread_cond_wait(&job.cond, &job.lock);
+		}
+		pthread_mutex_unlock(&job.lock);
+
+		for (blk = seg->start; blk < seg->end; blk += BUFFER_SIZE) {
+			f = replay_block(outfile, sfinfo->samplerate, lc, seg->frames, seg->n_frames, f, blk,
+					ltc_frame_length_samples, print_missing_frame_info);
+		}
+
+		free(seg->frames);
+		seg->frames = NULL;
+
+		pthread_mutex_lock(&job.lock);
+		job.next_output = i + 1;
+		pthread_cond_broadcast(&job.cond);
+		pthread_mutex_unlock(&job.lock);
+	}
+
+	for (i = 0; i < n_threads; ++i) {
+		pthread_join(threads[i], NULL);
+	}
+	free(threads);
+	free(job.segments);
+	pthread_mutex_destroy(&job.lock);
+	pthread_cond_destroy(&job.cond);
+}
+
+/* LTC channel detection
+ *
+ * Decode every channel of the first DETECT_SEC seconds of audible audio
+ * (at most DETECT_MAX_SEC seconds of the file) in one pass and rank the
+ * channels by the number of valid frames, i.e. frames that continue
+ * their predecessor, and by the peak signal level.
+ * The frames are kept, so that decoding can continue on the best channel
+ * without reading the file again.
+ */
+
+#define DETECT_SEC      10
+#define DETECT_MAX_SEC  300
+#define DETECT_SILENCE  2 ///< peak deviation of the 8 bit samples
+
+struct chnscore {
+	int channel;   ///< first = 0
+	int frames;
+	int valid;
+	int peak;      ///< 0..128
+	LTCDiscontinuity disc;
+	struct ltcframe_blk *buf;
+	size_t n_buf;
+	size_t n_alloc;
+};
+
+static int chnscore_cmp(const void *a, const void *b) {
+	const struct chnscore *sa = (const struct chnscore *) a;
+	const struct chnscore *sb = (const struct chnscore *) b;
+	if (sa->valid != sb->valid) return sb->valid - sa->valid;
+	if (sa->frames != sb->frames) return sb->frames - sa->frames;
+	if (sa->peak != sb->peak) return sb->peak - sa->peak;
+	return sa->channel - sb->channel;
+}
+
+/* read from the source's current position, up to end.
+ * The scores are sorted, best first.
+ */
+static void detect_channel(struct ltcsource *src, struct ltcchannel *chn, struct chnscore *score,
+		ltcsnd_sample_t *sound, float *decimated, sf_count_t end, int fps) {
+	const int n_chn = src->sfinfo.channels;
+	const sf_count_t audible_max = (sf_count_t) src->sfinfo.samplerate * DETECT_SEC;
+	const sf_count_t read_max = src->pos + src->n + (sf_count_t) src->sfinfo.samplerate * DETECT_MAX_SEC;
+	sf_count_t audible = 0;
+	int c;
+
+	for (c = 0; c < n_chn; ++c) {
+		memset(&score[c], 0, sizeof(struct chnscore));
+		score[c].channel = c;
+		discontinuity_init(&score[c].disc, 0, 1);
+	}
+
+	while (audible < audible_max && src->pos + src->n < end && src->pos + src->n < read_max
+			&& ltcsource_read(src, end - src->pos - src->n < BUFFER_SIZE ? end - src->pos - src->n : BUFFER_SIZE) > 0) {
+		int loud = 0;
+		for (c = 0; c < n_chn; ++c) {
+			struct ltcchannel *lc = &chn[c];
+			struct chnscore *sc = &score[c];
+			LTCFrameExt frame;
+			sf_count_t i, n;
+
+			n = decoder_write_block(src, c, &lc->dec, &lc->gate, &lc->decoder, sound, decimated);
+			for (i = 0; i < n; ++i) {
+				const int d = abs((int) sound[i] - 128);
+				if (d > sc->peak) sc->peak = d;
+				if (d >= DETECT_SILENCE) loud = 1;
+			}
+
+			while (ltc_decoder_read(lc->decoder, &frame)) {
+				frame_rescale(&lc->dec, &frame);
+				if (sc->frames++ > 0 && !discontinuity_add(&sc->disc, &frame, fps)) {
+					++sc->valid;
+				}
+				discontinuity_set(&sc->disc, &frame);
+				frames_blk_add(&sc->buf, &sc->n_buf, &sc->n_alloc, &frame, src->pos);
+			}
+		}
+		if (loud) {
+			audible += src->n;
+		}
+	}
+
+	qsort(score, n_chn, sizeof(struct chnscore), chnscore_cmp);
+}
+
+static void print_chnscore(FILE *outfile, struct chnscore *score, int n_chn) {
+	int c;
+	fprintf(outfile, "#%-3s %8s %8s %12s\n", "Ch", "Frames", "Valid", "Peak [dBFS]");
+	for (c = 0; c < n_chn; ++c) {
+		if (score[c].peak > 0) {
+			fprintf(outfile, "%4d %8d %8d %12.1f\n", score[c].channel + 1, score[c].frames, score[c].valid,
+					20.0 * log10(score[c].peak / 127.0));
+		} else {
+			fprintf(outfile, "%4d %8d %8d %12s\n", score[c].channel + 1, score[c].frames, score[c].valid, "-inf");
+		}
+	}
+}
+
+/* apv is given at the decoder's rate, i.e. after decimation by dec_factor */
+static void channel_init(struct ltcchannel *lc, int samplerate, int apv, int dec_factor, long int ltc_frame_length_samples,
+		int expected_fps, sf_count_t range_start, sf_count_t range_end) {
+	lc->decoder = ltc_decoder_create(apv, LTC_QUEUE_LENGTH);
+	lc->expected_fps = expected_fps;
+	lc->detect_fps = 0;
+	lc->n_fps_hold = 0;
+	discontinuity_init(&lc->disc, use_date, 0);
+	fps_detector_init(&lc->fps_detector, samplerate);
+	lc->prev_read = range_start + ltc_frame_length_samples;
+	lc->range_start = range_start;
+	lc->range_end = range_end;
+	lc->track_runs = write_index || output_format == OUT_SEGMENTS;
+	gate_init(&lc->gate, apv, ltc_frame_length_samples / dec_factor);
+	decimator_init(&lc->dec, dec_factor);
+	ltcrun_init(&lc->runs, ltc_frame_length_samples, use_date);
+}
+
+static void channel_free(struct ltcchannel *lc) {
+	ltc_decoder_free(lc->decoder);
+	decimator_free(&lc->dec);
+}
+
+/* print frames that were decoded ahead (by detect_channel),
+ * replaying the blocks of a serial run */
+static void replay_frames(FILE *outfile, int samplerate, struct ltcchannel *lc, struct ltcframe_blk *frames, size_t n_frames,
+		sf_count_t from, sf_count_t to, long int ltc_frame_length_samples, int print_missing_frame_info) {
+	sf_count_t blk;
+	size_t f = 0;
+
+	for (blk = from; blk < to; blk += BUFFER_SIZE) {
+		f = replay_block(outfile, samplerate, lc, frames, n_frames, f, blk, ltc_frame_length_samples, print_missing_frame_info);
+	}
+}
+
+static int range_position(struct ltcsource *src, ltcsnd_sample_t *sound, const char *arg,
+		int fps_num, int fps_den, int channel, sf_count_t *pos);
+
+int ltcdump(struct ltcdump_ctx *ctx, FILE *outfile, const char *filename, int fps_num, int fps_den, int channel) {
+	ltcsnd_sample_t *sound = ctx->sound;
+
+	struct ltcsource src;
+	SF_INFO sfinfo;
+
+	struct ltcchannel *chn;
+	struct ltcindex index;
+	int n_chn, c;
+	int apv, dec_factor;
+	int print_missing_frame_info;
+	sf_count_t range_start, range_end, seekpos;
+	struct ltcfollow fw = { NULL, 0, -1 };
+	struct ltcreadahead ra;
+
+	if (ltcsource_open(&src, filename, use_mmap, &ctx->buf)) {
+		fprintf(stderr, "Error: This is not a sndfile supported audio file format\n");
+		return -1;
+	}
+	sfinfo = src.sfinfo;
+
+	if (sfinfo.frames==0 && !follow) {
+		fprintf(stderr, "Error: This is an empty audio file\n");
+		ltcsource_close(&src);
+		return -1;
+	}
+
+	if (channel > sfinfo.channels) channel=sfinfo.channels;
+	if (channel < 1) channel=1;
+
+	if (sfinfo.channels!=1 && verbosity > 0 && !all_channels && !channel_auto) {
+		fprintf(stderr, "Note: This is not a mono audio file - using channel %i\n", channel);
+	}
+
+	long int ltc_frame_length_samples = sfinfo.samplerate * fps_den / fps_num;
+
+	range_start = 0;
+	range_end = sfinfo.frames;
+	if ((range_from || range_to) && !sfinfo.seekable) {
+		fprintf(stderr, "Error: --from/--to require a seekable audio file\n");
+		ltcsource_close(&src);
+		return -1;
+	}
+	if ((range_from && range_position(&src, sound, range_from, fps_num, fps_den, channel, &range_start))
+			|| (range_to && range_position(&src, sound, range_to, fps_num, fps_den, channel, &range_end))) {
+		ltcsource_close(&src);
+		return -1;
+	}
+	if (follow) {
+		range_end = INT64_MAX / 2;
+	} else if (range_end > sfinfo.frames) {
+		range_end = sfinfo.frames;
+	}
+	if (range_start >= range_end) {
+		fprintf(stderr, "Error: the given range is empty\n");
+		ltcsource_close(&src);
+		return -1;
+	}
+
+	/* start early enough for the decoder to lock to the first frame */
+	seekpos = range_start - RANGE_PREROLL_FRAMES * ltc_frame_length_samples;
+	if (seekpos < 0) seekpos = 0;
+	if (ltcsource_seek(&src, seekpos)) {
+		fprintf(stderr, "Error: cannot seek to sample %lld\n", (long long) seekpos);
+		ltcsource_close(&src);
+		return -1;
+	}
+
+	if (output_format != OUT_FRAMES) {
+		print_missing_frame_info = 0;
+	} else if (print_audacity_labels) {
+		print_missing_frame_info = 1;
+	} else {
+		print_missing_frame_info = (verbosity > 1);
+	}
+
+	if (verbosity > 1 && output_format != OUT_BIN) {
+		fprintf(outfile, "#SND: file = %s\n", filename);
+		if (all_channels)
+			fprintf(outfile, "#LTC: analyzed channels = 1..%d\n", sfinfo.channels);
+		else
+			fprintf(outfile, "#LTC: analyzed channel = %d\n", channel);
+		fprintf(outfile, "#SND: sample rate = %i\n", sfinfo.samplerate);
+		if (range_start > 0 || range_end < sfinfo.frames) {
+			fprintf(outfile, "#SND: range = %lld..%lld\n", (long long) range_start, (long long) range_end);
+		}
+	}
+
+	if (verbosity > 2 && output_format != OUT_BIN) {
+		fprintf(outfile, "#SND: reader = %s, %s\n", src.use_map ? "mmap" : "libsndfile", sampleconv_kernel());
+		fprintf(outfile, "#LTC: frames/sec = %i/%i\n", fps_num, fps_den);
+	}
+
+	if (!print_audacity_labels && output_format == OUT_FRAMES) {
+		print_header(outfile);
+	}
+	if (!print_audacity_labels && output_format == OUT_SEGMENTS) {
+		print_segment_header(outfile);
+	}
+	if (output_format == OUT_BIN) {
+		ltcbin_write_header(outfile, 0, sfinfo.samplerate, fps_num, fps_den);
+	}
+
+	/* the decoder runs at the decimated rate */
+	dec_factor = use_decimation ? decimator_factor(sfinfo.samplerate) : 1;
+	apv = sfinfo.samplerate * fps_den / fps_num / dec_factor;
+
+	if (verbosity > 2 && dec_factor > 1 && output_format != OUT_BIN) {
+		fprintf(outfile, "#SND: decimation = 1/%d\n", dec_factor);
+	}
+
+	/* all channels are fed from the same read-buffer */
+	n_chn = (all_channels || channel_auto) ? sfinfo.channels : 1;
+	chn = ctx_channels(ctx, n_chn);
+	for (c = 0; c < n_chn; ++c) {
+		chn[c].channel = all_channels ? c + 1 : 0;
+		channel_init(&chn[c], sfinfo.samplerate, apv, dec_factor, ltc_frame_length_samples,
+				ceil((double)fps_num/fps_den), // or -1
+				range_start, range_end);
+		decimator_reset(&chn[c].dec, seekpos);
+	}
+
+	if (write_index) {
+		ltcindex_init(&index);
+		ltcindex_stat(&index, filename);
+		index.samplerate = sfinfo.samplerate;
+		chn[0].index = &index;
+		/* index the runs at the detected framerate, not at -f */
+		for (c = 0; c < n_chn; ++c) {
+			chn[c].track_runs = 1;
+			chn[c].detect_fps = 1;
+		}
+	}
+
+	if (ctx->catalog) {
+		ctx->catalog->samplerate = sfinfo.samplerate;
+		ctx->catalog->channel = channel;
+		for (c = 0; c < n_chn; ++c) {
+			chn[c].catalog = ctx->catalog;
+			chn[c].track_runs = 1;
+			chn[c].detect_fps = 1;
+		}
+	}
+
+	if (channel_auto) {
+		struct chnscore *score = calloc(sfinfo.channels, sizeof(struct chnscore));
+		const int parallel = n_jobs > 1 && !batch_mode && !follow && sfinfo.seekable;
+		detect_channel(&src, chn, score, sound, ctx->decimated, range_end, chn[0].expected_fps);
+		channel = score[0].channel + 1;
+		if (verbosity > 1 && output_format != OUT_BIN) {
+			fprintf(outfile, "#LTC: detected channel = %d (%d frames)\n", channel, score[0].valid);
+		} else if (verbosity > 0 && !ctx->catalog) {
+			fprintf(stderr, "Note: using channel %d\n", channel);
+		}
+		if (score[0].frames == 0 && verbosity > 0 && !ctx->catalog) {
+			fprintf(stderr, "Note: no LTC found in the first %d seconds of audible audio\n", DETECT_SEC);
+		}
+		/* continue with the decoder of the detected channel */
+		for (c = 0; c < n_chn; ++c) {
+			if (c != channel - 1) {
+				channel_free(&chn[c]);
+			}
+		}
+		if (channel > 1) {
+			struct ltcindex *idx = chn[0].index;
+			memcpy(&chn[0], &chn[channel - 1], sizeof(struct ltcchannel));
+			chn[0].index = idx;
+		}
+		n_chn = 1;
+		if (ctx->catalog) {
+			ctx->catalog->channel = channel;
+		}
+		if (!parallel) {
+			replay_frames(outfile, sfinfo.samplerate, &chn[0], score[0].buf, score[0].n_buf,
+					seekpos, src.pos + src.n, ltc_frame_length_samples, print_missing_frame_info);
+		}
+		for (c = 0; c < sfinfo.channels; ++c) {
+			free(score[c].buf);
+		}
+		free(score);
+	}
+
+	/* in batch mode the jobs decode whole files */
+	if (n_jobs > 1 && !all_channels && !batch_mode && !follow && sfinfo.seekable) {
+		ltcdump_parallel(outfile, filename, &sfinfo, &chn[0], channel - 1,
+				apv, &chn[0].dec, seekpos, ltc_frame_length_samples, print_missing_frame_info);
+		goto out;
+	}
+
+	if (follow) {
+		ltcfollow_init(&fw, filename);
+	}
+
+	/* continue a bit past the end, to complete the last frame */
+	range_end += RANGE_PREROLL_FRAMES * ltc_frame_length_samples;
+	ra.wait = 0;
+	do {
+		if (ltcreadahead_start(&ra, &src, range_end, read_blocksize)) {
+			break;
+		}
+		while (src.pos + src.n < range_end
+				&& ltcreadahead_read(&ra, range_end - src.pos - src.n < BUFFER_SIZE ? range_end - src.pos - src.n : BUFFER_SIZE) > 0) {
+			for (c = 0; c < n_chn; ++c) {
+				struct ltcchannel *lc = &chn[c];
+				// channel-number starts counting at 1.
+				decoder_write_block(&src, all_channels ? c : channel - 1, &lc->dec, &lc->gate, &lc->decoder, sound, ctx->decimated);
+
+				if (print_missing_frame_info) {
+					check_missing_frames(outfile, sfinfo.samplerate, lc, src.pos, ltc_frame_length_samples);
+				}
+
+				decode_frames(outfile, sfinfo.samplerate, lc, ltc_frame_length_samples);
+			}
+		}
+		ltcreadahead_stop(&ra);
+		if (follow) {
+			fflush(outfile);
+		}
+		/* the decoder state is kept while waiting for new data */
+	} while (follow && !ltcfollow_wait(&fw, &src));
+
+	if (follow) {
+		ltcfollow_close(&fw);
+	}
+
+	if (verbosity > 2 && output_format != OUT_BIN) {
+		fprintf(outfile, "#SND: waited %.3f sec for I/O, block-size = %lld\n", ra.wait, (long long) read_blocksize);
+	}
+
+out:
+	for (c = 0; c < n_chn; ++c) {
+		struct ltcrun run;
+		runs_release(outfile, sfinfo.samplerate, &chn[c]);
+		if (chn[c].track_runs && ltcrun_flush(&chn[c].runs, &run)) {
+			run_done(outfile, sfinfo.samplerate, &chn[c], &run);
+		}
+		channel_free(&chn[c]);
+	}
+
+	if (write_index) {
+		char *path = malloc(strlen(filename) + strlen(LTCINDEX_SUFFIX) + 1);
+		sprintf(path, "%s%s", filename, LTCINDEX_SUFFIX);
+		if (ltcindex_write(&index, path)) {
+			fprintf(stderr, "Error: cannot write index '%s'\n", path);
+		} else if (verbosity > 1 && output_format != OUT_BIN) {
+			fprintf(outfile, "#IDX: %d runs written to %s\n", index.n_runs, path);
+		}
+		ltcindex_free(&index);
+		free(path);
+	}
+
+	ltcsource_close(&src);
+
+	return 0;
+}
+
+/* batch mode
+ *
+ * Decode many files in one process. A pool of worker threads, each with
+ * its own reusable context, takes files from the list. The result of
+ * every file is either written to a sidecar file, or collected in memory
+ * and printed to stdout in list-order, tagged with a "#FILE:" line.
+ */
+
+struct ltcbatch_file {
+	char *path;
+	char *result;
+	size_t result_len;
+	int rv;
+	int done;
+};
+
+struct ltcbatch {
+	struct ltcbatch_file *files;
+	int n_files;
+	int n_alloc;
+	int next_file;   ///< next file to be decoded
+	int next_output; ///< next file to be printed
+	int n_unreadable; ///< directories that could not be read
+	int max_inflight;
+
+	int fps_num;
+	int fps_den;
+	int channel;
+
+	pthread_mutex_t lock;
+	pthread_cond_t  cond;
+};
+
+static void batch_add(struct ltcbatch *b, const char *path) {
+	if (sidecar_suffix) {
+		/* don't decode our own output */
+		const size_t l = strlen(path);
+		const size_t ls = strlen(sidecar_suffix);
+		if (l > ls && !strcmp(path + l - ls, sidecar_suffix)) {
+			return;
+		}
+	}
+	if (b->n_files == b->n_alloc) {
+		b->n_alloc = b->n_alloc ? b->n_alloc * 2 : 64;
+		b->files = realloc(b->files, b->n_alloc * sizeof(struct ltcbatch_file));
+	}
+	memset(&b->files[b->n_files], 0, sizeof(struct ltcbatch_file));
+	b->files[b->n_files++].path = strdup(path);
+}
+
+static int batch_scan_dir(struct ltcbatch *b, const char *dir, int recursive) {
+	struct dirent **names;
+	struct stat st;
+	int i, n = scandir(dir, &names, NULL, alphasort);
+	if (n < 0) {
+		fprintf(stderr, "Error: cannot read directory '%s'\n", dir);
+		++b->n_unreadable;
+		return -1;
+	}
+	for (i = 0; i < n; ++i) {
+		char *path;
+		if (names[i]->d_name[0] != '.') {
+			path = malloc(strlen(dir) + strlen(names[i]->d_name) + 2);
+			sprintf(path, "%s/%s", dir, names[i]->d_name);
+			if (!stat(path, &st) && S_ISREG(st.st_mode)) {
+				batch_add(b, path);
+			} else if (recursive && !lstat(path, &st) && S_ISDIR(st.st_mode)) {
+				/* symlinked directories are not followed, no loops */
+				batch_scan_dir(b, path, recursive);
+			}
+			free(path);
+		}
+		free(names[i]);
+	}
+	free(names);
+	return 0;
+}
+
+/* collect regular files in a directory (and its sub-directories if recursive),
+ * or paths listed in a file (one per line) */
+static int batch_collect(struct ltcbatch *b, const char *src, int recursive) {
+	struct stat st;
+
+	if (stat(src, &st)) {
+		fprintf(stderr, "Error: cannot access '%s'\n", src);
+		return -1;
+	}
+
+	if (S_ISDIR(st.st_mode)) {
+		return batch_scan_dir(b, src, recursive);
+	} else {
+		char *line = NULL;
+		size_t len = 0;
+		ssize_t n;
+		FILE *f = fopen(src, "r");
+		if (!f) {
+			fprintf(stderr, "Error: cannot open list-file '%s'\n", src);
+			return -1;
+		}
+		while ((n = getline(&line, &len, f)) > 0) {
+			while (n > 0 && (line[n - 1] == '\n' || line[n - 1] == '\r')) {
+				line[--n] = '\0';
+			}
+			if (n == 0 || line[0] == '#') continue;
+			batch_add(b, line);
+		}
+		free(line);
+		fclose(f);
+	}
+	return 0;
+}
+
+static void *batch_worker(void *arg) {
+	struct ltcbatch *b = (struct ltcbatch *) arg;
+	struct ltcdump_ctx ctx;
+
+	ctx_init(&ctx);
+
+	pthread_mutex_lock(&b->lock);
+	while (b->next_file < b->n_files) {
+		struct ltcbatch_file *bf;
+		FILE *out;
+		if (b->next_file >= b->next_output + b->max_inflight) {
+			/* bound memory: wait for the main thread to catch up */
+			pthread_cond_wait(&b->cond, &b->lock);
+			continue;
+		}
+		bf = &b->files[b->next_file++];
+		pthread_mutex_unlock(&b->lock);
+
+		if (sidecar_suffix) {
+			char *path = malloc(strlen(bf->path) + strlen(sidecar_suffix) + 1);
+			sprintf(path, "%s%s", bf->path, sidecar_suffix);
+			out = fopen(path, "w");
+			if (out && output_format == OUT_BIN) {
+				setvbuf(out, NULL, _IOFBF, BIN_OUTPUT_BUFFER);
+			}
+			free(path);
+		} else {
+			out = open_memstream(&bf->result, &bf->result_len);
+		}
+
+		if (out) {
+			bf->rv = ltcdump(&ctx, out, bf->path, b->fps_num, b->fps_den, b->channel);
+			fclose(out);
+		} else {
+			bf->rv = -1;
+		}
+
+		pthread_mutex_lock(&b->lock);
+		bf->done = 1;
+		pthread_cond_broadcast(&b->cond);
+	}
+	pthread_mutex_unlock(&b->lock);
+
+	ctx_free(&ctx);
+	return NULL;
+}
+
+static int ltcdump_batch(const char *src, int fps_num, int fps_den, int channel) {
+	struct ltcbatch b;
+	pthread_t *threads;
+	int i, n_threads, n_err = 0;
+
+	batch_mode = 1;
+	memset(&b, 0, sizeof(struct ltcbatch));
+	if (batch_collect(&b, src, 0)) {
+		return -1;
+	}
+
+	b.fps_num = fps_num;
+	b.fps_den = fps_den;
+	b.channel = channel;
+	b.max_inflight = sidecar_suffix ? b.n_files : 4 * n_jobs;
+	pthread_mutex_init(&b.lock, NULL);
+	pthread_cond_init(&b.cond, NULL);
+
+	n_threads = n_jobs < b.n_files ? n_jobs : b.n_files;
+	threads = calloc(n_threads > 0 ? n_threads : 1, sizeof(pthread_t));
+	for (i = 0; i < n_threads; ++i) {
+		if (pthread_create(&threads[i], NULL, batch_worker, &b)) {
+			fprintf(stderr, "Error: cannot create worker thread\n");
+			break;
+		}
+	}
+	n_threads = i;
+	if (n_threads == 0) {
+		b.max_inflight = b.n_files;
+		batch_worker(&b);
+	}
+
+	for (i = 0; i < b.n_files; ++i) {
+		struct ltcbatch_file *bf = &b.files[i];
+
+		pthread_mutex_lock(&b.lock);
+		while (!bf->done) {
+			pthread_cond_wait(&b.cond, &b.lock);
+		}
+		pthread_mutex_unlock(&b.lock);
+
+		if (bf->rv) {
+			fprintf(stderr, "Error: failed to decode '%s'\n", bf->path);
+			++n_err;
+		}
+		if (!sidecar_suffix && bf->result) {
+			fprintf(stdout, "#FILE: %s\n", bf->path);
+			fwrite(bf->result, 1, bf->result_len, stdout);
+		}
+		free(bf->result);
+		free(bf->path);
+		bf->result = NULL;
+
+		pthread_mutex_lock(&b.lock);
+		b.next_output = i + 1;
+		pthread_cond_broadcast(&b.cond);
+		pthread_mutex_unlock(&b.lock);
+	}
+
+	for (i = 0; i < n_threads; ++i) {
+		pthread_join(threads[i], NULL);
+	}
+	free(threads);
+	free(b.files);
+	pthread_mutex_destroy(&b.lock);
+	pthread_cond_destroy(&b.cond);
+
+	return n_err ? -1 : 0;
+}
+
+/* catalog
+ *
+ * Record the LTC of all files below one or more directories in a single
+ * append-only catalog-file (see ltccatalog.c), using a pool of worker
+ * threads. Only new or modified files are decoded: files with unchanged
+ * size and mtime are skipped, a modified file is always decoded again.
+ * A new path with the size, mtime and fingerprint of a catalogued file
+ * is a file that was moved or renamed, the previous result is recorded
+ * for the new path. Files that were catalogued below a scanned
+ * directory, but are no longer found there, are recorded as removed.
+ * Queries are answered from the catalog alone.
+ */
+
+enum CATALOG_RESULT {
+	CATALOG_DECODED = 0,
+	CATALOG_UNCHANGED,  ///< same size and mtime, skipped
+	CATALOG_MOVED,      ///< moved or renamed, previous result
+};
+
+struct ltccatalog_scan {
+	struct ltcbatch b;     ///< list of files, lock and decoder settings
+	struct ltccatalog cat;
+	dev_t db_dev;          ///< the catalog-file itself is skipped
+	ino_t db_ino;
+	int n_decoded;
+	int n_moved;
+	int n_unchanged;
+	int n_removed;
+	int n_err;
+};
+
+static int catalog_file(struct ltccatalog_scan *cs, struct ltcdump_ctx *ctx, const char *path, struct ltccatalog_file *cf) {
+	const struct ltccatalog_file *prev = ltccatalog_lookup(&cs->cat, path);
+	struct ltcsource src;
+	struct stat st;
+
+	if (stat(path, &st) || ltccatalog_stat(cf, path)) {
+		return -1;
+	}
+	if (st.st_dev == cs->db_dev && st.st_ino == cs->db_ino) {
+		return CATALOG_UNCHANGED;
+	}
+	if (prev && prev->file_size == cf->file_size
+			&& prev->file_mtime == cf->file_mtime && prev->file_mtime_ns == cf->file_mtime_ns) {
+		return CATALOG_UNCHANGED;
+	}
+	if (ltccatalog_fingerprint(cf, path)) {
+		return -1;
+	}
+	cf->path = strdup(path);
+
+	/* the fingerprint only samples the file: a path that is already
+	 * catalogued is decoded again, whatever changed */
+	if (!prev) {
+		const struct ltccatalog_file *moved = ltccatalog_lookup_moved(&cs->cat, cf);
+		if (moved) {
+			ltccatalog_file_copy_runs(cf, moved);
+			return CATALOG_MOVED;
+		}
+	}
+
+	if (ltcsource_open(&src, path, use_mmap, &ctx->buf)) {
+		/* not audio, remember it anyway to skip it next time */
+		cf->status = LTCCATALOG_UNREADABLE;
+		return CATALOG_DECODED;
+	}
+	ltcsource_close(&src);
+
+	ctx->catalog = cf;
+	if (ltcdump(ctx, stdout, path, cs->b.fps_num, cs->b.fps_den, cs->b.channel)) {
+		cf->status = LTCCATALOG_UNREADABLE;
+		cf->n_runs = 0;
+	} else {
+		cf->status = cf->n_runs > 0 ? LTCCATALOG_OK : LTCCATALOG_NO_LTC;
+	}
+	ctx->catalog = NULL;
+	ltccatalog_file_rate(cf);
+	return CATALOG_DECODED;
+}
+
+static void *catalog_worker(void *arg) {
+	struct ltccatalog_scan *cs = (struct ltccatalog_scan *) arg;
+	struct ltcdump_ctx ctx;
+
+	ctx_init(&ctx);
+
+	pthread_mutex_lock(&cs->b.lock);
+	while (cs->b.next_file < cs->b.n_files) {
+		const char *path = cs->b.files[cs->b.next_file++].path;
+		struct ltccatalog_file cf;
+		int rv;
+		pthread_mutex_unlock(&cs->b.lock);
+
+		ltccatalog_file_init(&cf);
+		rv = catalog_file(cs, &ctx, path, &cf);
+
+		pthread_mutex_lock(&cs->b.lock);
+		if (rv < 0) {
+			fprintf(stderr, "Error: cannot read '%s'\n", path);
+			++cs->n_err;
+		} else if (rv == CATALOG_UNCHANGED) {
+			++cs->n_unchanged;
+		} else if (ltccatalog_append(&cs->cat, &cf)) {
+			fprintf(stderr, "Error: cannot add '%s' to the catalog\n", path);
+			++cs->n_err;
+		} else {
+			if (rv == CATALOG_MOVED) {
+				++cs->n_moved;
+			} else {
+				++cs->n_decoded;
+			}
+			if (verbosity > 1) {
+				fprintf(stdout, "#CAT: %s: %u runs%s\n", path, cf.n_runs, rv == CATALOG_MOVED ? " (moved)" : "");
+			}
+		}
+		ltccatalog_file_free(&cf);
+	}
+	pthread_mutex_unlock(&cs->b.lock);
+
+	ctx_free(&ctx);
+	return NULL;
+}
+
+static int cmp_batch_path(const void *a, const void *b) {
+	return strcmp(((const struct ltcbatch_file *) a)->path, ((const struct ltcbatch_file *) b)->path);
+}
+
+static int path_below(const char *path, const char *dir) {
+	const size_t l = strlen(dir);
+	return l > 0 && !strncmp(path, dir, l) && (dir[l - 1] == '/' || path[l] == '/');
+}
+
+/* record the files which are no longer found below the scanned directories */
+static void catalog_remove_missing(struct ltccatalog_scan *cs, char **dirs, int n_dirs) {
+	int *is_dir = calloc(n_dirs, sizeof(int));
+	uint32_t i;
+	int d;
+
+	for (d = 0; d < n_dirs; ++d) {
+		struct stat st;
+		is_dir[d] = !stat(dirs[d], &st) && S_ISDIR(st.st_mode);
+	}
+	qsort(cs->b.files, cs->b.n_files, sizeof(struct ltcbatch_file), cmp_batch_path);
+
+	for (i = 0; i < cs->cat.n_files; ++i) {
+		struct ltcbatch_file key;
+		int below = 0;
+		key.path = cs->cat.files[i].path;
+		for (d = 0; d < n_dirs && !below; ++d) {
+			below = is_dir[d] && path_below(key.path, dirs[d]);
+		}
+		if (!below || bsearch(&key, cs->b.files, cs->b.n_files, sizeof(struct ltcbatch_file), cmp_batch_path)) {
+			continue;
+		}
+		if (ltccatalog_remove(&cs->cat, key.path)) {
+			fprintf(stderr, "Error: cannot remove '%s' from the catalog\n", key.path);
+			++cs->n_err;
+		} else {
+			++cs->n_removed;
+			if (verbosity > 1) {
+				fprintf(stdout, "#CAT: %s: removed\n", key.path);
+			}
+		}
+	}
+	free(is_dir);
+}
+
+static int ltcdump_catalog(const char *db, char **dirs, int n_dirs, int fps_num, int fps_den, int channel) {
+	struct ltccatalog_scan cs;
+	struct stat st;
+	pthread_t *threads;
+	int i, n_threads;
+
+	batch_mode = 1;
+	memset(&cs, 0, sizeof(struct ltccatalog_scan));
+	if (ltccatalog_open(&cs.cat, db, 1)) {
+		fprintf(stderr, "Error: cannot open catalog '%s'\n", db);
+		return -1;
+	}
+	if (!stat(db, &st)) {
+		cs.db_dev = st.st_dev;
+		cs.db_ino = st.st_ino;
+	}
+
+	for (i = 0; i < n_dirs; ++i) {
+		if (batch_collect(&cs.b, dirs[i], 1)) {
+			cs.n_err = 1;
+			goto out;
+		}
+	}
+
+	cs.b.fps_num = fps_num;
+	cs.b.fps_den = fps_den;
+	cs.b.channel = channel;
+	pthread_mutex_init(&cs.b.lock, NULL);
+
+	n_threads = n_jobs < cs.b.n_files ? n_jobs : cs.b.n_files;
+	threads = calloc(n_threads > 0 ? n_threads : 1, sizeof(pthread_t));
+	for (i = 0; i < n_threads; ++i) {
+		if (pthread_create(&threads[i], NULL, catalog_worker, &cs)) {
+			fprintf(stderr, "Error: cannot create worker thread\n");
+			break;
+		}
+	}
+	n_threads = i;
+	if (n_threads == 0) {
+		catalog_worker(&cs);
+	}
+	for (i = 0; i < n_threads; ++i) {
+		pthread_join(threads[i], NULL);
+	}
+	free(threads);
+	pthread_mutex_destroy(&cs.b.lock);
+
+	/* a directory that could not be read is not evidence of deleted files */
+	if (cs.b.n_unreadable == 0) {
+		catalog_remove_missing(&cs, dirs, n_dirs);
+	}
+
+	if (verbosity > 0) {
+		fprintf(stderr, "Note: catalog '%s': %d files decoded, %d unchanged, %d moved, %d removed, %d errors\n",
+				db, cs.n_decoded, cs.n_unchanged, cs.n_moved, cs.n_removed, cs.n_err);
+	}
+
+out:
+	for (i = 0; i < cs.b.n_files; ++i) {
+		free(cs.b.files[i].path);
+	}
+	free(cs.b.files);
+	ltccatalog_close(&cs.cat);
+	return cs.n_err ? -1 : 0;
+}
+
+static int catalog_query_cb(void *arg, const struct ltccatalog_file *cf, const struct ltccatalog_run *run) {
+	const struct ltcindex_run *r = &run->r;
+	const int64_t day = smpte_to_framecnt(r->fps, r->drop, 24, 0, 0, 0);
+	int64_t last = r->reverse ? r->start_frame - (r->n_frames - 1) : r->start_frame + (r->n_frames - 1);
+	int h0, m0, s0, f0, h1, m1, s1, f1;
+	char date[16];
 
-void print_LTC_error(FILE *outfile, int samplerate, long int startInt, long int endInt, char *label) {
-	if (print_audacity_labels) {
-		print_audacity_label(outfile, samplerate, startInt, endInt, label);
+	last = ((last % day) + day) % day;
+	framecnt_to_smpte(r->fps, r->drop, r->start_frame, &h0, &m0, &s0, &f0);
+	framecnt_to_smpte(r->fps, r->drop, last, &h1, &m1, &s1, &f1);
+	if (run->month > 0) {
+		snprintf(date, sizeof(date), "%04d-%02d-%02d",
+				(run->year < 67) ? 2000 + run->year : 1900 + run->year, run->month, run->day);
 	} else {
-		if (use_date)
-			fprintf(outfile, "%-16s ", "");
-		fprintf(outfile, "%-20s %8lu %8lu\n", label, startInt, endInt);
+		snprintf(date, sizeof(date), "-");
 	}
+
+	printf("%02d:%02d:%02d%c%02d %02d:%02d:%02d%c%02d | %17lld %17lld %3d %6g %s %-10s %s\n",
+			h0, m0, s0, r->drop ? '.' : ':', f0,
+			h1, m1, s1, r->drop ? '.' : ':', f1,
+			(long long) r->start_sample, (long long) r->end_sample,
+			cf->channel, cf->fps_den ? (double) cf->fps_num / cf->fps_den : 0.0,
+			r->reverse ? "R" : "F", date, cf->path);
+	return 0;
 }
 
-void print_LTC_info(FILE *outfile, int samplerate, LTCFrameExt frame, SMPTETimecode stime) {
-	if (print_audacity_labels) {
-		char timeCodeString[TIME_CODE_STRING_SIZE];
-		snprintf(timeCodeString, TIME_CODE_STRING_SIZE,
-				 "%02d:%02d:%02d:%02d",
-				 stime.hours % 100, stime.mins % 100,
-				 stime.secs % 100, stime.frame % 100
-				 );
-		print_audacity_label(outfile, samplerate, frame.off_start, frame.off_end, timeCodeString);
-	} else {
-		if (use_date)
-			fprintf(outfile, "%04d-%02d-%02d %s ",
-				((stime.years < 67) ? 2000+stime.years : 1900+stime.years),
-				stime.months,
-				stime.days,
-				stime.timezone
-				);
-		else
-			print_user_bits(outfile, &frame.ltc);
-		fprintf(outfile, "%02d:%02d:%02d%c%02d | %8lld %8lld%s\n",
-				stime.hours,
-				stime.mins,
-				stime.secs,
-				(frame.ltc.dfbit) ? '.' : ':',
-				stime.frame,
-				frame.off_start,
-				frame.off_end,
-				frame.reverse ? " R" : "  "
-				);
+static int ltcdump_catalog_query(const char *db, const char *query, const char *date) {
+	struct ltccatalog cat;
+	struct ltccatalog_query q;
+	char sep[6][2];
+	int n;
+
+	memset(&q, 0, sizeof(struct ltccatalog_query));
+	q.year = -1;
+	if (!query) {
+		q.any_tc = 1;
+	} else if ((n = sscanf(query, "%d%1[:;.]%d%1[:;.]%d%1[:;.]%d-%d%1[:;.]%d%1[:;.]%d%1[:;.]%d",
+				&q.from[0], sep[0], &q.from[1], sep[1], &q.from[2], sep[2], &q.from[3],
+				&q.to[0], sep[3], &q.to[1], sep[4], &q.to[2], sep[5], &q.to[3])) == 7) {
+		memcpy(q.to, q.from, sizeof(q.to));
+	} else if (n != 14) {
+		fprintf(stderr, "Error: invalid query '%s', expected HH:MM:SS:FF[-HH:MM:SS:FF]\n", query);
+		return -1;
+	}
+	if (date) {
+		if (sscanf(date, "%d-%d-%d", &q.year, &q.month, &q.day) != 3) {
+			fprintf(stderr, "Error: invalid date '%s', expected YYYY-MM-DD\n", date);
+			return -1;
+		}
+		q.year %= 100;
+	}
+
+	if (ltccatalog_open(&cat, db, 0)) {
+		fprintf(stderr, "Error: cannot read catalog '%s'\n", db);
+		return -1;
 	}
+	printf("#%-11s %-11s | %17s %17s %3s %6s %s %-10s %s\n",
+			"Start", "End", "First sample", "Last sample", "Ch", "Fps", "D", "Date", "File");
+	n = ltccatalog_query(&cat, &q, catalog_query_cb, NULL);
+	ltccatalog_close(&cat);
+	return n > 0 ? 0 : 1;
 }
 
-int ltcdump(char *filename, int fps_num, int fps_den, int channel) {
-	ltcsnd_sample_t sound[BUFFER_SIZE];
-	float *interleaved = NULL;
-	FILE * outfile = stdout;
+/* index lookup
+ *
+ * Answer timecode -> sample and sample -> timecode queries from the
+ * index-file next to the audio-file. The audio is only decoded if the
+ * index is missing, or if size or mtime of the audio-file changed.
+ */
 
-	size_t n;
-	long long int total = 0;
-	int expected_fps = ceil((double)fps_num/fps_den); // or -1
+static void print_lookup(int fps, int drop, int64_t frame, int64_t sample, int reverse) {
+	int h, m, s, f;
+	framecnt_to_smpte(fps, drop, frame, &h, &m, &s, &f);
+	printf("%02d:%02d:%02d%c%02d | %8lld%s\n",
+			h, m, s, drop ? '.' : ':', f, (long long) sample, reverse ? " R" : "  ");
+}
 
-	SNDFILE * m_sndfile;
-	SF_INFO sfinfo;
+static int lookup_cb(void *arg, const struct ltcindex_run *run, int64_t sample) {
+	const int *tc = (const int *) arg;
+	print_lookup(run->fps, run->drop, smpte_to_framecnt(run->fps, run->drop, tc[0], tc[1], tc[2], tc[3]), sample, run->reverse);
+	return 0;
+}
 
-	LTCDecoder *decoder;
+static int ltcdump_lookup(const char *filename, char **queries, int n_queries, int fps_num, int fps_den, int channel) {
+	struct ltcindex index;
+	char *path;
+	int i, rv = 0;
+
+	path = malloc(strlen(filename) + strlen(LTCINDEX_SUFFIX) + 1);
+	sprintf(path, "%s%s", filename, LTCINDEX_SUFFIX);
+
+	if (ltcindex_read(&index, path) || !ltcindex_is_current(&index, filename)) {
+		struct ltcdump_ctx ctx;
+		ltcindex_free(&index);
+		if (verbosity > 0) {
+			fprintf(stderr, "Note: building index '%s'\n", path);
+		}
+		write_index = 1;
+		output_format = OUT_NONE;
+		verbosity = 0;
+		ctx_init(&ctx);
+		rv = ltcdump(&ctx, stdout, filename, fps_num, fps_den, channel);
+		ctx_free(&ctx);
+		if (rv || ltcindex_read(&index, path)) {
+			fprintf(stderr, "Error: cannot create index '%s'\n", path);
+			free(path);
+			return -1;
+		}
+	}
+	free(path);
+
+	for (i = 0; i < n_queries; ++i) {
+		int tc[4];
+		char sep[3][2];
+		if (sscanf(queries[i], "%d%1[:;.]%d%1[:;.]%d%1[:;.]%d",
+					&tc[0], sep[0], &tc[1], sep[1], &tc[2], sep[2], &tc[3]) == 7) {
+			if (!ltcindex_find_sample(&index, tc[0], tc[1], tc[2], tc[3], lookup_cb, tc)) {
+				fprintf(stderr, "Timecode %s not found\n", queries[i]);
+				rv = 1;
+			}
+		} else {
+			int64_t frame;
+			const int64_t sample = atoll(queries[i]);
+			const struct ltcindex_run *run = ltcindex_find_tc(&index, sample, &frame);
+			if (run) {
+				print_lookup(run->fps, run->drop, frame, sample, run->reverse);
+			} else {
+				fprintf(stderr, "No LTC at sample %s\n", queries[i]);
+				rv = 1;
+			}
+		}
+	}
+
+	ltcindex_free(&index);
+	return rv;
+}
+
+/* parse a --from/--to position: audio-frames, seconds ("1.5s")
+ * or the timecode HH:MM:SS:FF, which is located using ltcfind_tc().
+ * returns 0 on success.
+ */
+static int range_position(struct ltcsource *src, ltcsnd_sample_t *sound, const char *arg,
+		int fps_num, int fps_den, int channel, sf_count_t *pos) {
+	struct ltcfind fs;
 	LTCFrameExt frame;
-	int print_missing_frame_info;
+	int target[4];
+	char *end;
+	double sec;
 
-	m_sndfile = sf_open(filename, SFM_READ, &sfinfo);
+	if (!ltcfind_parse(target, arg)) {
+		ltcfind_init(&fs, src, sound, channel - 1, fps_num, fps_den);
+		if (ltcfind_tc(&fs, target, &frame)) {
+			fprintf(stderr, "Error: timecode %s not found\n", arg);
+			return -1;
+		}
+		*pos = frame.off_start;
+		return 0;
+	}
 
-	if (SF_ERR_NO_ERROR != sf_error( m_sndfile)) {
-		fprintf(stderr, "Error: This is not a sndfile supported audio file format\n");
-		return -1;
+	sec = strtod(arg, &end);
+	if (end != arg && !strcmp(end, "s") && sec >= 0) {
+		*pos = rint(sec * src->sfinfo.samplerate);
+		return 0;
 	}
-	if (sfinfo.frames==0) {
-		fprintf(stderr, "Error: This is an empty audio file\n");
+
+	*pos = strtoll(arg, &end, 10);
+	if (end == arg || *end || *pos < 0) {
+		fprintf(stderr, "Error: invalid position '%s', expected samples, seconds (e.g. 1.5s) or HH:MM:SS:FF\n", arg);
 		return -1;
 	}
+	return 0;
+}
 
-	if (channel > sfinfo.channels) channel=sfinfo.channels;
-	if (channel < 1) channel=1;
+static int ltcdump_find(struct ltcdump_ctx *ctx, FILE *outfile, const char *filename, const char *query, int fps_num, int fps_den, int channel) {
+	struct ltcfind fs;
+	struct ltcsource src;
+	LTCFrameExt frame;
+	SMPTETimecode stime;
+	int target[4];
+	int rv;
 
-	if (sfinfo.channels!=1 && verbosity > 0) {
-		fprintf(stderr, "Note: This is not a mono audio file - using channel %i\n", channel);
+	if (ltcfind_parse(target, query)) {
+		fprintf(stderr, "Error: invalid timecode '%s', expected HH:MM:SS:FF\n", query);
+		return -1;
 	}
 
-	interleaved=calloc(sfinfo.channels*BUFFER_SIZE, sizeof(float));
-
-	if (print_audacity_labels) {
-		verbosity = 0;
-		print_missing_frame_info = 1;
-	} else {
-		print_missing_frame_info = (verbosity > 1);
+	if (ltcsource_open(&src, filename, use_mmap, &ctx->buf)) {
+		fprintf(stderr, "Error: This is not a sndfile supported audio file format\n");
+		return -1;
+	}
+	if (src.sfinfo.frames == 0 || !src.sfinfo.seekable) {
+		fprintf(stderr, "Error: This is an empty or non-seekable audio file\n");
+		ltcsource_close(&src);
+		return -1;
 	}
+	if (channel > src.sfinfo.channels) channel = src.sfinfo.channels;
+	if (channel < 1) channel = 1;
+
+	ltcfind_init(&fs, &src, ctx->sound, channel - 1, fps_num, fps_den);
+	rv = ltcfind_tc(&fs, target, &frame);
 
 	if (verbosity > 1) {
-		fprintf(outfile, "#SND: file = %s\n", filename);
-		fprintf(outfile, "#LTC: analyzed channel = %d\n", channel);
-		fprintf(outfile, "#SND: sample rate = %i\n", sfinfo.samplerate);
+		fprintf(outfile, "#FIND: %d probes, %lld of %lld samples decoded\n",
+				fs.probes, (long long) fs.decoded, (long long) src.sfinfo.frames);
 	}
 
-	if (verbosity > 2) {
-		fprintf(outfile, "#LTC: frames/sec = %i/%i\n", fps_num, fps_den);
+	if (rv) {
+		fprintf(stderr, "Timecode %s not found\n", query);
+		ltcsource_close(&src);
+		return 1;
 	}
 
+	ltc_frame_to_time(&stime, &frame.ltc, use_date);
 	if (!print_audacity_labels) {
 		print_header(outfile);
 	}
+	print_LTC_info(outfile, src.sfinfo.samplerate, 0, frame, stime);
+	ltcsource_close(&src);
+	return 0;
+}
 
-	long int ltc_frame_length_samples = sfinfo.samplerate * fps_den / fps_num;
-	long int ltc_frame_length_fudge = (ltc_frame_length_samples * 101 / 100);
+/* decode until the fit of the timecode origin converges */
+static int origin_fit(struct ltcdump_ctx *ctx, FILE *outfile, const char *filename, int fps_num, int fps_den, int channel,
+		struct ltcorigin *o) {
+	struct ltcsource src;
+	int rv;
 
-	long int prev_read = ltc_frame_length_samples;
-	LTCFrameExt prev_frame;
+	if (ltcsource_open(&src, filename, use_mmap, &ctx->buf)) {
+		fprintf(stderr, "Error: This is not a sndfile supported audio file format\n");
+		return -1;
+	}
+	if (src.sfinfo.frames == 0) {
+		fprintf(stderr, "Error: This is an empty audio file\n");
+		ltcsource_close(&src);
+		return -1;
+	}
+	if (channel > src.sfinfo.channels) channel = src.sfinfo.channels;
+	if (channel < 1) channel = 1;
 
-	decoder = ltc_decoder_create(sfinfo.samplerate * fps_den / fps_num, LTC_QUEUE_LENGTH);
-	channel-=1; // channel-number starts counting at 1.
+	rv = ltcorigin_fit(&src, ctx->sound, channel - 1, fps_num, fps_den, o);
+	ltcsource_close(&src);
 
-	do {
-		int i;
-		n = sf_readf_float(m_sndfile, interleaved, BUFFER_SIZE);
-		for (i=0;i<n; i++)
-			sound[i]= 128 + interleaved[sfinfo.channels*i+channel] * 127;
-
-		ltc_decoder_write(decoder, sound, n, total);
-
-		if (print_missing_frame_info) {
-			long int fudge = prev_read + ltc_frame_length_fudge;
-			if (total > fudge) {
-				print_LTC_error(outfile, sfinfo.samplerate, prev_read, prev_read + ltc_frame_length_samples, "No LTC frame found");
-				prev_read = total;
-			}
+	if (verbosity > 1 && o->fps_num * fps_den != fps_num * o->fps_den) {
+		fprintf(outfile, "#LTC: detected fps = %d%s\n", o->fps, o->df ? "df" : "");
+	}
+	if (rv) {
+		fprintf(stderr, "Error: not enough continuous LTC to compute the origin\n");
+		if (o->n_reset > 0) {
+			fprintf(stderr, "Note: the timecode was not continuous at %d fps (%d jumps), try a different -f\n", o->fps, o->n_reset);
 		}
+		return 1;
+	}
+	if (verbosity > 1) {
+		fprintf(outfile, "#SND: %lld of %lld samples decoded\n",
+				(long long) o->decoded, (long long) src.sfinfo.frames);
+	}
+	return 0;
+}
+
+static void print_origin(FILE *outfile, struct ltcorigin *o) {
+	int h, m, s, f;
+	framecnt_to_smpte(o->fps, o->df, floor(o->x0), &h, &m, &s, &f);
+	fprintf(outfile, "#%-10s %9s %9s | %13s %6s | %6s\n", "Timecode", "+Frames", "+/-Smpl", "Drift [ppm]", "+/-", "Frames");
+	fprintf(outfile, "%02d:%02d:%02d%c%02d %9.4f %9.3f | %13.3f %6.3f | %6d\n",
+			h, m, s, o->df ? '.' : ':', f,
+			o->x0 - floor(o->x0), o->err,
+			o->drift, o->drift_err,
+			o->n_frames);
+}
 
-		while (ltc_decoder_read(decoder,&frame)) {
-			SMPTETimecode stime;
+static int ltcdump_origin(struct ltcdump_ctx *ctx, FILE *outfile, const char *filename, int fps_num, int fps_den, int channel) {
+	struct ltcorigin o;
+	int rv = origin_fit(ctx, outfile, filename, fps_num, fps_den, channel, &o);
+	if (rv) {
+		return rv;
+	}
+	if (!o.converged && verbosity > 0) {
+		fprintf(stderr, "Note: the fit did not converge, see the confidence intervals.\n");
+	}
+	print_origin(outfile, &o);
+	return 0;
+}
 
-			ltc_frame_to_time(&stime, &frame.ltc, use_date);
+/* write the origin to the bext TimeReference and iXML of the file */
+static int ltcdump_bwf(struct ltcdump_ctx *ctx, FILE *outfile, const char *filename, int fps_num, int fps_den, int channel, int dry_run) {
+	static const char *action[] = { "-", "update", "new (in JUNK)", "no room" };
+	struct ltcorigin o;
+	struct bwfinfo bi;
+	struct bwfplan plan;
+	int fd, rv;
 
-#if 0  // XXX
-			if (1) { // print start time referece in audio-samples
-				double off = frame_to_ms(&f, fps_num, fps_den);
-				off *= sfinfo.samplerate;
-				off /= 1000.0;
-				off -= frame.off_start;
-				printf("%f\n", off);
-				return 0;
-			}
-#endif
+	rv = origin_fit(ctx, outfile, filename, fps_num, fps_den, channel, &o);
+	if (rv) {
+		return rv;
+	}
+	print_origin(outfile, &o);
+	if (!o.converged) {
+		fprintf(stderr, "Error: the origin is not accurate enough, the file was not modified.\n");
+		return 1;
+	}
 
-			if (detect_framerate) {
-				detect_fps(&expected_fps, &frame, &stime, print_audacity_labels?NULL:outfile);
-			}
+	fps_num = o.fps_num;
+	fps_den = o.fps_den;
+	/* drop-frame timecode implies 29.97 fps */
+	if (o.df && fps_num == 30 * fps_den) {
+		fps_num = 30000;
+		fps_den = 1001;
+	}
+	memset(&bi, 0, sizeof(bi));
+	bi.time_reference = llrint(o.x0 * o.samplerate * fps_den / fps_num);
+	bi.samplerate = o.samplerate;
+	bi.fps_num = fps_num;
+	bi.fps_den = fps_den;
+	bi.drop = o.df;
+	bi.ixml = 1;
 
-			if (detect_discontinuities && expected_fps > 0) {
-				if (detect_discontinuity(&frame, &prev_frame, expected_fps, use_date, 0)) {
-					fprintf(outfile, "#DISCONTINUITY\n");
-				}
-			}
+	fd = open(filename, dry_run ? O_RDONLY : O_RDWR);
+	if (fd < 0) {
+		fprintf(stderr, "Error: cannot open '%s' for writing\n", filename);
+		return -1;
+	}
+
+	rv = bwf_plan(fd, &bi, &plan);
+	if (rv == BWF_ERR_NO_ROOM) {
+		fprintf(stderr, "Error: the file has no bext chunk and no JUNK chunk to hold one.\n");
+	} else if (rv) {
+		fprintf(stderr, "Error: cannot parse the RIFF header of '%s'\n", filename);
+	} else if (bwf_check(&plan, &bi)) {
+		fprintf(stderr, "Error: verification of the new header failed, the file was not modified.\n");
+		rv = BWF_ERR_VERIFY;
+	}
 
-			print_LTC_info(outfile, sfinfo.samplerate, frame, stime);
-			prev_read = frame.off_end;
-			if (frame.reverse) prev_read += ltc_frame_length_samples;
+	if (rv == BWF_OK) {
+		fprintf(outfile, "#BWF: TimeReference = %llu\n", (unsigned long long) bi.time_reference);
+		fprintf(outfile, "#BWF: bext: %s at %llu\n", action[plan.bext], (unsigned long long) plan.bext_offset);
+		if (plan.ixml == BWF_NO_ROOM) {
+			fprintf(outfile, "#BWF: iXML: %s\n", action[plan.ixml]);
+		} else {
+			fprintf(outfile, "#BWF: iXML: %s at %llu\n", action[plan.ixml], (unsigned long long) plan.ixml_offset);
+		}
+		if (dry_run) {
+			fprintf(outfile, "#BWF: dry-run, the file was not modified\n");
+		} else if ((rv = bwf_write(fd, &plan))) {
+			fprintf(stderr, "Error: writing the header failed%s\n", rv == BWF_ERR_VERIFY ? " (verification)" : "");
+		} else {
+			fprintf(outfile, "#BWF: header written and verified\n");
 		}
+	}
+
+	bwf_plan_free(&plan);
+	close(fd);
+	return rv ? 1 : 0;
+}
+
+static int ltcdump_detect(struct ltcdump_ctx *ctx, FILE *outfile, const char *filename, int fps_num, int fps_den) {
+	struct ltcsource src;
+	struct ltcchannel *chn;
+	struct chnscore *score;
+	int c, n_chn, apv;
+	long int ltc_frame_length_samples;
+
+	if (ltcsource_open(&src, filename, use_mmap, &ctx->buf)) {
+		fprintf(stderr, "Error: This is not a sndfile supported audio file format\n");
+		return -1;
+	}
+	if (src.sfinfo.frames == 0) {
+		fprintf(stderr, "Error: This is an empty audio file\n");
+		ltcsource_close(&src);
+		return -1;
+	}
 
-		total += n;
+	n_chn = src.sfinfo.channels;
+	ltc_frame_length_samples = src.sfinfo.samplerate * fps_den / fps_num;
+	apv = src.sfinfo.samplerate * fps_den / fps_num;
 
-	} while (n);
+	chn = ctx_channels(ctx, n_chn);
+	for (c = 0; c < n_chn; ++c) {
+		channel_init(&chn[c], src.sfinfo.samplerate, apv, 1, ltc_frame_length_samples, ceil((double)fps_num/fps_den),
+				0, src.sfinfo.frames);
+	}
+	score = calloc(n_chn, sizeof(struct chnscore));
+	detect_channel(&src, chn, score, ctx->sound, ctx->decimated, src.sfinfo.frames, chn[0].expected_fps);
 
-	sf_close(m_sndfile);
-	free(interleaved);
+	if (verbosity > 1) {
+		fprintf(outfile, "#SND: file = %s\n", filename);
+		fprintf(outfile, "#SND: %lld of %lld samples decoded\n",
+				(long long) (src.pos + src.n), (long long) src.sfinfo.frames);
+	}
+	print_chnscore(outfile, score, n_chn);
 
+	for (c = 0; c < n_chn; ++c) {
+		channel_free(&chn[c]);
+		free(score[c].buf);
+	}
+	free(score);
+	ltcsource_close(&src);
 	return 0;
 }
 
 static void usage (int status) {
 	printf ("ltcdump - parse linear time code from a audio-file.\n\n");
-	printf ("Usage: ltcdump [ OPTIONS ] <filename>\n\n");
+	printf ("Usage: ltcdump [ OPTIONS ] <filename>\n");
+	printf ("       ltcdump [ OPTIONS ] --batch <directory|list-file>\n");
+	printf ("       ltcdump [ OPTIONS ] --lookup <timecode|sample> <filename>\n");
+	printf ("       ltcdump [ OPTIONS ] --find <timecode> <filename>\n");
+	printf ("       ltcdump [ OPTIONS ] --origin <filename>\n");
+	printf ("       ltcdump [ OPTIONS ] --detect-channel <filename>\n");
+	printf ("       ltcdump [ OPTIONS ] --write-bwf [--dry-run] <filename>\n");
+	printf ("       ltcdump [ OPTIONS ] --catalog <catalog> [--query <tc>[-<tc>]] [--date <date>] [<directory|list-file> ...]\n\n");
 	printf ("Options:\n\
   -a                         write audacity label file-format\n\
+  -A, --all-channels         decode LTC from every audio-channel\n\
+  -b, --batch <path>         decode all files in a directory or list-file\n\
+  -B, --from <pos>           start decoding at the given position\n\
   -c, --channel <num>        decode LTC from given audio-channel (first = 1)\n\
+                             or 'auto' to use the channel with the best LTC\n\
+  -C, --detect-channel       rank the channels by LTC found in the first\n\
+                             10 seconds of audible audio, and exit\n\
   -d, --decodedate           decode date from LTC frame\n\
+  -D, --decimate             decimate high sample-rate input to <= 48kHz\n\
+                             before decoding\n\
+  -K, --catalog <catalog>    add all files below the given directories to\n\
+                             a catalog of their timecode, or query it\n\
+  -E, --to <pos>             stop decoding at the given position\n\
   -f, --fps  <num>[/den]     set expected [initial] framerate\n\
   -F, --detectfps            autodetect framerate from LTC (recommended)\n\
+  -w, --follow               keep decoding as the file grows (recording)\n\
+                             until interrupted\n\
+  -t, --find <timecode>      find the position of a timecode (HH:MM:SS:FF)\n\
+                             by decoding only a few short parts of the file\n\
+  -g, --gate <dBFS>          skip decoding blocks with a peak below <dBFS>\n\
   -h, --help                 display this help and exit\n\
+  -i, --index                write a timecode index to <filename>.ltcidx\n\
+  -j, --jobs <num>           decode the file in parallel using <num> threads\n\
+  -k, --blocksize <frames>   read the file in blocks of <frames> audio-frames\n\
+                             in a separate thread (default: 65536)\n\
+  -l, --lookup <query>       look up a timecode (HH:MM:SS:FF) or sample\n\
+                             position in the index, can be given repeatedly\n\
+  -M, --no-mmap              always read the file using libsndfile\n\
+  -n, --dry-run              with --write-bwf: verify, but do not modify\n\
+                             the file\n\
+  -O, --format <fmt>         output format: 'text' (default) or 'bin'\n\
+  -q, --query <tc>[-<tc>]    catalog: list the runs that contain a timecode\n\
+                             or overlap a range of timecode\n\
+  -R, --origin               compute the timecode at sample 0 and the clock\n\
+                             drift, decoding only as much as needed\n\
+  -s, --segments             print one line per run of continuous timecode\n\
+                             instead of one line per frame\n\
+  -S, --sidecar <suffix>     batch: write the result of each file to\n\
+                             <filename><suffix> instead of stdout\n\
   -V, --version              print version information and exit\n\
+  -W, --write-bwf            write the timecode at sample 0 (see --origin)\n\
+                             to the file's bext and iXML chunks, in place\n\
+  -Y, --date <YYYY-MM-DD>    catalog: only list runs recorded on that date\n\
 \n");
 	printf ("\n\
 Channel count starts at '1', which is also the default channel to analyze.\n\
+With --all-channels the file is read once and every channel is decoded,\n\
+each output line is prefixed with the channel number.\n\
+\n\
+--detect-channel decodes all channels of the first 10 seconds of audible\n\
+audio (at most 5 minutes of the file) and ranks them by the number of\n\
+valid LTC frames and the peak level. With '--channel auto' the best\n\
+channel is used and decoding continues where the detection stopped.\n\
+\n\
+PCM16, PCM24 and float32 WAV/RF64 files are memory-mapped and decoded\n\
+directly, other formats are read using libsndfile.\n\
+\n\
+With --jobs the file is split into segments that are decoded concurrently\n\
+and merged.\n\
+Otherwise the file is read by a separate thread, ahead of the decoder.\n\
+With -v -v -v the time the decoder waited for the disk is reported.\n\
+In batch mode --jobs sets the number of files that are decoded concurrently.\n\
+Unless --sidecar is given, the result of all files is written to stdout,\n\
+each one preceded by a '#FILE: <filename>' line. Batch mode decodes\n\
+(and optionally indexes) the files, it can not be combined with --find,\n\
+--origin, --write-bwf, --detect-channel or --lookup.\n\
+\n\
+With --segments each line holds the first and last timecode and sample\n\
+of a run, the number of frames, the direction (F/R) and why the run ended:\n\
+'discontinuity', 'dropout' (no LTC signal) or 'eof'.\n\
+\n\
+--from and --to limit decoding to a part of the file. The position is\n\
+given in samples, in seconds with an 's' suffix (e.g. 90.5s) or as\n\
+timecode HH:MM:SS:FF, which is located like --find does. Only frames that\n\
+start inside the range are printed, sample positions remain relative to\n\
+the start of the file.\n\
+\n\
+With --follow ltcdump decodes to the current end of the file and then\n\
+waits for the file to grow, e.g. while it is being recorded. The decoder\n\
+state is kept, the output is flushed after every read. Stop it with\n\
+Ctrl+C or SIGTERM.\n\
+\n\
+With --decimate 88.2kHz and higher rates are low-pass filtered and\n\
+decimated by an integer factor before decoding, the reported sample\n\
+positions refer to the original rate (within about one decimation step).\n\
+--find, --origin and --detect-channel always decode at the file's rate.\n\
+\n\
+The --gate option speeds up decoding of files with long silent gaps,\n\
+e.g. -g -40. Skipped gaps are reported like any other missing frames.\n\
+\n\
+--origin fits a line through the sample positions of continuous LTC frames\n\
+and stops as soon as the extrapolated start is known to about a sample.\n\
+It prints the timecode at sample 0 with the fractional frame, the\n\
+confidence interval in samples, the drift of the LTC relative to the\n\
+sample-clock (positive: the LTC is slow) and the number of frames used.\n\
+The framerate is measured from the frame length, -f only needs to tell\n\
+23.976 from 24 and 29.97 from 30 fps (drop-frame LTC implies 29.97).\n\
+\n\
+--write-bwf stores the origin as bext TimeReference (samples since\n\
+midnight) and in the iXML SPEED element. Only the header is modified:\n\
+an existing bext chunk is updated, otherwise it is created in the space\n\
+of a JUNK chunk. The new header is verified before and after writing.\n\
+\n\
+--catalog walks the given directories recursively (or reads list-files)\n\
+and appends the size, mtime, a content fingerprint, the LTC channel\n\
+(detected unless --channel is given), the framerate and the runs of\n\
+continuous timecode of every file to the catalog. Files with the same\n\
+size and mtime as in the last run are skipped, modified files are decoded\n\
+again. A new file with the size, mtime and fingerprint of a catalogued one\n\
+is taken as moved or renamed and not decoded. Files that were removed from a\n\
+scanned directory are dropped, --jobs sets the number of files decoded\n\
+concurrently. Only one scan at a time updates a catalog, a second one\n\
+waits for the first to finish. --query and --date are answered from the catalog\n\
+alone, the date is the one encoded in the user-bits (see --decodedate)\n\
+of the first frame of a run.\n\
+\n\
+The 'bin' format writes fixed-size little-endian frame-records,\n\
+use ltcbin2txt to convert them to text.\n\
+\n\
+The index holds one entry per run of continuous timecode. --lookup answers\n\
+queries from the index without reading the audio, the index is (re)built\n\
+automatically if it is missing or if the audio-file was modified.\n\
+The framerate of every run is detected from the LTC, regardless of -f.\n\
 \n\
 The fps option is only needed to properly track the first LTC frame,\n\
 and timecode discontinuity notification.\n\
@@ -251,33 +2114,93 @@ speeds up the initial sync process. The default is 25/1.\n\
 
 static struct option const long_options[] =
 {
+	{"gate", required_argument, 0, 'g'},
 	{"help", no_argument, 0, 'h'},
+	{"index", no_argument, 0, 'i'},
 	{"output", required_argument, 0, 'o'},
+	{"all-channels", no_argument, 0, 'A'},
+	{"batch", required_argument, 0, 'b'},
+	{"from", required_argument, 0, 'B'},
+	{"to", required_argument, 0, 'E'},
 	{"channel", required_argument, 0, 'c'},
+	{"detect-channel", no_argument, 0, 'C'},
+	{"decimate", no_argument, 0, 'D'},
 	{"decodedate", no_argument, 0, 'd'},
 	{"detectfps", no_argument, 0, 'F'},
+	{"catalog", required_argument, 0, 'K'},
+	{"date", required_argument, 0, 'Y'},
+	{"format", required_argument, 0, 'O'},
+	{"find", required_argument, 0, 't'},
 	{"fps", required_argument, 0, 'f'},
-	{"signals", no_argument, 0, 's'},
+	{"follow", no_argument, 0, 'w'},
+	{"jobs", required_argument, 0, 'j'},
+	{"blocksize", required_argument, 0, 'k'},
+	{"lookup", required_argument, 0, 'l'},
+	{"no-mmap", no_argument, 0, 'M'},
+	{"dry-run", no_argument, 0, 'n'},
+	{"query", required_argument, 0, 'q'},
+	{"origin", no_argument, 0, 'R'},
+	{"segments", no_argument, 0, 's'},
+	{"sidecar", required_argument, 0, 'S'},
 	{"verbose", no_argument, 0, 'v'},
 	{"version", no_argument, 0, 'V'},
+	{"write-bwf", no_argument, 0, 'W'},
 	{NULL, 0, NULL, 0}
 };
 
 int main(int argc, char **argv) {
+	struct ltcdump_ctx ctx;
 	char* filename;
+	char* batch = NULL;
+	char** lookup = NULL;
+	int n_lookup = 0;
+	int bin_format = 0;
+	char* find = NULL;
+	int origin = 0;
+	int write_bwf = 0;
+	int dry_run = 0;
+	int detect = 0;
+	char* catalog = NULL;
+	char* catalog_query = NULL;
+	char* catalog_date = NULL;
 	int channel = 1;
+	int channel_set = 0;
+	int rv;
 	int fps_num=25;
 	int fps_den=1;
 
 	int c;
 	while ((c = getopt_long (argc, argv,
 			   "a"
+			   "A"  /* all channels */
+			   "b:" /* batch */
+			   "B:" /* from */
 			   "c:" /* channel */
+			   "C"  /* detect channel */
 			   "d"
+			   "D"  /* decimate */
+			   "E:" /* to */
 			   "f:" /* fps */
 			   "F"	/* detect framerate */
+			   "g:" /* gate */
 			   "h"  /* help */
+			   "i"  /* index */
+			   "j:" /* jobs */
+			   "k:" /* read block-size */
+			   "K:" /* catalog */
+			   "l:" /* lookup */
+			   "M"  /* no mmap */
+			   "n"  /* dry run */
+			   "O:" /* output format */
+			   "q:" /* catalog query */
+			   "R"  /* origin */
+			   "s"  /* segments */
+			   "t:" /* find timecode */
+			   "S:" /* sidecar suffix */
 			   "v"  /* verbose */
+			   "w"  /* follow */
+			   "W"  /* write bwf */
+			   "Y:" /* catalog date */
 			   "V", /* version */
 			   long_options, (int *) 0)) != EOF)
 	{
@@ -287,16 +2210,45 @@ int main(int argc, char **argv) {
 				detect_discontinuities=0;
 				break;
 
+			case 'A':
+				all_channels=1;
+				break;
+
+			case 'b':
+				batch = optarg;
+				break;
+
+			case 'B':
+				range_from = optarg;
+				break;
+
+			case 'E':
+				range_to = optarg;
+				break;
+
 			case 'd':
 				use_date=1;
 				break;
 
+			case 'D':
+				use_decimation = 1;
+				break;
+
 			case 'F':
 				detect_framerate = 1;
 				break;
 
 			case 'c':
-				channel = atoi(optarg);
+				if (!strcmp(optarg, "auto")) {
+					channel_auto = 1;
+				} else {
+					channel = atoi(optarg);
+					channel_set = 1;
+				}
+				break;
+
+			case 'C':
+				detect = 1;
 				break;
 
 			case 'f':
@@ -307,10 +2259,91 @@ int main(int argc, char **argv) {
 				}
 				break;
 
+			case 'g':
+				use_gate = 1;
+				gate_threshold = 127.0 * pow(10.0, atof(optarg) / 20.0);
+				break;
+
+			case 'i':
+				write_index = 1;
+				break;
+
+			case 'l':
+				lookup = realloc(lookup, (n_lookup + 1) * sizeof(char*));
+				lookup[n_lookup++] = optarg;
+				break;
+
+			case 'j':
+				n_jobs = atoi(optarg);
+				if (n_jobs < 1) n_jobs = 1;
+				break;
+
+			case 'k':
+				read_blocksize = atoll(optarg);
+				/* a multiple of the decoder's block-size */
+				if (read_blocksize < BUFFER_SIZE) read_blocksize = BUFFER_SIZE;
+				read_blocksize = ((read_blocksize + BUFFER_SIZE - 1) / BUFFER_SIZE) * BUFFER_SIZE;
+				break;
+
+			case 'K':
+				catalog = optarg;
+				break;
+
+			case 'M':
+				use_mmap = 0;
+				break;
+
+			case 'n':
+				dry_run = 1;
+				break;
+
+			case 'O':
+				if (!strcmp(optarg, "bin")) {
+					bin_format = 1;
+				} else if (!strcmp(optarg, "text")) {
+					bin_format = 0;
+				} else {
+					fprintf(stderr, "Error: unknown output format '%s'.\n", optarg);
+					usage (EXIT_FAILURE);
+				}
+				break;
+
+			case 'q':
+				catalog_query = optarg;
+				break;
+
+			case 'R':
+				origin = 1;
+				break;
+
+			case 's':
+				output_format = OUT_SEGMENTS;
+				break;
+
+			case 't':
+				find = optarg;
+				break;
+
+			case 'S':
+				sidecar_suffix = optarg;
+				break;
+
 			case 'v':
 				verbosity++;
 				break;
 
+			case 'w':
+				follow = 1;
+				break;
+
+			case 'W':
+				write_bwf = 1;
+				break;
+
+			case 'Y':
+				catalog_date = optarg;
+				break;
+
 			case 'V':
 				printf ("ltcdump version %s\n\n", VERSION);
 				printf ("Copyright (C) GPL 2006,2012 Robin Gareus <robin@gareus.org>\n");
@@ -324,11 +2357,139 @@ int main(int argc, char **argv) {
 		}
 	}
 
-	if (optind >= argc) {
+	if (optind >= argc && !batch && !catalog) {
 		usage (EXIT_FAILURE);
 	}
 
+	if ((catalog_query || catalog_date) && !catalog) {
+		fprintf(stderr, "Error: --query and --date require --catalog.\n");
+		return -1;
+	}
+
+	if (print_audacity_labels) {
+		verbosity = 0;
+	}
+
+	if (write_bwf) {
+		/* --write-bwf writes the result of --origin */
+		origin = 1;
+	}
+
+	sampleconv_init();
+
+	if (bin_format) {
+		if (output_format == OUT_SEGMENTS || print_audacity_labels || all_channels) {
+			fprintf(stderr, "Error: --format=bin can not be combined with -a, --segments or --all-channels.\n");
+			return -1;
+		}
+		if (batch && !sidecar_suffix) {
+			fprintf(stderr, "Error: --format=bin requires --sidecar in batch mode.\n");
+			return -1;
+		}
+		output_format = OUT_BIN;
+		setvbuf(stdout, NULL, _IOFBF, BIN_OUTPUT_BUFFER);
+	}
+
+	if (write_index && all_channels) {
+		fprintf(stderr, "Error: --index can not be combined with --all-channels.\n");
+		return -1;
+	}
+
+	if ((range_from || range_to) && (write_index || find || origin || n_lookup > 0)) {
+		fprintf(stderr, "Error: --from/--to can not be combined with --index, --find, --origin or --lookup.\n");
+		return -1;
+	}
+
+	if (follow && (batch || range_to || write_index || find || origin || n_lookup > 0)) {
+		fprintf(stderr, "Error: --follow can not be combined with --batch, --to, --index, --find, --origin or --lookup.\n");
+		return -1;
+	}
+
+	if (batch && (find || origin || detect || n_lookup > 0)) {
+		fprintf(stderr, "Error: --batch can not be combined with --find, --origin, --write-bwf, --detect-channel or --lookup.\n");
+		return -1;
+	}
+
+	if (catalog) {
+		if (batch || all_channels || find || origin || detect || follow || write_index || n_lookup > 0
+				|| range_from || range_to || bin_format || print_audacity_labels || output_format != OUT_FRAMES) {
+			fprintf(stderr, "Error: --catalog can not be combined with other modes or output formats.\n");
+			return -1;
+		}
+		if (!channel_set) {
+			channel_auto = 1;
+		}
+		output_format = OUT_NONE;
+		rv = 0;
+		if (optind < argc) {
+			rv = ltcdump_catalog(catalog, &argv[optind], argc - optind, fps_num, fps_den, channel);
+		}
+		if (!rv && (catalog_query || catalog_date || optind >= argc)) {
+			rv = ltcdump_catalog_query(catalog, catalog_query, catalog_date);
+		}
+		return rv;
+	}
+
+	if (batch) {
+		return ltcdump_batch(batch, fps_num, fps_den, channel);
+	}
+
+	if (all_channels && n_jobs > 1 && verbosity > 0) {
+		fprintf(stderr, "Note: --jobs is not supported with --all-channels, decoding serially.\n");
+	}
+
 	filename = argv[optind];
 
-	return ltcdump(filename, fps_num, fps_den, channel);
+	if (channel_auto && (all_channels || find || origin)) {
+		fprintf(stderr, "Error: --channel auto can not be combined with --all-channels, --find or --origin.\n");
+		return -1;
+	}
+
+	if (find) {
+		if (all_channels || output_format != OUT_FRAMES) {
+			fprintf(stderr, "Error: --find can not be combined with --all-channels, --segments or --format.\n");
+			return -1;
+		}
+		ctx_init(&ctx);
+		rv = ltcdump_find(&ctx, stdout, filename, find, fps_num, fps_den, channel);
+		ctx_free(&ctx);
+		return rv;
+	}
+
+	if (detect) {
+		ctx_init(&ctx);
+		rv = ltcdump_detect(&ctx, stdout, filename, fps_num, fps_den);
+		ctx_free(&ctx);
+		return rv;
+	}
+
+	if (origin) {
+		if (all_channels || output_format != OUT_FRAMES || print_audacity_labels) {
+			fprintf(stderr, "Error: --origin can not be combined with -a, --all-channels, --segments or --format.\n");
+			return -1;
+		}
+		ctx_init(&ctx);
+		if (write_bwf) {
+			rv = ltcdump_bwf(&ctx, stdout, filename, fps_num, fps_den, channel, dry_run);
+		} else {
+			rv = ltcdump_origin(&ctx, stdout, filename, fps_num, fps_den, channel);
+		}
+		ctx_free(&ctx);
+		return rv;
+	}
+
+	if (n_lookup > 0) {
+		if (all_channels) {
+			fprintf(stderr, "Error: --lookup can not be combined with --all-channels.\n");
+			return -1;
+		}
+		rv = ltcdump_lookup(filename, lookup, n_lookup, fps_num, fps_den, channel);
+		free(lookup);
+		return rv;
+	}
+
+	ctx_init(&ctx);
+	rv = ltcdump(&ctx, stdout, filename, fps_num, fps_den, channel);
+	ctx_free(&ctx);
+	return rv;
 }
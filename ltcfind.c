@@ -0,0 +1,259 @@
+/* locate a timecode in a file without decoding all of it
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Find a timecode without decoding the whole file: the first and last
+ * LTC are located by probing inward from either end in growing steps,
+ * then decode short windows at a few positions and interpolate
+ * (regula falsi) towards the target, using bisection if a probe is
+ * inconsistent with the bracket.
+ * Once the target is close, or if the timecode is not monotonic,
+ * the remaining range is scanned linearly. A target outside the
+ * bracket is only looked for where the timecode extrapolates to.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "ltcfind.h"
+#include "ltcframeutil.h"
+#include "timecode.h"
+
+#define LTCFIND_QUEUE_LENGTH 16
+
+#define FIND_PROBE_SEC    0.5 ///< length of a probe window
+#define FIND_EDGE_SEC     2   ///< length of a probe window at either end
+#define FIND_EDGE_GAP_SEC 30  ///< max. gap between those, shorter LTC may be missed
+#define FIND_SCAN_SEC     10  ///< scan linearly below this bracket size
+#define FIND_MAX_PROBES   48  ///< not counting the probes at either end
+#define FIND_MAX_DRIFT    0.01 ///< of the LTC, when extrapolating beyond the bracket
+
+struct findpoint {
+	LTCFrameExt frame;
+	long long int fcnt;
+};
+
+/* decode from pos to end, stop at the first frame that continues its predecessor */
+static int find_probe(struct ltcfind *fs, sf_count_t pos, sf_count_t len, struct findpoint *p) {
+	LTCDecoder *decoder;
+	LTCFrameExt frame, prev;
+	int n_frames = 0;
+	int found = 0;
+	sf_count_t end = pos + len;
+
+	if (pos < 0) pos = 0;
+	if (end > fs->src->sfinfo.frames) end = fs->src->sfinfo.frames;
+	if (ltcsource_seek(fs->src, pos)) {
+		return -1;
+	}
+	++fs->probes;
+
+	decoder = ltc_decoder_create(fs->apv, LTCFIND_QUEUE_LENGTH);
+	while (!found && fs->src->pos + fs->src->n < end) {
+		sf_count_t n = end - fs->src->pos - fs->src->n;
+		if (n > LTCSOURCE_BUFFER_SIZE) n = LTCSOURCE_BUFFER_SIZE;
+		if (ltcsource_read(fs->src, n) <= 0) break;
+		ltcsource_channel(fs->src, fs->channel, fs->sound);
+		ltc_decoder_write(decoder, fs->sound, fs->src->n, fs->src->pos);
+		fs->decoded += fs->src->n;
+
+		while (!found && ltc_decoder_read(decoder, &frame)) {
+			if (n_frames++ > 0 && !frame.reverse && !detect_discontinuity(&frame, &prev, fs->fps, 0, 0)) {
+				memcpy(&p->frame, &frame, sizeof(LTCFrameExt));
+				p->fcnt = ltcframe_to_framecnt(&frame.ltc, fs->fps_exact);
+				found = 1;
+			}
+			memcpy(&prev, &frame, sizeof(LTCFrameExt));
+		}
+	}
+	ltc_decoder_free(decoder);
+	return found ? 0 : -1;
+}
+
+/* decode [from, to) and return the frame with the target timecode */
+static int find_scan(struct ltcfind *fs, sf_count_t from, sf_count_t to, LTCFrameExt *result) {
+	LTCDecoder *decoder;
+	LTCFrameExt frame;
+	int found = 0;
+
+	if (from < 0) from = 0;
+	if (to > fs->src->sfinfo.frames) to = fs->src->sfinfo.frames;
+	if (ltcsource_seek(fs->src, from)) {
+		return -1;
+	}
+
+	decoder = ltc_decoder_create(fs->apv, LTCFIND_QUEUE_LENGTH);
+	while (!found && fs->src->pos + fs->src->n < to) {
+		sf_count_t n = to - fs->src->pos - fs->src->n;
+		if (n > LTCSOURCE_BUFFER_SIZE) n = LTCSOURCE_BUFFER_SIZE;
+		if (ltcsource_read(fs->src, n) <= 0) break;
+		ltcsource_channel(fs->src, fs->channel, fs->sound);
+		ltc_decoder_write(decoder, fs->sound, fs->src->n, fs->src->pos);
+		fs->decoded += fs->src->n;
+
+		while (!found && ltc_decoder_read(decoder, &frame)) {
+			SMPTETimecode st;
+			ltc_frame_to_time(&st, &frame.ltc, 0);
+			if (st.hours == fs->target[0] && st.mins == fs->target[1]
+					&& st.secs == fs->target[2] && st.frame == fs->target[3]) {
+				memcpy(result, &frame, sizeof(LTCFrameExt));
+				found = 1;
+			}
+		}
+	}
+	ltc_decoder_free(decoder);
+	return found ? 0 : -1;
+}
+
+/* probe inward from the start (or from the end, down to limit) of the
+ * file, with gaps that double after every probe, until continuous LTC
+ * is found. Pre-roll or trailing silence costs a few probes, not a full
+ * decode.
+ */
+static int find_edge(struct ltcfind *fs, int from_end, sf_count_t limit, struct findpoint *p) {
+	const sf_count_t total = fs->src->sfinfo.frames;
+	const sf_count_t len = (sf_count_t) fs->src->sfinfo.samplerate * FIND_EDGE_SEC;
+	const sf_count_t max_gap = (sf_count_t) fs->src->sfinfo.samplerate * FIND_EDGE_GAP_SEC;
+	sf_count_t off = 0;
+	sf_count_t gap = len;
+
+	while (off < total - limit) {
+		const sf_count_t pos = from_end ? total - off - len : off;
+		if (!find_probe(fs, pos < limit ? limit : pos, len, p)) {
+			return 0;
+		}
+		off += len + gap;
+		gap = 2 * gap < max_gap ? 2 * gap : max_gap;
+	}
+	return -1;
+}
+
+/* the target is outside the bracket: scan where the timecode of the
+ * nearest lock extrapolates to, with some allowance for drift */
+static int find_extrapolate(struct ltcfind *fs, struct findpoint *p, long long int t, LTCFrameExt *result) {
+	const long int frame_len = fs->apv;
+	const sf_count_t dist = llabs(t - p->fcnt) * frame_len;
+	const sf_count_t margin = 4 * frame_len + dist * FIND_MAX_DRIFT;
+
+	if ((t < p->fcnt && p->frame.off_start - dist + margin < 0)
+			|| (t > p->fcnt && p->frame.off_start + dist - margin > fs->src->sfinfo.frames)) {
+		/* not in the file */
+		return -1;
+	}
+	if (t < p->fcnt) {
+		return find_scan(fs, p->frame.off_start - dist - margin, p->frame.off_end + frame_len, result);
+	}
+	return find_scan(fs, p->frame.off_start - frame_len, p->frame.off_end + dist + margin, result);
+}
+
+/* returns 0 if tc is a timecode HH:MM:SS:FF */
+int ltcfind_parse(int target[4], const char *tc) {
+	char sep[3][2];
+	return sscanf(tc, "%d%1[:;.]%d%1[:;.]%d%1[:;.]%d",
+			&target[0], sep[0], &target[1], sep[1], &target[2], sep[2], &target[3]) == 7 ? 0 : -1;
+}
+
+/* search the given channel (first = 0) of src, which must be seekable */
+void ltcfind_init(struct ltcfind *fs, struct ltcsource *src, ltcsnd_sample_t *sound, int channel, int fps_num, int fps_den) {
+	memset(fs, 0, sizeof(struct ltcfind));
+	fs->src = src;
+	fs->sound = sound;
+	fs->channel = channel;
+	fs->apv = src->sfinfo.samplerate * fps_den / fps_num;
+	fs->fps = ceil((double)fps_num / fps_den);
+	fs->fps_exact = (double)fps_num / fps_den;
+}
+
+/* returns 0 if the target timecode (h, m, s, f) was found */
+int ltcfind_tc(struct ltcfind *fs, const int target[4], LTCFrameExt *result) {
+	const sf_count_t window = fs->src->sfinfo.samplerate * FIND_PROBE_SEC;
+	const sf_count_t scan_limit = (sf_count_t) fs->src->sfinfo.samplerate * FIND_SCAN_SEC;
+	const long int frame_len = fs->apv;
+	struct findpoint lo, hi, p;
+	long long int t;
+	int bisect = 0;
+	int edge_probes;
+
+	memcpy(fs->target, target, sizeof(fs->target));
+	if (find_edge(fs, 0, 0, &lo)) {
+		/* no LTC in the file */
+		return -1;
+	}
+	if (find_edge(fs, 1, lo.frame.off_end, &hi)) {
+		/* the only LTC is around the first lock */
+		memcpy(&hi, &lo, sizeof(struct findpoint));
+	}
+	edge_probes = fs->probes;
+
+	t = bcd_to_framecnt(fs->fps_exact, lo.frame.ltc.dfbit, fs->target[3], fs->target[2], fs->target[1], fs->target[0]);
+	if (t < lo.fcnt) {
+		/* before the first lock, or not in the file */
+		return find_extrapolate(fs, &lo, t, result);
+	}
+	if (t > hi.fcnt) {
+		return find_extrapolate(fs, &hi, t, result);
+	}
+
+	while (fs->probes - edge_probes < FIND_MAX_PROBES) {
+		sf_count_t est;
+
+		if (hi.frame.off_start - lo.frame.off_start < scan_limit) {
+			break;
+		}
+
+		if (bisect) {
+			est = (lo.frame.off_start + hi.frame.off_start) / 2;
+		} else {
+			est = lo.frame.off_start + (double)(t - lo.fcnt) * (hi.frame.off_start - lo.frame.off_start) / (hi.fcnt - lo.fcnt);
+		}
+		est -= 2 * frame_len;
+		if (est <= lo.frame.off_start) est = lo.frame.off_start + frame_len;
+
+		if (find_probe(fs, est, window, &p)) {
+			if (bisect) break;
+			bisect = 1;
+			continue;
+		}
+
+		if (p.fcnt < lo.fcnt || p.fcnt > hi.fcnt
+				|| p.frame.off_start <= lo.frame.off_start || p.frame.off_start >= hi.frame.off_start) {
+			/* discontinuity: the bracket is not linear */
+			if (bisect) break;
+			bisect = 1;
+			continue;
+		}
+		bisect = 0;
+
+		if (llabs(p.fcnt - t) <= 2 * fs->fps) {
+			/* close: scan locally around the expected position */
+			const sf_count_t expect = p.frame.off_start + (t - p.fcnt) * frame_len;
+			const sf_count_t from = (expect < p.frame.off_start ? expect : p.frame.off_start) - 4 * frame_len;
+			const sf_count_t to = (expect > p.frame.off_end ? expect : p.frame.off_end) + 4 * frame_len;
+			if (!find_scan(fs, from, to, result)) {
+				return 0;
+			}
+		}
+
+		if (p.fcnt < t) {
+			memcpy(&lo, &p, sizeof(struct findpoint));
+		} else {
+			memcpy(&hi, &p, sizeof(struct findpoint));
+		}
+	}
+
+	/* local linear scan of the remaining bracket */
+	return find_scan(fs, lo.frame.off_start - frame_len, hi.frame.off_end + frame_len, result);
+}
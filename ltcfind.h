@@ -0,0 +1,24 @@
+#ifndef LTCFIND_H
+#define LTCFIND_H
+
+#include <ltc.h>
+#include "ltcsource.h"
+
+/* timecode search, see ltcfind.c */
+struct ltcfind {
+	struct ltcsource *src;
+	ltcsnd_sample_t *sound;  ///< LTCSOURCE_BUFFER_SIZE samples
+	int channel;            ///< first = 0
+	int apv;
+	int fps;                ///< nominal, for detect_discontinuity()
+	double fps_exact;
+	int target[4];          ///< h, m, s, f
+	sf_count_t decoded;     ///< total number of samples decoded
+	int probes;
+};
+
+int ltcfind_parse(int target[4], const char *tc);
+void ltcfind_init(struct ltcfind *fs, struct ltcsource *src, ltcsnd_sample_t *sound, int channel, int fps_num, int fps_den);
+int ltcfind_tc(struct ltcfind *fs, const int target[4], LTCFrameExt *result);
+
+#endif
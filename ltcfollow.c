@@ -0,0 +1,112 @@
+/* wait for a file that is being recorded to grow
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* inotify is used where available, the timeout covers file-systems
+ * that do not report changes (e.g. network shares).
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "ltcfollow.h"
+
+#ifdef __linux__
+#define HAVE_INOTIFY
+#include <sys/inotify.h>
+#endif
+
+static volatile sig_atomic_t follow_stop = 0;
+
+static void follow_signal(int sig) {
+	follow_stop = 1;
+}
+
+/* SIGINT and SIGTERM interrupt ltcfollow_wait(), the caller finishes the output */
+void ltcfollow_init(struct ltcfollow *fw, const char *filename) {
+	struct stat st;
+	struct sigaction sa;
+
+	fw->filename = filename;
+	fw->size = stat(filename, &st) ? 0 : st.st_size;
+	fw->fd = -1;
+#ifdef HAVE_INOTIFY
+	fw->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (fw->fd >= 0 && inotify_add_watch(fw->fd, filename, IN_MODIFY | IN_CLOSE_WRITE) < 0) {
+		close(fw->fd);
+		fw->fd = -1;
+	}
+#endif
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = follow_signal;
+	sigemptyset(&sa.sa_mask);
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+}
+
+void ltcfollow_close(struct ltcfollow *fw) {
+	if (fw->fd >= 0) {
+		close(fw->fd);
+	}
+	fw->fd = -1;
+}
+
+/* block until the file has grown beyond the current read position,
+ * then re-open it to pick up the new length.
+ * returns 0 if there is new data, -1 on error or if interrupted.
+ */
+int ltcfollow_wait(struct ltcfollow *fw, struct ltcsource *src) {
+	const sf_count_t next = src->pos + src->n;
+	struct stat st;
+
+	while (!follow_stop) {
+		if (fw->fd >= 0) {
+			struct pollfd pfd;
+			char buf[1024];
+			pfd.fd = fw->fd;
+			pfd.events = POLLIN;
+			if (poll(&pfd, 1, LTCFOLLOW_POLL_MS) > 0) {
+				while (read(fw->fd, buf, sizeof(buf)) > 0) ;
+			}
+		} else {
+			usleep(LTCFOLLOW_POLL_MS * 1000);
+		}
+
+		if (follow_stop || stat(fw->filename, &st) || st.st_size == fw->size) {
+			continue;
+		}
+		if (st.st_size < fw->size) {
+			fprintf(stderr, "Error: the file was truncated\n");
+			return -1;
+		}
+		fw->size = st.st_size;
+
+		if (ltcsource_reopen(src, fw->filename)) {
+			/* the header may not be complete yet */
+			continue;
+		}
+		if (src->sfinfo.frames > next && !ltcsource_seek(src, next)) {
+			return 0;
+		}
+		/* keep the position for the next attempt */
+		src->pos = next;
+		src->n = 0;
+	}
+	return -1;
+}
@@ -0,0 +1,21 @@
+#ifndef LTCFOLLOW_H
+#define LTCFOLLOW_H
+
+#include <sys/types.h>
+#include "ltcsource.h"
+
+/* follow mode: wait for a file that is being recorded to grow */
+
+#define LTCFOLLOW_POLL_MS 500
+
+struct ltcfollow {
+	const char *filename;
+	off_t size;
+	int fd; ///< inotify, -1 if not available
+};
+
+void ltcfollow_init(struct ltcfollow *fw, const char *filename);
+void ltcfollow_close(struct ltcfollow *fw);
+int ltcfollow_wait(struct ltcfollow *fw, struct ltcsource *src);
+
+#endif
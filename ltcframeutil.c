@@ -16,6 +16,7 @@
  */
 
 #include <string.h>
+#include <math.h>
 #include "ltcframeutil.h"
 
 /* what:
@@ -85,33 +86,114 @@ int detect_discontinuity(LTCFrameExt *frame, LTCFrameExt *prev, int fps, int use
     return discontinuity_detected;
 }
 
-int detect_fps(int *fps, LTCFrameExt *frame, SMPTETimecode *stime, FILE *output) {
+/* a zero-filled LTCDiscontinuity is a tracker with use_date = fuzzyfps = 0 */
+void discontinuity_init(LTCDiscontinuity *t, int use_date, int fuzzyfps) {
+  memset(t, 0, sizeof(LTCDiscontinuity));
+  t->use_date = use_date;
+  t->fuzzyfps = fuzzyfps;
+}
+
+/* returns 1 if the frame does not follow the previous one */
+int discontinuity_add(LTCDiscontinuity *t, LTCFrameExt *frame, int fps) {
+  return detect_discontinuity(frame, &t->prev, fps, t->use_date, t->fuzzyfps);
+}
+
+/* restart the comparison at the given frame */
+void discontinuity_set(LTCDiscontinuity *t, LTCFrameExt *frame) {
+  memcpy(&t->prev, frame, sizeof(LTCFrameExt));
+}
+
+/* samplerate: of the frame's off_start/off_end, 0 to disable the
+ * detection from the frame period */
+void fps_detector_init(LTCFpsDetector *d, int samplerate) {
+  memset(d, 0, sizeof(LTCFpsDetector));
+  discontinuity_init(&d->disc, 0, 1);
+  d->samplerate = samplerate;
+}
+
+/* measure the framerate from the audio-length of the last few frames.
+ * This locks after LTC_FPS_PERIOD_FRAMES frames, long before a frame-number
+ * rollover is seen, but it can not tell 23.976 from 24 or 29.97 from 30 fps,
+ * nor work with varispeed. Those are left to the rollover detection.
+ */
+static int fps_from_period(LTCFpsDetector *d, int *fps, LTCFrameExt *frame, FILE *output) {
+  static const int rates[3] = { 24, 25, 30 };
+  const double len = fabs((double)(frame->off_end - frame->off_start)) + 1;
+  double avg = 0, rate;
+  int i, nominal = 0;
+
+  if (d->n_period == LTC_FPS_PERIOD_FRAMES) {
+    memmove(d->period, d->period + 1, (LTC_FPS_PERIOD_FRAMES - 1) * sizeof(double));
+    --d->n_period;
+  }
+  d->period[d->n_period++] = len;
+  if (d->n_period < LTC_FPS_PERIOD_FRAMES) return 0;
+
+  for (i = 0; i < LTC_FPS_PERIOD_FRAMES; ++i) avg += d->period[i];
+  avg /= LTC_FPS_PERIOD_FRAMES;
+  for (i = 0; i < LTC_FPS_PERIOD_FRAMES; ++i) {
+    if (fabs(d->period[i] - avg) > avg * LTC_FPS_PERIOD_JITTER) {
+      /* speed change, start over with this frame */
+      d->period[0] = len;
+      d->n_period = 1;
+      return 0;
+    }
+  }
+
+  rate = d->samplerate / avg;
+  for (i = 0; i < 3; ++i) {
+    if (rate > rates[i] / 1.001 * (1 - LTC_FPS_PERIOD_TOLERANCE) && rate < rates[i] * (1 + LTC_FPS_PERIOD_TOLERANCE)) {
+      nominal = rates[i];
+    }
+  }
+  /* drop-frame timecode is only defined for 30 fps */
+  if (nominal == 0 || (frame->ltc.dfbit && nominal != 30) || nominal == d->period_fps) {
+    return 0;
+  }
+
+  /* the frame-numbers counted so far may be from other material, e.g.
+   * before a jump that landed on frame 0, which fuzzyfps does not see */
+  d->ff_cnt = d->ff_max = 0;
+
+  d->period_fps = nominal;
+  if (*fps == nominal) return LTC_FPS_MEASURED;
+  if (output) {
+    fprintf(output, "# detected fps: %d%s\n", nominal, frame->ltc.dfbit?"df":"");
+  }
+  *fps = nominal;
+  return LTC_FPS_MEASURED | LTC_FPS_CHANGED;
+}
+
+/* note: drop-frame-timecode fps rounded up, with the ltc.dfbit set.
+ * returns a combination of enum LTC_FPS_DETECT
+ */
+int fps_detector_add(LTCFpsDetector *d, int *fps, LTCFrameExt *frame, SMPTETimecode *stime, FILE *output) {
   int rv =0;
-  /* note: drop-frame-timecode fps rounded up, with the ltc.dfbit set */
-  if (!fps) return -1;
-  static int ff_cnt = 0;
-  static int ff_max = 0;
-  static LTCFrameExt prev;
   int df = (frame->ltc.dfbit)?1:0;
+  if (!fps) return -1;
+
+  if (d->samplerate > 0) {
+    rv |= fps_from_period(d, fps, frame, output);
+  }
 
-  if (!cmp_ltc_frametime(&prev.ltc, &frame->ltc, 0)) {
-    ff_cnt = ff_max = 0;
+  if (!cmp_ltc_frametime(&d->disc.prev.ltc, &frame->ltc, 0)) {
+    d->ff_cnt = d->ff_max = 0;
   }
-  if (detect_discontinuity(frame, &prev, *fps, 0, 1)) {
-    ff_cnt = ff_max = 0;
+  if (discontinuity_add(&d->disc, frame, *fps)) {
+    d->ff_cnt = d->ff_max = 0;
   }
-  if (stime->frame > ff_max) ff_max = stime->frame;
-  ff_cnt++;
-  if (ff_cnt > 40 && ff_cnt > ff_max) {
-    if (*fps != ff_max + 1) {
+  if (stime->frame > d->ff_max) d->ff_max = stime->frame;
+  d->ff_cnt++;
+  if (d->ff_cnt > 40 && d->ff_cnt > d->ff_max) {
+    if (*fps != d->ff_max + 1) {
       if (output) {
-	fprintf(output, "# detected fps: %d%s\n", ff_max + 1, df?"df":"");
+	fprintf(output, "# detected fps: %d%s\n", d->ff_max + 1, df?"df":"");
       }
-      *fps = ff_max + 1;
-      rv|=1;
+      *fps = d->ff_max + 1;
+      rv|=LTC_FPS_CHANGED;
     }
-    rv|=2;
-    ff_cnt = ff_max = 0;
+    rv|=LTC_FPS_CONFIRMED;
+    d->ff_cnt = d->ff_max = 0;
   }
   return rv;
 }
@@ -4,8 +4,58 @@
 #include <stdio.h>
 #include <ltc.h>
 
+/* discontinuity tracker: compares every frame to the previous one */
+typedef struct LTCDiscontinuity {
+  LTCFrameExt prev;
+  int use_date;
+  int fuzzyfps;
+} LTCDiscontinuity;
+
+/* framerate measurement from the frame period, test/bench_fpsdetect.c
+ * reports the time-to-lock for other values, e.g.
+ * make bench CFLAGS+=-DLTC_FPS_PERIOD_TOLERANCE=0.01 */
+#ifndef LTC_FPS_PERIOD_FRAMES
+#define LTC_FPS_PERIOD_FRAMES 4 ///< frames needed to measure the framerate
+#endif
+#ifndef LTC_FPS_PERIOD_JITTER
+#define LTC_FPS_PERIOD_JITTER 0.02 ///< max. deviation of a frame from the average period
+#endif
+#ifndef LTC_FPS_PERIOD_TOLERANCE
+#define LTC_FPS_PERIOD_TOLERANCE 0.015 ///< max. deviation from a standard framerate
+#endif
+
+/* framerate detector, one per decoder. Detectors share no state and can
+ * run on different threads, see test/test_ltcframeutil.c */
+typedef struct LTCFpsDetector {
+  int ff_cnt;
+  int ff_max;
+  LTCDiscontinuity disc;
+  /* frame period, in samples */
+  int samplerate; ///< 0: only detect from the frame-number rollover
+  double period[LTC_FPS_PERIOD_FRAMES];
+  int n_period;
+  int period_fps; ///< last measured framerate, 0: none
+} LTCFpsDetector;
+
+enum LTC_FPS_DETECT {
+  LTC_FPS_CHANGED = 1,   ///< *fps was modified
+  LTC_FPS_CONFIRMED = 2, ///< the frame-number rollover matches *fps
+  LTC_FPS_MEASURED = 4,  ///< *fps was set from the frame period
+};
+
 int cmp_ltc_frametime(LTCFrame *a, LTCFrame *b, int what);
-int detect_fps(int *fps, LTCFrameExt *frame, SMPTETimecode *stime, FILE *output);
 int detect_discontinuity(LTCFrameExt *frame, LTCFrameExt *prev, int fps, int use_date, int fuzzyfps);
 
+void discontinuity_init(LTCDiscontinuity *t, int use_date, int fuzzyfps);
+int discontinuity_add(LTCDiscontinuity *t, LTCFrameExt *frame, int fps);
+void discontinuity_set(LTCDiscontinuity *t, LTCFrameExt *frame);
+
+void fps_detector_init(LTCFpsDetector *d, int samplerate);
+
+/* *fps is set to the integer framerate only, 24, 25 or 30: neither the
+ * frame period nor the frame-number rollover tells 23.976 from 24 or
+ * 29.97 from 30 fps, only the dfbit of drop-frame LTC implies 29.97.
+ * returns a combination of enum LTC_FPS_DETECT */
+int fps_detector_add(LTCFpsDetector *d, int *fps, LTCFrameExt *frame, SMPTETimecode *stime, FILE *output);
+
 #endif
@@ -20,18 +20,22 @@
 #include <unistd.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
+#include <errno.h>
 #include <math.h>
 #include <signal.h>
 #include <libgen.h>
 #include <getopt.h>
 #include <pthread.h>
 #include <time.h>
+#include <fcntl.h>
 #include <sys/time.h>
 #include <ltc.h>
-#include <sndfile.h>
 
 #include "timecode.h"
 #include "common_ltcgen.h"
+#include "ltcwave.h"
+#include "wavwriter.h"
 #include "myclock.h"
 
 LTCEncoder * encoder = NULL;
@@ -48,73 +52,662 @@ static int reverse = 0;
 static int sync_now =1; // set to 1 to start timecode at date('now')
 float volume_dbfs = -18.0;
 static unsigned long user_bits = 0;
+static int custom_user_bits = 0;
+static long long int start_msec = 0;// start timecode in ms from 00:00:00.00
+static long int date = 0;// bcd: 201012 = 20 Oct 2012
+static long int tzoff = 0;// time-zone in minuteswest
+static int n_jobs = 0;
+static size_t out_buf_size = 1024 * 1024; ///< bytes
+static int direct_io = 0;
+static enum WAV_SAMPLE_FORMAT out_format = WAV_PCM_16;
+static int raw_output = 0; ///< headerless PCM
+static int stdout_fd = -1; ///< output file "-", stdout is redirected to stderr
+static int pipe_closed = 0;
 
 static double duration = 60000.0; // ms
 static volatile int active = 0;
 
-SNDFILE* sf = NULL;
-int sf_format = SF_FORMAT_PCM_16;
+static struct wavwriter *ww = NULL; ///< the output of a serial render
+static size_t frame_buf_size = 0; ///< samples, one LTC frame of any track
 
-void main_loop_reverse(void) {
+/* one LTC signal, a channel of the output file.
+ * Without --track there is a single track using the global options */
+struct ltctrack {
+  /* --track settings, unset ones use the global options */
+  char *fps;
+  char *tc;
+  int custom_user_bits;
+  unsigned long user_bits;
+  int has_volume;
+  float volume_dbfs;
+  int invert;            ///< polarity
+  long long int delay;   ///< samples of silence before the first frame
+
+  int fps_num;
+  int fps_den;
+  int fps_drop;
+  enum LTC_TV_STANDARD ltc_tv;
+  int userbitmode;
+  LTCEncoder *encoder;
+  ltcsnd_sample_t *enc_buf;
+  short conv[256];       ///< encoder sample -> output sample
+  /* the lookup-table encoder, bit-identical to libltc,
+   * see test/test_ltcwave.c */
+  struct ltcwave wave;
+  int use_wave;
+
+  /* multi-track rendering: the current frame */
+  short *frame;
+  int frame_len;
+  int frame_pos;
+  long long int written;
+};
+
+static struct ltctrack *tracks = NULL;
+static int n_tracks = 0;
+
+static void advance_frame(const struct ltctrack *t, LTCEncoder *e) {
+  if (reverse) {
+    LTCFrame f;
+    ltc_encoder_get_frame(e, &f);
+    ltc_frame_decrement(&f, ceil(t->fps_num/t->fps_den),
+	t->fps_num/(double)t->fps_den == 25.0? LTC_TV_625_50 : LTC_TV_525_60,
+	LTC_USE_DATE);
+    ltc_encoder_set_frame(e, &f);
+  } else {
+    ltc_encoder_inc_timecode(e);
+  }
+}
+
+static LTCEncoder *encoder_clone(const struct ltctrack *t) {
+  LTCFrame f;
+  LTCEncoder *e = ltc_encoder_create(samplerate, t->fps_num / (double)t->fps_den, t->ltc_tv, t->userbitmode);
+  if (!e) return NULL;
+  ltc_encoder_set_volume(e, LTCWAVE_VOLUME_DBFS);
+  ltc_encoder_set_filter(e, LTCWAVE_RISE_TIME);
+  ltc_encoder_get_frame(t->encoder, &f);
+  ltc_encoder_set_frame(e, &f);
+  return e;
+}
+
+/* encode the encoder's current LTC frame to snd, using the table if w is
+ * not NULL. Stops after the byte that passes sample end.
+ * returns the number of samples */
+static int encode_frame(const struct ltctrack *t, LTCEncoder *e, struct ltcwave *w, short *snd, long long int *written, long long int end) {
   LTCFrame f;
+  int k, n = 0;
+
+  ltc_encoder_get_frame(e, &f);
+  for (k = 0; k < 10; k++) {
+    const int byteCnt = reverse ? 9 - k : k;
+    int i, len;
+    if (w) {
+      len = ltcwave_encode_byte(w, ((uint8_t*)&f)[byteCnt], reverse, snd + n);
+      if (len < 0) break;
+    } else {
+      ltc_encoder_encode_byte(e, byteCnt, reverse ? -1.0 : 1.0);
+      len = ltc_encoder_copy_buffer(e, t->enc_buf);
+      for (i = 0; i < len; i++) {
+	snd[n + i] = t->conv[t->enc_buf[i]];
+      }
+    }
+    n += len;
+    *written += len;
+    if (end < *written) break;
+  } /* end byteCnt - one video frames's worth of LTC */
+  return n;
+}
+
+/* the number of samples that fit into the output buffer, at least one frame */
+static size_t out_buf_samples(void) {
+  const size_t n = out_buf_size / sizeof(short);
+  return n > frame_buf_size ? n : frame_buf_size;
+}
+
+static int format_bytes(void) {
+  switch (out_format) {
+    case WAV_PCM_24: return 3;
+    case WAV_FLOAT_32: return 4;
+    default: return 2;
+  }
+}
+
+/* write n interleaved sample-frames */
+static int write_samples(short *snd, size_t n) {
+  return wavwriter_write_s16(ww, snd, n * n_tracks);
+}
+
+/* the reader closing the pipe ends the stream, anything else is an error */
+static void write_error(void) {
+  if (ww && ww->error == EPIPE) {
+    fprintf(stderr, "output closed by the reader\n");
+    pipe_closed = 1;
+  } else {
+    fprintf(stderr, "error writing output file\n");
+  }
+}
+
+static void report(long long int written, const struct timespec *t0) {
+  struct timespec t1;
+  double sec;
+  my_clock_gettime(&t1);
+  sec = (t1.tv_sec - t0->tv_sec) + (t1.tv_nsec - t0->tv_nsec) / 1e9;
+  if (sec <= 0) return;
+  printf("%.2f sec, %.1f MB/s, %.0fx realtime\n", sec,
+      written * n_tracks * format_bytes() / sec / 1e6, written / (double)samplerate / sec);
+}
+
+/* frames are collected in a buffer of out_buf_size,
+ * which is written when it can not hold another frame */
+long long int main_loop(void) {
+  struct ltctrack *t = &tracks[0];
   const long long int end = ceil(duration * samplerate / 1000.0);
+  const size_t buf_samples = out_buf_samples();
   long long int written = 0;
+  size_t n = 0;
   active=1;
-  short *snd = NULL;
-  const short smult = rint(pow(10, volume_dbfs/20.0) * 32767.0);
+  short *snd = malloc(buf_samples * sizeof(short));
 
   while(active==1 && (duration <= 0 || end >= written)) {
-      int byteCnt;
-      for (byteCnt = 9; byteCnt >= 0; byteCnt--) {
-	int i;
-	ltc_encoder_encode_byte(encoder, byteCnt, -1.0);
-	const int len = ltc_encoder_copy_buffer(encoder, enc_buf);
-	if (!snd) snd = malloc(len * sizeof(short));
-	for (i=0;i<len;i++) {
-	  const short val = ( (int)(enc_buf[i] - 128) * smult / 90 );
-	  snd[i] = val;
-	}
-	sf_writef_short(sf, snd, len);
-	written += len;
-	if (end < written) break;
-      } /* end byteCnt - one video frames's worth of LTC */
-
-      ltc_encoder_get_frame(encoder, &f);
-      ltc_frame_decrement(&f, ceil(fps_num/fps_den),
-	  fps_num/(double)fps_den == 25.0? LTC_TV_625_50 : LTC_TV_525_60,
-	  LTC_USE_DATE);
-      ltc_encoder_set_frame(encoder, &f);
+    n += encode_frame(t, t->encoder, t->use_wave ? &t->wave : NULL, snd + n, &written, duration > 0 ? end : LLONG_MAX);
+    advance_frame(t, t->encoder);
+    if (n + frame_buf_size > buf_samples) {
+      if (write_samples(snd, n)) {
+	write_error();
+	active = 0;
+      }
+      n = 0;
+    }
+  }
+  if (n > 0 && write_samples(snd, n)) {
+    write_error();
   }
   free(snd);
   printf("wrote %lld audio-samples\n", written);
+  return written;
+}
+
+/* render the next n samples of a track: its delay, then LTC */
+static void track_render(struct ltctrack *t, short *out, size_t n) {
+  size_t i = 0;
+  while (i < n) {
+    size_t k;
+    if (t->delay > 0) {
+      k = n - i < (size_t)t->delay ? n - i : (size_t)t->delay;
+      memset(out + i, 0, k * sizeof(short));
+      t->delay -= k;
+      i += k;
+      continue;
+    }
+    if (t->frame_pos == t->frame_len) {
+      t->frame_len = encode_frame(t, t->encoder, t->use_wave ? &t->wave : NULL, t->frame, &t->written, LLONG_MAX);
+      t->frame_pos = 0;
+      advance_frame(t, t->encoder);
+      if (t->frame_len <= 0) {
+	memset(out + i, 0, (n - i) * sizeof(short));
+	return;
+      }
+    }
+    k = t->frame_len - t->frame_pos;
+    if (k > n - i) k = n - i;
+    memcpy(out + i, t->frame + t->frame_pos, k * sizeof(short));
+    t->frame_pos += k;
+    i += k;
+  }
 }
 
-void main_loop(void) {
+/* all tracks in one pass, interleaved. The file has exactly the given
+ * duration, the last frame of every track is cut off. */
+long long int main_loop_tracks(void) {
   const long long int end = ceil(duration * samplerate / 1000.0);
+  size_t block = out_buf_samples() / n_tracks;
   long long int written = 0;
+  short *snd, *mix;
+  int k;
+
+  if (block < 1) block = 1;
+  snd = malloc(block * sizeof(short));
+  mix = malloc(block * n_tracks * sizeof(short));
+  for (k = 0; k < n_tracks; k++) {
+    tracks[k].frame = malloc(frame_buf_size * sizeof(short));
+    tracks[k].frame_len = tracks[k].frame_pos = 0;
+  }
   active=1;
-  short *snd = NULL;
-  const short smult = rint(pow(10, volume_dbfs/20.0) * 32767.0);
 
-  while(active==1 && (duration <= 0 || end >= written)) {
-      int byteCnt;
-      for (byteCnt = 0; byteCnt < 10; byteCnt++) {
-	int i;
-	ltc_encoder_encode_byte(encoder, byteCnt, 1.0);
-	const int len = ltc_encoder_copy_buffer(encoder, enc_buf);
-	if (!snd) snd = malloc(len * sizeof(short));
-	for (i=0;i<len;i++) {
-	  const short val = ( (int)(enc_buf[i] - 128) * smult / 90 );
-	  snd[i] = val;
-	}
-	sf_writef_short(sf, snd, len);
-	written += len;
-	if (end < written) break;
-      } /* end byteCnt - one video frames's worth of LTC */
-      ltc_encoder_inc_timecode(encoder);
+  while (active==1 && (duration <= 0 || written < end)) {
+    size_t i, n = block;
+    if (duration > 0 && end - written < (long long int)n) {
+      n = end - written;
+    }
+    for (k = 0; k < n_tracks; k++) {
+      track_render(&tracks[k], snd, n);
+      for (i = 0; i < n; i++) {
+	mix[i * n_tracks + k] = snd[i];
+      }
+    }
+    if (write_samples(mix, n)) {
+      write_error();
+      break;
+    }
+    written += n;
+  }
+
+  for (k = 0; k < n_tracks; k++) {
+    free(tracks[k].frame);
+    tracks[k].frame = NULL;
   }
   free(snd);
-  printf("wrote %lld audio-samples\n", written);
+  free(mix);
+  printf("wrote %lld audio-samples, %d channels\n", written, n_tracks);
+  return written;
+}
+
+/* parallel rendering (--jobs).
+ *
+ * The frames and the encoder position (fractional sample, level) at the
+ * start of every chunk are found by a pass that only computes segment
+ * lengths. The chunks are then rendered concurrently with the
+ * lookup-table, each by its own LTCEncoder, and written with pwrite()
+ * at the chunk's offset into the preallocated file.
+ */
+
+struct ltcgen_chunk {
+  LTCFrame frame;        ///< first frame
+  struct ltcwave wave;   ///< encoder position at the first frame
+  long long int start;   ///< first sample
+  long long int frames;
+};
+
+struct ltcgen_jobs {
+  struct ltctrack *track;
+  struct ltcgen_chunk *chunks;
+  int n_chunks;
+  int next;              ///< next chunk to render
+  long long int end;
+  int fd;
+  off_t data_offset;
+  int error;
+  pthread_mutex_t lock;
+};
+
+static int plan_chunks(struct ltcgen_jobs *j, int n_jobs, long long int *written) {
+  struct ltctrack *t = j->track;
+  const double spf = samplerate * t->fps_den / (double)t->fps_num;
+  const long long int est = j->end / spf + 2;
+  const long long int per = (est + n_jobs - 1) / n_jobs;
+  struct ltcwave w = t->wave;
+  long long int i = 0;
+
+  j->chunks = calloc(n_jobs, sizeof(struct ltcgen_chunk));
+  if (!j->chunks) return -1;
+  j->n_chunks = 0;
+  *written = 0;
+
+  while (active==1 && j->end >= *written) {
+    LTCFrame f;
+    int k;
+    ltc_encoder_get_frame(t->encoder, &f);
+    if (i % per == 0 && j->n_chunks < n_jobs) {
+      struct ltcgen_chunk *c = &j->chunks[j->n_chunks++];
+      c->frame = f;
+      c->wave = w;
+      c->start = *written;
+    }
+    for (k = 0; k < 10; k++) {
+      *written += ltcwave_byte_length(&w, ((uint8_t*)&f)[reverse ? 9 - k : k], reverse);
+      if (j->end < *written) break;
+    }
+    j->chunks[j->n_chunks - 1].frames++;
+    advance_frame(t, t->encoder);
+    ++i;
+  }
+  return active == 1 ? 0 : -1;
+}
+
+/* the number of samples main_loop() writes, from the segment lengths of
+ * the lookup-table encoder. The encoder is left at the first frame. */
+static long long int planned_length(struct ltctrack *t, long long int end) {
+  struct ltcgen_jobs j;
+  LTCFrame f;
+  long long int written = 0;
+
+  memset(&j, 0, sizeof(struct ltcgen_jobs));
+  j.track = t;
+  j.end = end;
+  active=1;
+  ltc_encoder_get_frame(t->encoder, &f);
+  if (plan_chunks(&j, 1, &written)) {
+    written = -1;
+  }
+  ltc_encoder_set_frame(t->encoder, &f);
+  free(j.chunks);
+  return written;
+}
+
+static int render_chunk(struct ltcgen_jobs *j, struct ltcgen_chunk *c, short *snd, uint8_t *out) {
+  LTCEncoder *e = encoder_clone(j->track);
+  long long int written = c->start;
+  long long int i;
+  size_t n = 0;
+  off_t pos = j->data_offset + c->start * format_bytes();
+  int rv = 0;
+
+  if (!e) return -1;
+  ltc_encoder_set_frame(e, &c->frame);
+  for (i = 0; i < c->frames && active==1; i++) {
+    n += encode_frame(j->track, e, &c->wave, snd + n, &written, j->end);
+    advance_frame(j->track, e);
+    if (n + frame_buf_size > out_buf_samples() || i + 1 == c->frames) {
+      const size_t len = wav_encode_s16(out, snd, n, out_format);
+      if (wav_pwrite_all(j->fd, out, len, pos)) {
+	rv = -1;
+	break;
+      }
+      pos += len;
+      n = 0;
+    }
+  }
+  ltc_encoder_free(e);
+  return rv;
+}
+
+static void *render_worker(void *arg) {
+  struct ltcgen_jobs *j = (struct ltcgen_jobs*) arg;
+  short *snd = malloc(out_buf_samples() * sizeof(short));
+  uint8_t *out = malloc(out_buf_samples() * format_bytes());
+
+  while (snd && out) {
+    struct ltcgen_chunk *c = NULL;
+    pthread_mutex_lock(&j->lock);
+    if (!j->error && j->next < j->n_chunks) {
+      c = &j->chunks[j->next++];
+    }
+    pthread_mutex_unlock(&j->lock);
+    if (!c) break;
+    if (render_chunk(j, c, snd, out)) {
+      pthread_mutex_lock(&j->lock);
+      j->error = 1;
+      pthread_mutex_unlock(&j->lock);
+    }
+  }
+  if (!snd || !out) {
+    pthread_mutex_lock(&j->lock);
+    j->error = 1;
+    pthread_mutex_unlock(&j->lock);
+  }
+  free(snd);
+  free(out);
+  return NULL;
+}
+
+static long long int main_loop_parallel(const char *path, int n_jobs) {
+  struct ltcgen_jobs j;
+  struct wavinfo wi;
+  uint8_t hdr[WAV_HEADER_MAX];
+  long long int written;
+  size_t hdr_len;
+  pthread_t *threads;
+  int i, n_threads;
+
+  memset(&j, 0, sizeof(struct ltcgen_jobs));
+  j.track = &tracks[0];
+  j.end = ceil(duration * samplerate / 1000.0);
+  active=1;
+
+  if (plan_chunks(&j, n_jobs, &written)) {
+    free(j.chunks);
+    return -1;
+  }
+
+  memset(&wi, 0, sizeof(struct wavinfo));
+  wi.format = out_format;
+  wi.channels = 1;
+  wi.samplerate = samplerate;
+  wi.bytes_per_sample = format_bytes();
+  wi.data_size = written * wi.bytes_per_sample;
+  wi.rf64 = wi.data_size + 44 > 0xffffffffULL;
+  hdr_len = raw_output ? 0 : wav_make_header(hdr, &wi, 0);
+  j.data_offset = hdr_len;
+
+  j.fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (j.fd < 0) {
+    fprintf(stderr, "cannot open output file '%s'\n", path);
+    free(j.chunks);
+    return -1;
+  }
+  if (wav_preallocate(j.fd, hdr_len + wi.data_size + (wi.data_size & 1))) {
+    j.error = 1;
+  }
+  if (hdr_len > 0 && wav_pwrite_all(j.fd, hdr, hdr_len, 0)) {
+    j.error = 1;
+  }
+
+  n_threads = n_jobs < j.n_chunks ? n_jobs : j.n_chunks;
+  threads = calloc(n_threads, sizeof(pthread_t));
+  pthread_mutex_init(&j.lock, NULL);
+  for (i = 0; i < n_threads; i++) {
+    if (pthread_create(&threads[i], NULL, render_worker, &j)) {
+      n_threads = i;
+      break;
+    }
+  }
+  for (i = 0; i < n_threads; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  pthread_mutex_destroy(&j.lock);
+  free(threads);
+  free(j.chunks);
+
+  if (close(j.fd)) {
+    j.error = 1;
+  }
+  if (j.error || n_threads == 0) {
+    fprintf(stderr, "error writing to '%s'\n", path);
+    return -1;
+  }
+  if (active != 1) {
+    fprintf(stderr, "interrupted, '%s' is incomplete\n", path);
+    return -1;
+  }
+  printf("wrote %lld audio-samples using %d threads\n", written, n_threads);
+  return written;
+}
+
+/**************************
+ * tracks and output
+ */
+
+/* parse a --track spec: comma separated key=value pairs */
+static int parse_track(struct ltctrack *t, const char *spec) {
+  char *buf = strdup(spec);
+  char *tok, *save = NULL;
+  int rv = 0;
+
+  memset(t, 0, sizeof(struct ltctrack));
+  for (tok = strtok_r(buf, ",", &save); tok; tok = strtok_r(NULL, ",", &save)) {
+    char *val = strchr(tok, '=');
+    if (val) *val++ = '\0';
+    if (!strcmp(tok, "invert")) {
+      t->invert = 1;
+    } else if (!val) {
+      rv = -1;
+    } else if (!strcmp(tok, "fps")) {
+      t->fps = strdup(val);
+    } else if (!strcmp(tok, "tc")) {
+      t->tc = strdup(val);
+    } else if (!strcmp(tok, "userbits")) {
+      t->custom_user_bits = 1;
+      t->user_bits = parse_user_bits(val);
+    } else if (!strcmp(tok, "userbyte")) {
+      t->custom_user_bits = 1;
+      t->user_bits = parse_user_byte(val);
+    } else if (!strcmp(tok, "volume")) {
+      t->has_volume = 1;
+      t->volume_dbfs = atof(val);
+      if (t->volume_dbfs > 0) t->volume_dbfs=0;
+      if (t->volume_dbfs < -96.0) t->volume_dbfs=-96.0;
+    } else if (!strcmp(tok, "delay")) {
+      t->delay = atoll(val);
+      if (t->delay < 0) t->delay = 0;
+    } else {
+      rv = -1;
+    }
+    if (rv) {
+      fprintf(stderr, "invalid track setting '%s' in '%s'\n", tok, spec);
+      break;
+    }
+  }
+  free(buf);
+  return rv;
+}
+
+/* create the track's encoder and set its start time.
+ * The helpers in common_ltcgen use the global fps and encoder,
+ * they are set to the track's for the duration of the call */
+static int track_setup(struct ltctrack *t) {
+  const int g_fps_num = fps_num, g_fps_den = fps_den, g_fps_drop = fps_drop;
+  const enum LTC_TV_STANDARD g_ltc_tv = ltc_tv;
+  long long int msec = start_msec;
+  int now = sync_now;
+  int cub = custom_user_bits;
+  unsigned long ub = user_bits;
+  long int tdate = date;
+  long int ttz = tzoff;
+  int i;
+
+  if (t->fps) {
+    parse_fps(t->fps);
+    fps_sanity_checks();
+  }
+  if (t->tc) {
+    int bcd[SMPTE_LAST];
+    parse_string(rint(fps_num/(double)fps_den), bcd, t->tc);
+    msec = bcdarray_to_framecnt(bcd) * 1000.0 / (((double)fps_num)/(double)fps_den);
+    now = 0;
+  }
+  if (t->custom_user_bits) {
+    cub = 1;
+    ub = t->user_bits;
+    /* Free format user bits, so reset any date/timezone settings. */
+    tdate = 0;
+    ttz = 0;
+  }
+
+  t->fps_num = fps_num;
+  t->fps_den = fps_den;
+  t->fps_drop = fps_drop;
+  t->ltc_tv = ltc_tv;
+  t->userbitmode = ((tdate != 0) ? LTC_USE_DATE : 0) | ((now) ? (LTC_USE_DATE|LTC_TC_CLOCK) : 0);
+
+  encoder_setup(fps_num, fps_den, ltc_tv, samplerate, t->userbitmode);
+  t->encoder = encoder;
+  t->enc_buf = enc_buf;
+  /* the libltc defaults, set explicitly for the lookup-table encoder.
+   * At -3dBFS the encoder's peak is 128 +- 90 */
+  ltc_encoder_set_volume(encoder, LTCWAVE_VOLUME_DBFS);
+  ltc_encoder_set_filter(encoder, LTCWAVE_RISE_TIME);
+
+  {
+    const short smult = rint(pow(10, (t->has_volume ? t->volume_dbfs : volume_dbfs)/20.0) * 32767.0);
+    for (i = 0; i < 256; i++) {
+      t->conv[i] = ( (i - 128) * smult / 90 );
+      if (t->invert) t->conv[i] = -t->conv[i];
+    }
+    if (frame_buf_size < 10 * ltc_encoder_get_buffersize(encoder)) {
+      frame_buf_size = 10 * ltc_encoder_get_buffersize(encoder);
+    }
+    if (!ltcwave_init(&t->wave, samplerate, fps_num / (double)fps_den, t->conv)) {
+      t->use_wave = 1;
+      if (frame_buf_size < 160 * (size_t)t->wave.n_max) frame_buf_size = 160 * t->wave.n_max;
+    }
+  }
+
+  if (now==0) {
+#if 0 // DEBUG
+    printf("date: %06ld (DDMMYY)\n", tdate);
+    printf("time: %lldms\n", msec);
+    printf("zone: %c%02d%02d = %ld minutes west\n", ttz<0?'-':'+', abs(ttz/60),abs(ttz%60), ttz);
+#endif
+    set_encoder_time(1000.0*msec, tdate, ttz, fps_num, fps_den, 1);
+  } else {
+    struct timespec ts;
+    long int sync_msec;
+    my_clock_gettime(&ts);
+    sync_msec = (ts.tv_sec%86400)*1000 + (ts.tv_nsec/1000000);
+
+    time_t tnow = ts.tv_sec;
+    struct tm gm;
+    long int sync_date = 0;
+    if (gmtime_r(&tnow, &gm))
+      sync_date = gm.tm_mday*10000 + (gm.tm_mon + 1)*100 + (gm.tm_year % 100);
+    sync_msec += 1000.0 * ltc_frame_alignment(samplerate * fps_den / (double) fps_num, ltc_tv) / samplerate;
+    set_encoder_time(1000.0*sync_msec, cub ? 0 : sync_date, 0, fps_num, fps_den, 1);
+  }
+
+  if (cub)
+    ltc_encoder_set_user_bits(encoder, ub);
+
+  encoder = NULL;
+  enc_buf = NULL;
+  fps_num = g_fps_num;
+  fps_den = g_fps_den;
+  fps_drop = g_fps_drop;
+  ltc_tv = g_ltc_tv;
+  return t->encoder ? 0 : -1;
+}
+
+static void track_free(struct ltctrack *t) {
+  if (t->encoder) ltc_encoder_free(t->encoder);
+  free(t->enc_buf);
+  ltcwave_free(&t->wave);
+  free(t->fps);
+  free(t->tc);
+}
+
+/* the same WAV/RF64 header as main_loop_parallel() writes: RF64 is
+ * chosen in advance, from the exact length where it is known */
+static int open_output(const char *path, int multitrack) {
+  static struct wavwriter w;
+  const long long int end = ceil(duration * samplerate / 1000.0);
+  const int flags = (direct_io ? WAVWRITER_DIRECT : 0) | (raw_output ? WAVWRITER_RAW : 0);
+  long long int est = 0;
+  struct wavinfo wi;
+
+  if (duration > 0 && multitrack) {
+    est = end;
+  } else if (duration > 0 && tracks[0].use_wave) {
+    est = planned_length(&tracks[0], end);
+  }
+  if (duration > 0 && est <= 0) {
+    /* interrupted, or the libltc encoder: an upper bound */
+    est = end + frame_buf_size;
+  }
+
+  memset(&wi, 0, sizeof(struct wavinfo));
+  wi.format = out_format;
+  wi.channels = n_tracks;
+  wi.samplerate = samplerate;
+  wi.bytes_per_sample = format_bytes();
+  /* used to preallocate the file, 0: unknown */
+  wi.data_size = est * n_tracks * format_bytes();
+  if (stdout_fd >= 0) {
+    if (wavwriter_open_fd(&w, stdout_fd, &wi, out_buf_size, flags)) {
+      return -1;
+    }
+  } else if (wavwriter_open(&w, path, &wi, out_buf_size, flags)) {
+    return -1;
+  }
+  ww = &w;
+  return 0;
+}
+
+static int close_output(void) {
+  int rv = 0;
+  if (ww) {
+    rv = wavwriter_close(ww) && !pipe_closed;
+    ww = NULL;
+  }
+  return rv;
 }
 
 /**************************
@@ -138,24 +731,36 @@ static struct option const long_options[] =
   {"timecode", required_argument, 0, 't'},
   {"samplerate", required_argument, 0, 's'},
   {"userbits", required_argument, 0, 'u'},
+  {"jobs", required_argument, 0, 'j'},
+  {"buffer", required_argument, 0, 'B'},
+  {"direct", no_argument, 0, 'D'},
+  {"format", required_argument, 0, 'F'},
+  {"track", required_argument, 0, 'T'},
+  {"raw", no_argument, 0, 'R'},
   {NULL, 0, NULL, 0}
 };
 
 static void usage (int status) {
   printf ("ltcgen - generate linear time code audio-file.\n");
-  printf ("Usage: %s [OPTION] <output-file>\n", basename(program_name));
+  printf ("Usage: %s [OPTION] <output-file|->\n", basename(program_name));
   printf ("\n"
 "Options:\n"
 " -b, --userbyte val         specify fixed user bits (0 <= val <= UINT32_MAX)\n"
+" -B, --buffer kbytes        size of the output buffer (default 1024)\n"
 " -d, --date datestring      set date, format is either DDMMYY or MM/DD/YY\n"
+" -D, --direct               write the file directly, bypassing the page-cache\n"
 " -f, --fps fps              set frame-rate NUM[/DEN][ndf|df] default: 25/1ndf \n"
+" -F, --format fmt           sample format: pcm16, pcm24 or float (default pcm16)\n"
 " -g, --volume float         set output level in dBFS default -18db\n"
 " -h, --help                 display this help and exit\n"
+" -j, --jobs num             render the file in parallel using <num> threads\n"
 " -l, --duration time        set duration of file to encode [[[HH:]MM:]SS:]FF.\n"
 " -m, --timezone tz          set timezone in minutes-west of UTC\n"
 " -r, --reverse              encode backwards from start-time\n"
+" -R, --raw                  write headerless PCM (little-endian)\n"
 " -s, --samplerate sr        specify samplerate (default 48000)\n"
 " -t, --timecode time        specify start-time/timecode [[[HH:]MM:]SS:]FF\n"
+" -T, --track spec           add a track (output channel), see below\n"
 " -u, --userbits bcd         specify fixed BCD user bits as up to  8 BCD digits\n"
 "                            CAUTION: This ignores any date/timezone settings!\n"
 " -V, --version              print version information and exit\n"
@@ -167,9 +772,31 @@ static void usage (int status) {
 "\n"
 "if both -b and -u is used, the later option takes precedence.\n"
 "\n"
-"If the duration is <=0, ltcgen write until it receives SIGINT.\n"
+"If the duration is <=0, ltcgen write until it receives SIGINT or SIGTERM.\n"
+"\n"
+"If the output-file is '-', raw PCM is streamed to standard output and\n"
+"all messages go to standard error. Streaming ends when the reader closes\n"
+"the pipe, e.g.\n"
+"  ltcgen -l 0 -F float - | ffmpeg -f f32le -ar 48000 -ac 1 -i - ...\n"
+"\n"
+"With --jobs the duration is split into chunks of whole frames that are\n"
+"rendered concurrently, and written in place into the preallocated file.\n"
+"The audio is identical to a serial render. Files larger than 4GB are\n"
+"written as RF64. --jobs requires a duration > 0.\n"
+"\n"
+"--direct bypasses the page-cache (O_DIRECT) where the file-system supports\n"
+"it.\n"
 "\n"
-"The output file-format is WAV, signed 16 bit, mono.\n"
+"--track may be given more than once, every track is a channel of the\n"
+"output file, with its own encoder. The spec is a comma separated list of\n"
+"  fps=NUM[/DEN][ndf|df], tc=[[[HH:]MM:]SS:]FF, userbits=bcd, userbyte=val,\n"
+"  volume=dBFS, delay=samples (of silence before the LTC) and invert\n"
+"Settings that are not given use the global options. With tracks, the file\n"
+"has exactly the given duration, --jobs is not used.\n"
+"Example: -T fps=25 -T fps=30000/1001df,tc=01:00:00:00,invert\n"
+"\n"
+"The output file-format is WAV, or RF64 if it is larger than 4GB,\n"
+"mono unless --track is used.\n"
 "\n"
 "Report bugs to <robin@gareus.org>.\n"
 "Website and manual: <https://github.com/x42/ltc-tools>\n"
@@ -185,13 +812,33 @@ int main (int argc, char **argv) {
   int c;
 
   program_name = argv[0];
-  long long int msec = 0;// start timecode in ms from 00:00:00.00
-  long int date = 0;// bcd: 201012 = 20 Oct 2012
-  long int tzoff = 0;// time-zone in minuteswest
-  int custom_user_bits = 0;
+  int multitrack = 0;
+  int i;
+  int rv = 0;
+
+  /* stream to stdout: the informational messages, including those
+   * printed while parsing the options, go to stderr */
+  for (i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-")) {
+      fflush(stdout);
+      stdout_fd = dup(STDOUT_FILENO);
+      dup2(STDERR_FILENO, STDOUT_FILENO);
+      setvbuf(stdout, NULL, _IOLBF, 0);
+      raw_output = 1;
+      break;
+    }
+  }
+  long long int written = 0;
+  struct timespec t0;
 
   while ((c = getopt_long (argc, argv,
 	   "h"	/* help */
+	   "j:"	/* jobs */
+	   "B:"	/* buffer */
+	   "D"	/* direct */
+	   "F:"	/* format */
+	   "T:"	/* track */
+	   "R"	/* raw */
 	   "b:"	/* userbyte */
 	   "f:"	/* fps */
 	   "d:"	/* date */
@@ -219,6 +866,45 @@ int main (int argc, char **argv) {
 	case 'h':
 	  usage (0);
 
+	case 'j':
+	  n_jobs = atoi(optarg);
+	  if (n_jobs < 1) n_jobs = 1;
+	  break;
+
+	case 'B':
+	  out_buf_size = atoi(optarg) * 1024;
+	  if (atoi(optarg) < 4) out_buf_size = 4096;
+	  break;
+
+	case 'D':
+	  direct_io = 1;
+	  break;
+
+	case 'F':
+	  if (!strcmp(optarg, "pcm16") || !strcmp(optarg, "16")) {
+	    out_format = WAV_PCM_16;
+	  } else if (!strcmp(optarg, "pcm24") || !strcmp(optarg, "24")) {
+	    out_format = WAV_PCM_24;
+	  } else if (!strcmp(optarg, "float") || !strcmp(optarg, "float32")) {
+	    out_format = WAV_FLOAT_32;
+	  } else {
+	    fprintf(stderr, "invalid sample format '%s'\n", optarg);
+	    usage (EXIT_FAILURE);
+	  }
+	  break;
+
+	case 'R':
+	  raw_output = 1;
+	  break;
+
+	case 'T':
+	  tracks = realloc(tracks, (n_tracks + 1) * sizeof(struct ltctrack));
+	  if (parse_track(&tracks[n_tracks], optarg)) {
+	    usage (EXIT_FAILURE);
+	  }
+	  ++n_tracks;
+	  break;
+
 	case 'f':
 	  parse_fps(optarg);
 	  break;
@@ -274,7 +960,7 @@ int main (int argc, char **argv) {
 	    sync_now=0;
 	    int bcd[SMPTE_LAST];
 	    parse_string(rint(fps_num/(double)fps_den), bcd, optarg);
-	    msec = bcdarray_to_framecnt(bcd) * 1000.0 / (((double)fps_num)/(double)fps_den);
+	    start_msec = bcdarray_to_framecnt(bcd) * 1000.0 / (((double)fps_num)/(double)fps_den);
 	  }
 	  break;
 
@@ -309,61 +995,68 @@ int main (int argc, char **argv) {
 
   fps_sanity_checks();
 
-  {
-    SF_INFO sfnfo;
-    memset(&sfnfo, 0, sizeof(SF_INFO));
-    sfnfo.samplerate = samplerate;
-    sfnfo.channels = 1;
-    sfnfo.format = SF_FORMAT_WAV | sf_format;
-    sf = sf_open(argv[optind], SFM_WRITE, &sfnfo);
-    if (!sf) {
-      fprintf(stderr, "cannot open output file '%s'\n", argv[optind]);
-      return 1;
-    }
+  if (n_jobs > 0 && duration <= 0) {
+    fprintf(stderr, "--jobs requires a duration > 0\n");
+    return 1;
   }
+
   printf("writing to '%s'\n", argv[optind]);
   printf("samplerate: %d, duration %.1f ms\n", samplerate, duration);
 
-  encoder_setup(fps_num, fps_den, ltc_tv, samplerate,
-      ((date != 0) ? LTC_USE_DATE : 0) | ((sync_now) ? (LTC_USE_DATE|LTC_TC_CLOCK) : 0)
-      );
-
-  if (sync_now==0) {
-#if 0 // DEBUG
-    printf("date: %06ld (DDMMYY)\n", date);
-    printf("time: %lldms\n", msec);
-    printf("zone: %c%02d%02d = %ld minutes west\n", tzoff<0?'-':'+', abs(tzoff/60),abs(tzoff%60), tzoff);
-#endif
-    set_encoder_time(1000.0*msec, date, tzoff, fps_num, fps_den, 1);
+  if (n_tracks > 0) {
+    multitrack = 1;
   } else {
-    struct timespec t;
-    long int sync_msec;
-    my_clock_gettime(&t);
-    sync_msec = (t.tv_sec%86400)*1000 + (t.tv_nsec/1000000);
-
-    time_t now = t.tv_sec;
-    struct tm gm;
-    long int sync_date = 0;
-    if (gmtime_r(&now, &gm))
-      sync_date = gm.tm_mday*10000 + (gm.tm_mon + 1)*100 + (gm.tm_year % 100);
-    sync_msec += 1000.0 * ltc_frame_alignment(samplerate * fps_den / (double) fps_num, ltc_tv) / samplerate;
-    set_encoder_time(1000.0*sync_msec, custom_user_bits ? 0 : sync_date, 0, fps_num, fps_den, 1);
+    tracks = calloc(1, sizeof(struct ltctrack));
+    n_tracks = 1;
+  }
+  for (i = 0; i < n_tracks; i++) {
+    if (track_setup(&tracks[i])) {
+      fprintf(stderr, "cannot create LTC encoder\n");
+      return 1;
+    }
   }
-
-  if (custom_user_bits)
-    ltc_encoder_set_user_bits(encoder, user_bits);
 
   signal(SIGINT, endnow);
+  signal(SIGTERM, endnow);
+  /* a closed pipe is reported by write() */
+  signal(SIGPIPE, SIG_IGN);
+
+  if (n_jobs > 0 && multitrack) {
+    printf("Note: --jobs is not supported with --track, rendering serially.\n");
+    n_jobs = 0;
+  }
+  if (n_jobs > 0 && stdout_fd >= 0) {
+    printf("Note: --jobs can not write to a pipe, rendering serially.\n");
+    n_jobs = 0;
+  }
+  if (n_jobs > 0 && !tracks[0].use_wave) {
+    printf("Note: --jobs needs the lookup-table encoder, rendering serially.\n");
+    n_jobs = 0;
+  }
 
-  if (reverse)
-    main_loop_reverse();
-  else
-    main_loop();
+  my_clock_gettime(&t0);
+  if (n_jobs > 0) {
+    written = main_loop_parallel(argv[optind], n_jobs);
+    rv = written < 0 ? 1 : 0;
+  } else if (open_output(argv[optind], multitrack)) {
+    fprintf(stderr, "cannot open output file '%s'\n", argv[optind]);
+    rv = 1;
+  } else {
+    written = multitrack ? main_loop_tracks() : main_loop();
+    if (close_output()) {
+      fprintf(stderr, "error writing to '%s'\n", argv[optind]);
+      rv = 1;
+    }
+  }
+  if (rv == 0) {
+    report(written, &t0);
+  }
 
-  if (sf) sf_close(sf);
-  if (enc_buf) free(enc_buf);
-  if (encoder) ltc_encoder_free(encoder);
-  return(0);
+  for (i = 0; i < n_tracks; i++) {
+    track_free(&tracks[i]);
+  }
+  free(tracks);
+  return(rv);
 }
 
 /* vi:set ts=8 sts=2 sw=2: */
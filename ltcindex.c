@@ -0,0 +1,346 @@
+/* persistent timecode <> audio-sample index
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* File format, all values little-endian:
+ *
+ *  header (48 bytes)
+ *   0  char[8]  "LTCINDEX"
+ *   8  uint32   version
+ *  12  uint32   sample-rate
+ *  16  uint64   size of the audio-file
+ *  24  int64    mtime of the audio-file, seconds
+ *  32  uint32   mtime, nanoseconds
+ *  36  uint32   number of runs
+ *  40  uint64   reserved
+ *
+ *  runs (32 bytes each), in file order
+ *   0  int64    start sample
+ *   8  int64    end sample
+ *  16  int64    frame-number of the first timecode
+ *  24  uint32   number of frames
+ *  28  uint8    fps
+ *  29  uint8    drop-frame
+ *  30  uint8    reverse
+ *  31  uint8    end reason
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#ifdef __APPLE__
+#define st_mtim st_mtimespec
+#endif
+
+#include "ltcindex.h"
+#include "timecode.h"
+
+#define LTCINDEX_VERSION 1
+#define HEADER_SIZE 48
+#define RUN_SIZE 32
+
+static void wr_le(uint8_t *p, uint64_t v, int n) {
+	int i;
+	for (i = 0; i < n; ++i, v >>= 8) p[i] = v & 0xff;
+}
+
+static uint64_t rd_le(const uint8_t *p, int n) {
+	uint64_t v = 0;
+	while (n-- > 0) v = (v << 8) | p[n];
+	return v;
+}
+
+void ltcindex_init(struct ltcindex *idx) {
+	memset(idx, 0, sizeof(struct ltcindex));
+}
+
+void ltcindex_free(struct ltcindex *idx) {
+	free(idx->runs);
+	free(idx->by_tc);
+	ltcindex_init(idx);
+}
+
+void ltcindex_run_set(struct ltcindex_run *r, const struct ltcrun *run) {
+	SMPTETimecode st;
+
+	ltc_frame_to_time(&st, (LTCFrame *) &run->first.ltc, 0);
+	r->start_sample = run->first.off_start;
+	r->end_sample = run->last.off_end;
+	r->start_frame = smpte_to_framecnt(run->fps, run->first.ltc.dfbit, st.hours, st.mins, st.secs, st.frame);
+	r->n_frames = run->n_frames;
+	r->fps = run->fps;
+	r->drop = run->first.ltc.dfbit ? 1 : 0;
+	r->reverse = run->first.reverse ? 1 : 0;
+	r->end = run->end;
+}
+
+void ltcindex_add(struct ltcindex *idx, const struct ltcrun *run) {
+	if (idx->n_runs == idx->n_alloc) {
+		idx->n_alloc = idx->n_alloc ? idx->n_alloc * 2 : 64;
+		idx->runs = realloc(idx->runs, idx->n_alloc * sizeof(struct ltcindex_run));
+	}
+	ltcindex_run_set(&idx->runs[idx->n_runs++], run);
+}
+
+int ltcindex_stat(struct ltcindex *idx, const char *audiofile) {
+	struct stat st;
+	if (stat(audiofile, &st)) {
+		return -1;
+	}
+	idx->file_size = st.st_size;
+	idx->file_mtime = st.st_mtim.tv_sec;
+	idx->file_mtime_ns = st.st_mtim.tv_nsec;
+	return 0;
+}
+
+int ltcindex_is_current(const struct ltcindex *idx, const char *audiofile) {
+	struct ltcindex cur;
+	ltcindex_init(&cur);
+	if (ltcindex_stat(&cur, audiofile)) {
+		return 0;
+	}
+	return cur.file_size == idx->file_size
+		&& cur.file_mtime == idx->file_mtime
+		&& cur.file_mtime_ns == idx->file_mtime_ns;
+}
+
+int ltcindex_write(const struct ltcindex *idx, const char *path) {
+	uint8_t hdr[HEADER_SIZE];
+	uint8_t rec[RUN_SIZE];
+	uint32_t i;
+	char *tmp;
+	FILE *f;
+
+	/* write to a temporary file first, a reader never sees a partial index */
+	tmp = malloc(strlen(path) + 5);
+	sprintf(tmp, "%s.tmp", path);
+	f = fopen(tmp, "wb");
+	if (!f) {
+		free(tmp);
+		return -1;
+	}
+
+	memset(hdr, 0, sizeof(hdr));
+	memcpy(hdr, "LTCINDEX", 8);
+	wr_le(hdr + 8, LTCINDEX_VERSION, 4);
+	wr_le(hdr + 12, idx->samplerate, 4);
+	wr_le(hdr + 16, idx->file_size, 8);
+	wr_le(hdr + 24, idx->file_mtime, 8);
+	wr_le(hdr + 32, idx->file_mtime_ns, 4);
+	wr_le(hdr + 36, idx->n_runs, 4);
+	fwrite(hdr, HEADER_SIZE, 1, f);
+
+	for (i = 0; i < idx->n_runs; ++i) {
+		const struct ltcindex_run *r = &idx->runs[i];
+		wr_le(rec, r->start_sample, 8);
+		wr_le(rec + 8, r->end_sample, 8);
+		wr_le(rec + 16, r->start_frame, 8);
+		wr_le(rec + 24, r->n_frames, 4);
+		rec[28] = r->fps;
+		rec[29] = r->drop;
+		rec[30] = r->reverse;
+		rec[31] = r->end;
+		fwrite(rec, RUN_SIZE, 1, f);
+	}
+
+	if (ferror(f) | fclose(f) || rename(tmp, path)) {
+		unlink(tmp);
+		free(tmp);
+		return -1;
+	}
+	free(tmp);
+	return 0;
+}
+
+/* lowest and highest timecode of a run, in seconds.
+ * a run that wraps at midnight ends after 24:00:00 */
+static void run_span(const struct ltcindex_run *r, int64_t *lo, int64_t *hi) {
+	const int64_t day = smpte_to_framecnt(r->fps, r->drop, 24, 0, 0, 0);
+	int64_t first = r->start_frame;
+	int h, m, s, f;
+
+	if (r->reverse) {
+		first -= r->n_frames - 1;
+		if (first < 0) first += day;
+	}
+	framecnt_to_smpte(r->fps, r->drop, first, &h, &m, &s, &f);
+	*lo = (h * 60 + m) * 60 + s;
+	*hi = *lo + (r->n_frames + r->fps - 1) / r->fps + 1;
+}
+
+/* sort key of by_tc: the run's lowest timecode, then the run's order in the file */
+struct tc_key {
+	int64_t lo;
+	uint32_t run;
+};
+
+static int cmp_tc_key(const void *a, const void *b) {
+	const struct tc_key *ka = (const struct tc_key *) a;
+	const struct tc_key *kb = (const struct tc_key *) b;
+	if (ka->lo != kb->lo) return ka->lo < kb->lo ? -1 : 1;
+	return ka->run < kb->run ? -1 : (ka->run > kb->run ? 1 : 0);
+}
+
+int ltcindex_read(struct ltcindex *idx, const char *path) {
+	uint8_t hdr[HEADER_SIZE];
+	uint8_t rec[RUN_SIZE];
+	struct tc_key *keys;
+	uint32_t i, n;
+	FILE *f;
+
+	ltcindex_init(idx);
+	f = fopen(path, "rb");
+	if (!f) {
+		return -1;
+	}
+	if (fread(hdr, HEADER_SIZE, 1, f) != 1
+			|| memcmp(hdr, "LTCINDEX", 8)
+			|| rd_le(hdr + 8, 4) != LTCINDEX_VERSION) {
+		fclose(f);
+		return -1;
+	}
+	idx->samplerate = rd_le(hdr + 12, 4);
+	idx->file_size = rd_le(hdr + 16, 8);
+	idx->file_mtime = rd_le(hdr + 24, 8);
+	idx->file_mtime_ns = rd_le(hdr + 32, 4);
+	n = rd_le(hdr + 36, 4);
+
+	idx->runs = malloc((n > 0 ? n : 1) * sizeof(struct ltcindex_run));
+	idx->by_tc = malloc((n > 0 ? n : 1) * sizeof(uint32_t));
+	idx->n_alloc = n;
+	keys = malloc((n > 0 ? n : 1) * sizeof(struct tc_key));
+	for (i = 0; i < n; ++i) {
+		struct ltcindex_run *r = &idx->runs[i];
+		int64_t lo, hi;
+		if (fread(rec, RUN_SIZE, 1, f) != 1) {
+			fclose(f);
+			free(keys);
+			ltcindex_free(idx);
+			return -1;
+		}
+		r->start_sample = rd_le(rec, 8);
+		r->end_sample = rd_le(rec + 8, 8);
+		r->start_frame = rd_le(rec + 16, 8);
+		r->n_frames = rd_le(rec + 24, 4);
+		r->fps = rec[28];
+		r->drop = rec[29];
+		r->reverse = rec[30];
+		r->end = rec[31];
+		if (r->fps == 0 || r->n_frames == 0) {
+			fclose(f);
+			free(keys);
+			ltcindex_free(idx);
+			return -1;
+		}
+		idx->n_runs = i + 1;
+		run_span(r, &lo, &hi);
+		if (hi - lo > idx->max_span) idx->max_span = hi - lo;
+		keys[i].lo = lo;
+		keys[i].run = i;
+	}
+	fclose(f);
+
+	qsort(keys, idx->n_runs, sizeof(struct tc_key), cmp_tc_key);
+	for (i = 0; i < idx->n_runs; ++i) {
+		idx->by_tc[i] = keys[i].run;
+	}
+	free(keys);
+	return 0;
+}
+
+/* position of frame k (first = 0) in a run */
+static int64_t run_sample(const struct ltcindex_run *r, int64_t k) {
+	const double spf = (double)(r->end_sample - r->start_sample + 1) / r->n_frames;
+	return r->start_sample + (int64_t)(k * spf + .5);
+}
+
+/* find the audio-sample(s) at which a timecode occurs.
+ * cb is called for every run that contains it, with the off_start of the frame.
+ * returns the number of matches.
+ */
+int ltcindex_find_sample(const struct ltcindex *idx, int h, int m, int s, int f,
+		int (*cb)(void *arg, const struct ltcindex_run *run, int64_t sample), void *arg) {
+	int found = 0;
+	int pass;
+
+	/* the second pass finds runs which wrap at midnight */
+	for (pass = 0; pass < 2; ++pass) {
+		const int64_t q = (h * 60 + m) * 60 + s + pass * 86400;
+		int64_t lo, hi;
+		uint32_t a = 0, b = idx->n_runs;
+
+		/* first run which starts after q */
+		while (a < b) {
+			const uint32_t mid = (a + b) / 2;
+			run_span(&idx->runs[idx->by_tc[mid]], &lo, &hi);
+			if (lo <= q) a = mid + 1; else b = mid;
+		}
+
+		/* check all runs which may contain q */
+		while (a-- > 0) {
+			const struct ltcindex_run *r = &idx->runs[idx->by_tc[a]];
+			const int64_t day = smpte_to_framecnt(r->fps, r->drop, 24, 0, 0, 0);
+			int64_t k;
+
+			run_span(r, &lo, &hi);
+			if (lo + idx->max_span < q) break;
+			if (hi < q) continue;
+			if (pass == 1 && hi < 86400) continue;
+
+			k = smpte_to_framecnt(r->fps, r->drop, h, m, s, f);
+			k = r->reverse ? r->start_frame - k : k - r->start_frame;
+			if (k < 0) k += day;
+			if (k >= r->n_frames) continue;
+
+			++found;
+			if (cb && cb(arg, r, run_sample(r, k))) {
+				return found;
+			}
+		}
+	}
+	return found;
+}
+
+/* find the timecode at a given audio-sample.
+ * returns the run and sets *frame to the frame-number (see framecnt_to_smpte()),
+ * or NULL if there is no LTC at that position.
+ */
+const struct ltcindex_run *ltcindex_find_tc(const struct ltcindex *idx, int64_t sample, int64_t *frame) {
+	const struct ltcindex_run *r;
+	uint32_t a = 0, b = idx->n_runs;
+	int64_t k, day;
+
+	/* last run which starts at or before sample */
+	while (a < b) {
+		const uint32_t mid = (a + b) / 2;
+		if (idx->runs[mid].start_sample <= sample) a = mid + 1; else b = mid;
+	}
+	if (a == 0) {
+		return NULL;
+	}
+	r = &idx->runs[a - 1];
+	if (sample > r->end_sample) {
+		return NULL;
+	}
+
+	k = (sample - r->start_sample) * (int64_t) r->n_frames / (r->end_sample - r->start_sample + 1);
+	day = smpte_to_framecnt(r->fps, r->drop, 24, 0, 0, 0);
+	*frame = r->reverse ? r->start_frame - k : r->start_frame + k;
+	*frame = ((*frame % day) + day) % day;
+	return r;
+}
@@ -0,0 +1,49 @@
+#ifndef LTCINDEX_H
+#define LTCINDEX_H
+
+#include <stdint.h>
+#include "ltcrun.h"
+
+#define LTCINDEX_SUFFIX ".ltcidx"
+
+/* one entry per run of continuous timecode */
+struct ltcindex_run {
+	int64_t  start_sample; ///< off_start of the first frame
+	int64_t  end_sample;   ///< off_end of the last frame
+	int64_t  start_frame;  ///< frame-number of the first timecode, see smpte_to_framecnt()
+	uint32_t n_frames;
+	uint8_t  fps;
+	uint8_t  drop;
+	uint8_t  reverse;
+	uint8_t  end;          ///< enum LTCRUN_END
+};
+
+struct ltcindex {
+	uint64_t file_size;
+	int64_t  file_mtime;
+	uint32_t file_mtime_ns;
+	uint32_t samplerate;
+
+	struct ltcindex_run *runs; ///< in file order
+	uint32_t n_runs;
+	uint32_t n_alloc;
+
+	/* lookup table, created by ltcindex_read() */
+	uint32_t *by_tc;   ///< run-indices sorted by lowest timecode
+	int64_t max_span;  ///< longest run, in seconds
+};
+
+void ltcindex_init(struct ltcindex *idx);
+void ltcindex_free(struct ltcindex *idx);
+void ltcindex_run_set(struct ltcindex_run *r, const struct ltcrun *run);
+void ltcindex_add(struct ltcindex *idx, const struct ltcrun *run);
+
+int ltcindex_stat(struct ltcindex *idx, const char *audiofile);
+int ltcindex_is_current(const struct ltcindex *idx, const char *audiofile);
+int ltcindex_write(const struct ltcindex *idx, const char *path);
+int ltcindex_read(struct ltcindex *idx, const char *path);
+
+int ltcindex_find_sample(const struct ltcindex *idx, int h, int m, int s, int f, int (*cb)(void *arg, const struct ltcindex_run *run, int64_t sample), void *arg);
+const struct ltcindex_run *ltcindex_find_tc(const struct ltcindex *idx, int64_t sample, int64_t *frame);
+
+#endif
@@ -0,0 +1,164 @@
+/* timecode at sample 0 and drift, from a linear fit of the LTC
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Fit a line through (frame-number, off_start) of continuous timecode
+ * and extrapolate it to sample 0. The fit is updated frame by frame
+ * (Welford) and decoding stops as soon as the 95% confidence intervals of
+ * the extrapolated position and of the drift are narrower than
+ * ORIGIN_MAX_ERROR samples and ORIGIN_MAX_DRIFT ppm.
+ */
+
+#include <string.h>
+#include <math.h>
+#include "ltcorigin.h"
+#include "ltcframeutil.h"
+#include "timecode.h"
+
+#define LTCORIGIN_QUEUE_LENGTH 16
+
+#define ORIGIN_MIN_FRAMES 25
+#define ORIGIN_MAX_ERROR  1.0 ///< in samples
+#define ORIGIN_MAX_DRIFT  5.0 ///< in ppm
+
+struct ltcfit {
+	long long int n0;  ///< frame-number of the first frame, x is relative to it
+	int n;
+	double mx, my;
+	double cxx, cxy, cyy;
+};
+
+static void fit_reset(struct ltcfit *fit) {
+	memset(fit, 0, sizeof(struct ltcfit));
+}
+
+static void fit_add(struct ltcfit *fit, long long int fcnt, double pos) {
+	double dx, dy, x;
+	if (fit->n == 0) {
+		fit->n0 = fcnt;
+	}
+	x = fcnt - fit->n0;
+	++fit->n;
+	dx = x - fit->mx;
+	fit->mx += dx / fit->n;
+	dy = pos - fit->my;
+	fit->my += dy / fit->n;
+	fit->cxx += dx * (x - fit->mx);
+	fit->cxy += dx * (pos - fit->my);
+	fit->cyy += dy * (pos - fit->my);
+}
+
+/* extrapolate to sample 0.
+ * x0: frame-number at sample 0, spf: samples per frame,
+ * err: 95% confidence of the position in samples.
+ * returns -1 if there are not enough frames for a fit.
+ */
+static int fit_origin(struct ltcfit *fit, double *x0, double *spf, double *spf_err, double *err) {
+	double b, a, s2, x;
+	if (fit->n < 3 || fit->cxx <= 0) {
+		return -1;
+	}
+	b = fit->cxy / fit->cxx;
+	if (b == 0) {
+		return -1;
+	}
+	a = fit->my - b * fit->mx;
+	s2 = (fit->cyy - b * fit->cxy) / (fit->n - 2);
+	if (s2 < 0) s2 = 0;
+	x = -a / b;
+	*x0 = fit->n0 + x;
+	*spf = b;
+	*spf_err = 2.0 * sqrt(s2 / fit->cxx);
+	*err = 2.0 * sqrt(s2 * (1.0 / fit->n + (x - fit->mx) * (x - fit->mx) / fit->cxx));
+	return 0;
+}
+
+/* decode the given channel (first = 0) from the start of src until the
+ * fit of the timecode origin converges, or to the end of the file.
+ * The frame-numbers only make a line at the right framerate, it is
+ * detected from the frame period unless it matches fps_num/fps_den.
+ * returns -1 if there was not enough continuous LTC for a fit, in that
+ * case only fps, df and n_reset of the result are set.
+ */
+int ltcorigin_fit(struct ltcsource *src, ltcsnd_sample_t *sound, int channel, int fps_num, int fps_den, struct ltcorigin *o) {
+	struct ltcfit fit;
+	LTCDecoder *decoder;
+	LTCFpsDetector fps_detector;
+	LTCFrameExt frame, prev;
+	int fps = ceil((double)fps_num / fps_den);
+	double x0, spf, spf_err, err = 0, nominal, day;
+	int have_prev = 0, df = 0, converged = 0;
+
+	memset(o, 0, sizeof(struct ltcorigin));
+	nominal = (double) src->sfinfo.samplerate * fps_den / fps_num;
+	fit_reset(&fit);
+	fps_detector_init(&fps_detector, src->sfinfo.samplerate);
+	decoder = ltc_decoder_create(src->sfinfo.samplerate * fps_den / fps_num, LTCORIGIN_QUEUE_LENGTH);
+
+	while (!converged && ltcsource_read(src, LTCSOURCE_BUFFER_SIZE) > 0) {
+		ltcsource_channel(src, channel, sound);
+		ltc_decoder_write(decoder, sound, src->n, src->pos);
+
+		while (!converged && ltc_decoder_read(decoder, &frame)) {
+			SMPTETimecode stime;
+			ltc_frame_to_time(&stime, &frame.ltc, 0);
+			if (fps_detector_add(&fps_detector, &fps, &frame, &stime, NULL) & LTC_FPS_CHANGED) {
+				/* drop-frame timecode implies 29.97 fps */
+				fps_num = (frame.ltc.dfbit && fps == 30) ? 30000 : fps;
+				fps_den = (frame.ltc.dfbit && fps == 30) ? 1001 : 1;
+				nominal = (double) src->sfinfo.samplerate * fps_den / fps_num;
+				fit_reset(&fit);
+			}
+			if (have_prev && (frame.reverse != prev.reverse || frame.ltc.dfbit != df
+						|| detect_discontinuity(&frame, &prev, fps, 0, 0))) {
+				/* the fit only holds for continuous timecode, start over */
+				fit_reset(&fit);
+				++o->n_reset;
+			}
+			memcpy(&prev, &frame, sizeof(LTCFrameExt));
+			have_prev = 1;
+			df = frame.ltc.dfbit;
+
+			fit_add(&fit, smpte_to_framecnt(fps, df, stime.hours, stime.mins, stime.secs, stime.frame), frame.off_start);
+			if (fit.n >= ORIGIN_MIN_FRAMES && !fit_origin(&fit, &x0, &spf, &spf_err, &err)
+					&& err < ORIGIN_MAX_ERROR && spf_err / nominal * 1e6 < ORIGIN_MAX_DRIFT) {
+				converged = 1;
+			}
+		}
+	}
+	ltc_decoder_free(decoder);
+
+	o->fps = fps;
+	o->fps_num = fps_num;
+	o->fps_den = fps_den;
+	o->df = df;
+	o->samplerate = src->sfinfo.samplerate;
+	o->decoded = src->pos + src->n;
+
+	if (fit_origin(&fit, &x0, &spf, &spf_err, &err)) {
+		return -1;
+	}
+
+	/* wrap around midnight */
+	day = smpte_to_framecnt(fps, df, 24, 0, 0, 0);
+	o->x0 = fmod(x0, day);
+	if (o->x0 < 0) o->x0 += day;
+	o->err = err;
+	o->drift = (fabs(spf) / nominal - 1.0) * 1e6;
+	o->drift_err = spf_err / nominal * 1e6;
+	o->n_frames = fit.n;
+	o->converged = converged;
+	return 0;
+}
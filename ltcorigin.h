@@ -0,0 +1,26 @@
+#ifndef LTCORIGIN_H
+#define LTCORIGIN_H
+
+#include <ltc.h>
+#include "ltcsource.h"
+
+/* timecode origin, see ltcorigin.c */
+struct ltcorigin {
+	double x0;      ///< frame-number at sample 0, wrapped to [0, 24h)
+	double err;     ///< 95% confidence of the position, in samples
+	double drift;   ///< ppm
+	double drift_err;
+	int n_frames;   ///< used for the fit
+	int n_reset;    ///< timecode discontinuities, the fit started over
+	int fps;        ///< nominal
+	int fps_num;    ///< exact, detected if the LTC does not match -f
+	int fps_den;
+	int df;
+	int samplerate;
+	int converged;
+	sf_count_t decoded; ///< audio-frames read
+};
+
+int ltcorigin_fit(struct ltcsource *src, ltcsnd_sample_t *sound, int channel, int fps_num, int fps_den, struct ltcorigin *o);
+
+#endif
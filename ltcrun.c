@@ -0,0 +1,80 @@
+/* track runs of continuous timecode
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include "ltcrun.h"
+#include "ltcframeutil.h"
+
+void ltcrun_init(struct ltcrun_tracker *rt, long int frame_length, int use_date) {
+	memset(rt, 0, sizeof(struct ltcrun_tracker));
+	rt->frame_length = frame_length;
+	rt->use_date = use_date;
+}
+
+static void ltcrun_start(struct ltcrun_tracker *rt, LTCFrameExt *frame, int fps) {
+	memcpy(&rt->run.first, frame, sizeof(LTCFrameExt));
+	memcpy(&rt->run.last, frame, sizeof(LTCFrameExt));
+	memcpy(&rt->prev, frame, sizeof(LTCFrameExt));
+	rt->run.n_frames = 1;
+	rt->run.fps = fps;
+	rt->run.end = LTCRUN_EOF;
+	rt->active = 1;
+}
+
+/* add a decoded frame.
+ * returns 1 if the frame ends the current run, which is then copied to *done
+ * and a new run is started with the given frame. 0 otherwise.
+ */
+int ltcrun_add(struct ltcrun_tracker *rt, LTCFrameExt *frame, int fps, struct ltcrun *done) {
+	int end = -1;
+
+	if (!rt->active) {
+		ltcrun_start(rt, frame, fps);
+		return 0;
+	}
+
+	if (frame->off_start - rt->prev.off_end > rt->frame_length / 2) {
+		end = LTCRUN_DROPOUT;
+	}
+	else if (frame->reverse != rt->prev.reverse || fps != rt->run.fps) {
+		end = LTCRUN_DISCONTINUITY;
+	}
+	else if (detect_discontinuity(frame, &rt->prev, fps, rt->use_date, 0)) {
+		end = LTCRUN_DISCONTINUITY;
+	}
+
+	if (end < 0) {
+		memcpy(&rt->run.last, frame, sizeof(LTCFrameExt));
+		rt->run.n_frames++;
+		return 0;
+	}
+
+	memcpy(done, &rt->run, sizeof(struct ltcrun));
+	done->end = end;
+	ltcrun_start(rt, frame, fps);
+	return 1;
+}
+
+/* end of input: returns 1 and copies the current run to *done, if any */
+int ltcrun_flush(struct ltcrun_tracker *rt, struct ltcrun *done) {
+	if (!rt->active) {
+		return 0;
+	}
+	memcpy(done, &rt->run, sizeof(struct ltcrun));
+	done->end = LTCRUN_EOF;
+	rt->active = 0;
+	return 1;
+}
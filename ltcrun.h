@@ -0,0 +1,35 @@
+#ifndef LTCRUN_H
+#define LTCRUN_H
+
+#include <stdint.h>
+#include <ltc.h>
+
+/* why a run of continuous timecode ended */
+enum LTCRUN_END {
+	LTCRUN_EOF = 0,        ///< end of input
+	LTCRUN_DISCONTINUITY,  ///< timecode jump, direction or framerate change
+	LTCRUN_DROPOUT,        ///< no LTC signal
+};
+
+/* a run of continuous timecode */
+struct ltcrun {
+	LTCFrameExt first;
+	LTCFrameExt last;
+	uint32_t n_frames;
+	int fps;      ///< nominal framerate (rounded up)
+	int end;      ///< enum LTCRUN_END
+};
+
+struct ltcrun_tracker {
+	struct ltcrun run;
+	LTCFrameExt prev;
+	int active;
+	int use_date;
+	long int frame_length; ///< audio-samples per LTC frame
+};
+
+void ltcrun_init(struct ltcrun_tracker *rt, long int frame_length, int use_date);
+int ltcrun_add(struct ltcrun_tracker *rt, LTCFrameExt *frame, int fps, struct ltcrun *done);
+int ltcrun_flush(struct ltcrun_tracker *rt, struct ltcrun *done);
+
+#endif
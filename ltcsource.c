@@ -0,0 +1,292 @@
+/* audio input for the LTC decoder, with optional read-ahead
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ltcsource.h"
+#include "sampleconv.h"
+
+static float *buf_interleaved(struct ltcsource_buf *buf, int channels) {
+	if (channels > buf->channels) {
+		free(buf->interleaved);
+		buf->interleaved = calloc(channels * LTCSOURCE_BUFFER_SIZE, sizeof(float));
+		buf->channels = channels;
+	}
+	return buf->interleaved;
+}
+
+void ltcsource_buf_free(struct ltcsource_buf *buf) {
+	free(buf->interleaved);
+	buf->interleaved = NULL;
+	buf->channels = 0;
+}
+
+/* PCM16, PCM24 and float32 WAV/RF64 files are memory-mapped if allow_map
+ * is set, other files are read using libsndfile, into buf if given.
+ */
+int ltcsource_open(struct ltcsource *src, const char *filename, int allow_map, struct ltcsource_buf *buf) {
+	memset(src, 0, sizeof(struct ltcsource));
+	src->wm.fd = -1;
+	src->allow_map = allow_map;
+	src->buf = buf;
+
+	if (allow_map && !wavmap_open(&src->wm, filename)) {
+		src->use_map = 1;
+		src->sfinfo.frames = src->wm.info.frames;
+		src->sfinfo.samplerate = src->wm.info.samplerate;
+		src->sfinfo.channels = src->wm.info.channels;
+		src->sfinfo.seekable = 1;
+		return 0;
+	}
+
+	src->sf = sf_open(filename, SFM_READ, &src->sfinfo);
+	if (SF_ERR_NO_ERROR != sf_error(src->sf)) {
+		return -1;
+	}
+	if (buf) {
+		src->interleaved = buf_interleaved(buf, src->sfinfo.channels);
+	} else {
+		src->interleaved = calloc(src->sfinfo.channels * LTCSOURCE_BUFFER_SIZE, sizeof(float));
+		src->own_buffer = 1;
+	}
+	return 0;
+}
+
+/* open the file again with the same settings, e.g. to pick up a new length */
+int ltcsource_reopen(struct ltcsource *src, const char *filename) {
+	const int allow_map = src->allow_map;
+	struct ltcsource_buf *buf = src->buf;
+	ltcsource_close(src);
+	return ltcsource_open(src, filename, allow_map, buf);
+}
+
+void ltcsource_close(struct ltcsource *src) {
+	if (src->use_map) {
+		wavmap_close(&src->wm);
+	}
+	if (src->sf) {
+		sf_close(src->sf);
+	}
+	if (src->own_buffer) {
+		free(src->interleaved);
+	}
+	src->sf = NULL;
+	src->interleaved = NULL;
+}
+
+int ltcsource_seek(struct ltcsource *src, sf_count_t pos) {
+	if (!src->use_map && sf_seek(src->sf, pos, SEEK_SET) != pos) {
+		return -1;
+	}
+	src->pos = pos;
+	src->n = 0;
+	return 0;
+}
+
+/* read the next block of at most max_frames (<= LTCSOURCE_BUFFER_SIZE) */
+sf_count_t ltcsource_read(struct ltcsource *src, sf_count_t max_frames) {
+	src->pos += src->n;
+	if (src->use_map) {
+		src->n = src->sfinfo.frames - src->pos;
+		if (src->n > max_frames) src->n = max_frames;
+		if (src->n < 0) src->n = 0;
+	} else {
+		src->n = sf_readf_float(src->sf, src->interleaved, max_frames);
+		if (src->n < 0) src->n = 0;
+	}
+	return src->n;
+}
+
+/* convert the given channel (first = 0) of the current block */
+void ltcsource_channel(struct ltcsource *src, int channel, ltcsnd_sample_t *sound) {
+	if (src->use_map) {
+		wavmap_read(&src->wm, sound, src->pos, src->n, channel);
+		return;
+	}
+	conv_float_trunc(sound, src->interleaved + channel, src->n, src->sfinfo.channels);
+}
+
+/* as ltcsource_channel(), as float, for the decimator */
+void ltcsource_channel_float(struct ltcsource *src, int channel, float *out) {
+	sf_count_t i;
+	if (src->use_map) {
+		wavmap_read_float(&src->wm, out, src->pos, src->n, channel);
+		return;
+	}
+	for (i = 0; i < src->n; ++i) {
+		out[i] = src->interleaved[i * src->sfinfo.channels + channel];
+	}
+}
+
+/* read-ahead
+ *
+ * ltcreadahead_read() hands out the blocks in pieces of at most
+ * LTCSOURCE_BUFFER_SIZE, so the decoder sees the same block boundaries
+ * as with ltcsource_read().
+ * For memory-mapped files the thread pre-faults the pages instead.
+ */
+
+static void *readahead_thread(void *arg) {
+	struct ltcreadahead *ra = (struct ltcreadahead *) arg;
+	struct ltcsource *src = ra->src;
+	sf_count_t pos = ra->start;
+
+	for (;;) {
+		struct ltcsource_rablock *blk;
+		sf_count_t n;
+
+		pthread_mutex_lock(&ra->lock);
+		while (ra->filled == LTC_READAHEAD_BLOCKS && !ra->stop) {
+			pthread_cond_wait(&ra->cond, &ra->lock);
+		}
+		if (ra->stop) {
+			pthread_mutex_unlock(&ra->lock);
+			break;
+		}
+		blk = &ra->blocks[ra->wr];
+		pthread_mutex_unlock(&ra->lock);
+
+		n = ra->end - pos;
+		if (n > ra->blocksize) n = ra->blocksize;
+		if (src->use_map) {
+			const size_t stride = src->wm.info.channels * src->wm.info.bytes_per_sample;
+			const volatile uint8_t *p;
+			size_t i;
+			if (n > src->sfinfo.frames - pos) n = src->sfinfo.frames - pos;
+			if (n < 0) n = 0;
+			p = src->wm.data + pos * stride;
+			for (i = 0; i < n * stride; i += 4096) {
+				(void) p[i];
+			}
+		} else if (n > 0) {
+			n = sf_readf_float(src->sf, blk->buf, n);
+		}
+		if (n < 0) n = 0;
+		blk->pos = pos;
+		blk->n = n;
+		pos += n;
+
+		pthread_mutex_lock(&ra->lock);
+		ra->wr = (ra->wr + 1) % LTC_READAHEAD_BLOCKS;
+		++ra->filled;
+		pthread_cond_broadcast(&ra->cond);
+		pthread_mutex_unlock(&ra->lock);
+
+		if (n == 0) {
+			break;
+		}
+	}
+	return NULL;
+}
+
+/* start reading at the source's current position, up to end.
+ * ra->wait accumulates over consecutive runs.
+ */
+int ltcreadahead_start(struct ltcreadahead *ra, struct ltcsource *src, sf_count_t end, sf_count_t blocksize) {
+	const double wait = ra->wait;
+	int i;
+
+	memset(ra, 0, sizeof(struct ltcreadahead));
+	ra->wait = wait;
+	ra->src = src;
+	ra->interleaved = src->interleaved;
+	ra->start = src->pos + src->n;
+	ra->end = end;
+	ra->blocksize = blocksize;
+	if (!src->use_map) {
+		for (i = 0; i < LTC_READAHEAD_BLOCKS; ++i) {
+			ra->blocks[i].buf = malloc(ra->blocksize * src->sfinfo.channels * sizeof(float));
+		}
+	}
+	pthread_mutex_init(&ra->lock, NULL);
+	pthread_cond_init(&ra->cond, NULL);
+	if (pthread_create(&ra->thread, NULL, readahead_thread, ra)) {
+		fprintf(stderr, "Error: cannot create reader thread\n");
+		pthread_mutex_destroy(&ra->lock);
+		pthread_cond_destroy(&ra->cond);
+		for (i = 0; i < LTC_READAHEAD_BLOCKS; ++i) {
+			free(ra->blocks[i].buf);
+		}
+		return -1;
+	}
+	return 0;
+}
+
+void ltcreadahead_stop(struct ltcreadahead *ra) {
+	int i;
+	pthread_mutex_lock(&ra->lock);
+	ra->stop = 1;
+	pthread_cond_broadcast(&ra->cond);
+	pthread_mutex_unlock(&ra->lock);
+	pthread_join(ra->thread, NULL);
+	pthread_mutex_destroy(&ra->lock);
+	pthread_cond_destroy(&ra->cond);
+	for (i = 0; i < LTC_READAHEAD_BLOCKS; ++i) {
+		free(ra->blocks[i].buf);
+	}
+	ra->src->interleaved = ra->interleaved;
+}
+
+/* drop-in replacement for ltcsource_read() */
+sf_count_t ltcreadahead_read(struct ltcreadahead *ra, sf_count_t max_frames) {
+	struct ltcsource *src = ra->src;
+	sf_count_t n;
+
+	src->pos += src->n;
+	src->n = 0;
+
+	while (!ra->cur || ra->off >= ra->cur->n) {
+		pthread_mutex_lock(&ra->lock);
+		if (ra->cur) {
+			/* hand the block back to the reader */
+			ra->cur = NULL;
+			ra->rd = (ra->rd + 1) % LTC_READAHEAD_BLOCKS;
+			--ra->filled;
+			pthread_cond_broadcast(&ra->cond);
+		}
+		if (ra->eof) {
+			pthread_mutex_unlock(&ra->lock);
+			return 0;
+		}
+		if (ra->filled == 0) {
+			struct timespec t0, t1;
+			clock_gettime(CLOCK_MONOTONIC, &t0);
+			while (ra->filled == 0) {
+				pthread_cond_wait(&ra->cond, &ra->lock);
+			}
+			clock_gettime(CLOCK_MONOTONIC, &t1);
+			ra->wait += (t1.tv_sec - t0.tv_sec) + 1e-9 * (t1.tv_nsec - t0.tv_nsec);
+		}
+		ra->cur = &ra->blocks[ra->rd];
+		ra->off = 0;
+		if (ra->cur->n == 0) {
+			ra->eof = 1;
+		}
+		pthread_mutex_unlock(&ra->lock);
+	}
+
+	n = ra->cur->n - ra->off;
+	if (n > max_frames) n = max_frames;
+	src->pos = ra->cur->pos + ra->off;
+	src->n = n;
+	if (!src->use_map) {
+		src->interleaved = ra->cur->buf + ra->off * src->sfinfo.channels;
+	}
+	ra->off += n;
+	return n;
+}
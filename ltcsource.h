@@ -0,0 +1,76 @@
+#ifndef LTCSOURCE_H
+#define LTCSOURCE_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include <sndfile.h>
+#include <ltc.h>
+
+#include "wavfile.h"
+
+#define LTCSOURCE_BUFFER_SIZE 1024 ///< max. audio-frames per block
+
+/* read-buffer for libsndfile, can be shared by consecutive sources */
+struct ltcsource_buf {
+	float *interleaved;
+	int channels; ///< allocated size, in channels
+};
+
+/* audio source: memory-mapped PCM file or libsndfile */
+struct ltcsource {
+	SNDFILE *sf;
+	SF_INFO sfinfo;
+	struct wavmap wm;
+	int use_map;
+	int allow_map;
+	struct ltcsource_buf *buf; ///< NULL: own buffer
+	float *interleaved;
+	int own_buffer;
+	sf_count_t pos; ///< file-position of the current block
+	sf_count_t n;   ///< audio-frames in the current block
+};
+
+int ltcsource_open(struct ltcsource *src, const char *filename, int allow_map, struct ltcsource_buf *buf);
+int ltcsource_reopen(struct ltcsource *src, const char *filename);
+void ltcsource_close(struct ltcsource *src);
+int ltcsource_seek(struct ltcsource *src, sf_count_t pos);
+sf_count_t ltcsource_read(struct ltcsource *src, sf_count_t max_frames);
+void ltcsource_channel(struct ltcsource *src, int channel, ltcsnd_sample_t *sound);
+void ltcsource_channel_float(struct ltcsource *src, int channel, float *out);
+void ltcsource_buf_free(struct ltcsource_buf *buf);
+
+/* read-ahead: a reader thread fills LTC_READAHEAD_BLOCKS blocks of
+ * blocksize audio-frames while the decoder works on the current one.
+ */
+
+#define LTC_READAHEAD_BLOCKS 3
+#define LTC_READAHEAD_DEFAULT_BLOCKSIZE 65536
+
+struct ltcsource_rablock {
+	float *buf;
+	sf_count_t pos;
+	sf_count_t n;
+};
+
+struct ltcreadahead {
+	struct ltcsource *src;
+	float *interleaved; ///< the source's own buffer, restored on stop
+	sf_count_t start;
+	sf_count_t end;
+	sf_count_t blocksize;
+	struct ltcsource_rablock blocks[LTC_READAHEAD_BLOCKS];
+	int wr, rd, filled;
+	int stop, eof;
+	struct ltcsource_rablock *cur;
+	sf_count_t off; ///< frames of cur already handed out
+	double wait;    ///< seconds the decoder waited for data
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+};
+
+int ltcreadahead_start(struct ltcreadahead *ra, struct ltcsource *src, sf_count_t end, sf_count_t blocksize);
+void ltcreadahead_stop(struct ltcreadahead *ra);
+sf_count_t ltcreadahead_read(struct ltcreadahead *ra, sf_count_t max_frames);
+
+#endif
@@ -0,0 +1,158 @@
+/* table-driven LTC encoder
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "ltcwave.h"
+
+#define SAMPLE_CENTER 128
+#define MAX_SEGMENTS 16 ///< half-bits per byte
+
+/* one segment of the given length, as rendered by libltc */
+static void render(ltcsnd_sample_t *wave, int n, ltcsnd_sample_t tgtval, double tcf) {
+	if (tcf > 0) {
+		ltcsnd_sample_t val = SAMPLE_CENTER;
+		int i, m = (n + 1) >> 1;
+		for (i = 0; i < m; ++i) {
+			val = val + tcf * (tgtval - val);
+			wave[n - i - 1] = wave[i] = val;
+		}
+	} else {
+		memset(wave, tgtval, n);
+	}
+}
+
+int ltcwave_init(struct ltcwave *w, double samplerate, double fps, const short conv[256]) {
+	const double pp = rint(127.0 * pow(10, LTCWAVE_VOLUME_DBFS / 20.0));
+	const double tcf = 1.0 - exp(-1.0 / (samplerate * LTCWAVE_RISE_TIME / 2000000.0 / exp(1.0)));
+	const ltcsnd_sample_t level[2] = { SAMPLE_CENTER - pp, SAMPLE_CENTER + pp };
+	int s, n, i;
+
+	memset(w, 0, sizeof(struct ltcwave));
+	if (samplerate <= 0 || fps <= 0) {
+		return -1;
+	}
+	w->spc = samplerate / (fps * 80.0);
+	w->sph = w->spc / 2.0;
+	w->remainder = 0.5;
+	w->state = 0;
+	w->n_min = floor(w->sph);
+	w->n_max = floor(w->spc) + 1;
+
+	for (s = 0; s < 2; ++s) {
+		const size_t rows = w->n_max - w->n_min + 1;
+		w->raw[s] = calloc(rows * w->n_max, sizeof(ltcsnd_sample_t));
+		w->pcm[s] = calloc(rows * w->n_max, sizeof(short));
+		if (!w->raw[s] || !w->pcm[s]) {
+			ltcwave_free(w);
+			return -1;
+		}
+		for (n = w->n_min; n <= w->n_max; ++n) {
+			ltcsnd_sample_t *raw = w->raw[s] + (n - w->n_min) * w->n_max;
+			short *pcm = w->pcm[s] + (n - w->n_min) * w->n_max;
+			render(raw, n, level[s], tcf);
+			for (i = 0; i < n; ++i) {
+				pcm[i] = conv[raw[i]];
+			}
+		}
+	}
+	return 0;
+}
+
+void ltcwave_free(struct ltcwave *w) {
+	free(w->raw[0]);
+	free(w->raw[1]);
+	free(w->pcm[0]);
+	free(w->pcm[1]);
+	memset(w, 0, sizeof(struct ltcwave));
+}
+
+static int half_bit(struct ltcwave *w, double len) {
+	const int n = (int)(len + w->remainder);
+	w->remainder = len + w->remainder - n;
+	w->state = !w->state;
+	return n;
+}
+
+/* lengths and levels of the segments of one byte, in the order of
+ * libltc's encode_byte(), returns the number of segments */
+static int segments(struct ltcwave *w, uint8_t c, int reverse, int *len, int *level) {
+	unsigned char b = reverse ? 128 : 1;
+	int k = 0;
+	do {
+		if ((c & b) == 0) {
+			len[k] = half_bit(w, w->spc);
+			level[k++] = w->state;
+		} else {
+			len[k] = half_bit(w, w->sph);
+			level[k++] = w->state;
+			len[k] = half_bit(w, w->sph);
+			level[k++] = w->state;
+		}
+		if (reverse)
+			b >>= 1;
+		else
+			b <<= 1;
+	} while (b);
+	return k;
+}
+
+/* advance the encoder by one byte without rendering it,
+ * returns the number of samples the byte takes */
+int ltcwave_byte_length(struct ltcwave *w, uint8_t byte, int reverse) {
+	int len[MAX_SEGMENTS], level[MAX_SEGMENTS];
+	int i, k, off = 0;
+
+	k = segments(w, byte, reverse, len, level);
+	for (i = 0; i < k; ++i) {
+		off += len[i];
+	}
+	return off;
+}
+
+/* encode one byte of a LTCFrame to the output format, returns the number
+ * of samples written, -1 if a segment is out of range */
+int ltcwave_encode_byte(struct ltcwave *w, uint8_t byte, int reverse, short *out) {
+	int len[MAX_SEGMENTS], level[MAX_SEGMENTS];
+	int i, k, off = 0;
+
+	k = segments(w, byte, reverse, len, level);
+	for (i = 0; i < k; ++i) {
+		if (len[i] < w->n_min || len[i] > w->n_max) {
+			return -1;
+		}
+		memcpy(out + off, w->pcm[level[i]] + (len[i] - w->n_min) * w->n_max, len[i] * sizeof(short));
+		off += len[i];
+	}
+	return off;
+}
+
+/* the same, as 8 bit encoder samples (to compare with libltc) */
+int ltcwave_encode_byte_raw(struct ltcwave *w, uint8_t byte, int reverse, ltcsnd_sample_t *out) {
+	int len[MAX_SEGMENTS], level[MAX_SEGMENTS];
+	int i, k, off = 0;
+
+	k = segments(w, byte, reverse, len, level);
+	for (i = 0; i < k; ++i) {
+		if (len[i] < w->n_min || len[i] > w->n_max) {
+			return -1;
+		}
+		memcpy(out + off, w->raw[level[i]] + (len[i] - w->n_min) * w->n_max, len[i]);
+		off += len[i];
+	}
+	return off;
+}
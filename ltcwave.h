@@ -0,0 +1,41 @@
+#ifndef LTCWAVE_H
+#define LTCWAVE_H
+
+#include <stdint.h>
+#include <ltc.h>
+
+/* table-driven LTC encoder, bit-identical to libltc's ltc_encoder_encode_byte().
+ *
+ * libltc writes every half-bit as a segment that starts at the center
+ * and rises (low-pass filtered) towards the high or low level. The
+ * waveform of a segment only depends on its length in samples and on
+ * the level, the length only takes a few different values for a given
+ * sample-rate and framerate. All segments are rendered once, at the
+ * output format, and a frame is built by copying them. Only the segment
+ * lengths are computed per bit, using the same arithmetic as libltc.
+ *
+ * A copy of a struct ltcwave shares the tables with the original and
+ * encodes independently from the copied position (remainder, state).
+ */
+
+#define LTCWAVE_VOLUME_DBFS -3.0 ///< encoder level, see ltc_encoder_set_volume()
+#define LTCWAVE_RISE_TIME   40.0 ///< in usec, see ltc_encoder_set_filter()
+
+struct ltcwave {
+	double spc;       ///< samples per bit
+	double sph;       ///< samples per half-bit
+	double remainder; ///< fractional sample position
+	int state;        ///< current level, 0: low
+	int n_min;        ///< shortest segment, in samples
+	int n_max;
+	ltcsnd_sample_t *raw[2]; ///< [level], rows of n_max samples, one per length
+	short *pcm[2];           ///< the same, converted to the output format
+};
+
+int  ltcwave_init(struct ltcwave *w, double samplerate, double fps, const short conv[256]);
+void ltcwave_free(struct ltcwave *w);
+int  ltcwave_byte_length(struct ltcwave *w, uint8_t byte, int reverse);
+int  ltcwave_encode_byte(struct ltcwave *w, uint8_t byte, int reverse, short *out);
+int  ltcwave_encode_byte_raw(struct ltcwave *w, uint8_t byte, int reverse, ltcsnd_sample_t *out);
+
+#endif
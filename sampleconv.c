@@ -0,0 +1,499 @@
+/* audio-sample to LTC-decoder sample conversion
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* the SIMD kernels must round exactly like the scalar code,
+ * a fused multiply-add would not. */
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize ("fp-contract=off")
+#endif
+
+#include <string.h>
+#include <math.h>
+#include "sampleconv.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define HAVE_NEON_KERNELS
+#include <arm_neon.h>
+#endif
+
+/*****************************************************************************
+ * scalar reference
+ */
+
+static inline ltcsnd_sample_t trunc_u8(const float f) {
+	return (ltcsnd_sample_t)((int32_t)(128 + f * 127) & 0xff);
+}
+
+static inline float rd_s16le(const uint8_t *p) {
+	return (float)(int16_t)(p[0] | (p[1] << 8)) * (1.f / 0x8000);
+}
+
+static inline float rd_s24le(const uint8_t *p) {
+	/* like libsndfile: 24 bit in the upper bits of an int32 */
+	return (float)(int32_t)((p[0] << 8) | (p[1] << 16) | ((uint32_t)p[2] << 24)) * (1.f / 0x80000000);
+}
+
+static inline float rd_f32le(const uint8_t *p) {
+	const uint32_t v = p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+	float f;
+	memcpy(&f, &v, sizeof(float));
+	return f;
+}
+
+void conv_float_trunc_ref(ltcsnd_sample_t *out, const float *in, size_t n, size_t stride) {
+	size_t i;
+	for (i = 0; i < n; ++i) {
+		out[i] = trunc_u8(in[i * stride]);
+	}
+}
+
+void conv_float_rint_ref(ltcsnd_sample_t *out, const float *in, size_t n) {
+	size_t i;
+	for (i = 0; i < n; ++i) {
+		const int snd = (int)rint((127.0 * in[i]) + 128.0);
+		out[i] = (ltcsnd_sample_t)(snd & 0xff);
+	}
+}
+
+void conv_s16le_trunc_ref(ltcsnd_sample_t *out, const uint8_t *in, size_t n, size_t stride) {
+	size_t i;
+	for (i = 0; i < n; ++i, in += stride) {
+		out[i] = trunc_u8(rd_s16le(in));
+	}
+}
+
+void conv_s24le_trunc_ref(ltcsnd_sample_t *out, const uint8_t *in, size_t n, size_t stride) {
+	size_t i;
+	for (i = 0; i < n; ++i, in += stride) {
+		out[i] = trunc_u8(rd_s24le(in));
+	}
+}
+
+void conv_f32le_trunc_ref(ltcsnd_sample_t *out, const uint8_t *in, size_t n, size_t stride) {
+	size_t i;
+	for (i = 0; i < n; ++i, in += stride) {
+		out[i] = trunc_u8(rd_f32le(in));
+	}
+}
+
+void conv_s16le_float(float *out, const uint8_t *in, size_t n, size_t stride) {
+	size_t i;
+	for (i = 0; i < n; ++i, in += stride) {
+		out[i] = rd_s16le(in);
+	}
+}
+
+void conv_s24le_float(float *out, const uint8_t *in, size_t n, size_t stride) {
+	size_t i;
+	for (i = 0; i < n; ++i, in += stride) {
+		out[i] = rd_s24le(in);
+	}
+}
+
+void conv_f32le_float(float *out, const uint8_t *in, size_t n, size_t stride) {
+	size_t i;
+	for (i = 0; i < n; ++i, in += stride) {
+		out[i] = rd_f32le(in);
+	}
+}
+
+/*****************************************************************************
+ * x86 SSE2 / AVX2
+ */
+
+#ifdef HAVE_X86_KERNELS
+
+#define SSE2 __attribute__((target("sse2")))
+#define AVX2 __attribute__((target("avx2")))
+
+SSE2 static inline __m128i sse2_trunc(__m128 f) {
+	f = _mm_add_ps(_mm_mul_ps(f, _mm_set1_ps(127.f)), _mm_set1_ps(128.f));
+	return _mm_and_si128(_mm_cvttps_epi32(f), _mm_set1_epi32(0xff));
+}
+
+SSE2 static inline void sse2_store16(ltcsnd_sample_t *out, __m128i a, __m128i b, __m128i c, __m128i d) {
+	_mm_storeu_si128((__m128i *) out, _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d)));
+}
+
+SSE2 static inline __m128 sse2_load_float(const float *p, size_t s) {
+	if (s == 1) return _mm_loadu_ps(p);
+	return _mm_set_ps(p[3 * s], p[2 * s], p[s], p[0]);
+}
+
+SSE2 static inline __m128 sse2_load_s16le(const uint8_t *p, size_t s) {
+	const __m128i v = _mm_set_epi32(
+			(int16_t)(p[3 * s] | (p[3 * s + 1] << 8)),
+			(int16_t)(p[2 * s] | (p[2 * s + 1] << 8)),
+			(int16_t)(p[s] | (p[s + 1] << 8)),
+			(int16_t)(p[0] | (p[1] << 8)));
+	return _mm_mul_ps(_mm_cvtepi32_ps(v), _mm_set1_ps(1.f / 0x8000));
+}
+
+#define S24(P) (int32_t)(((P)[0] << 8) | ((P)[1] << 16) | ((uint32_t)(P)[2] << 24))
+
+SSE2 static inline __m128 sse2_load_s24le(const uint8_t *p, size_t s) {
+	const __m128i v = _mm_set_epi32(S24(p + 3 * s), S24(p + 2 * s), S24(p + s), S24(p));
+	return _mm_mul_ps(_mm_cvtepi32_ps(v), _mm_set1_ps(1.f / 0x80000000));
+}
+
+SSE2 static inline __m128 sse2_load_f32le(const uint8_t *p, size_t s) {
+	if (s == 4) return _mm_loadu_ps((const float *) p);
+	return _mm_set_ps(rd_f32le(p + 3 * s), rd_f32le(p + 2 * s), rd_f32le(p + s), rd_f32le(p));
+}
+
+SSE2 static void conv_float_trunc_sse2(ltcsnd_sample_t *out, const float *in, size_t n, size_t stride) {
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		const float *p = in + i * stride;
+		sse2_store16(out + i,
+				sse2_trunc(sse2_load_float(p, stride)),
+				sse2_trunc(sse2_load_float(p + 4 * stride, stride)),
+				sse2_trunc(sse2_load_float(p + 8 * stride, stride)),
+				sse2_trunc(sse2_load_float(p + 12 * stride, stride)));
+	}
+	conv_float_trunc_ref(out + i, in + i * stride, n - i, stride);
+}
+
+#define SSE2_CONV_LE(NAME)                                                                     \
+SSE2 static void conv_ ## NAME ## _trunc_sse2(ltcsnd_sample_t *out, const uint8_t *in, size_t n, size_t stride) { \
+	size_t i = 0;                                                                                \
+	for (; i + 16 <= n; i += 16) {                                                               \
+		const uint8_t *p = in + i * stride;                                                        \
+		sse2_store16(out + i,                                                                      \
+				sse2_trunc(sse2_load_ ## NAME(p, stride)),                                             \
+				sse2_trunc(sse2_load_ ## NAME(p + 4 * stride, stride)),                                \
+				sse2_trunc(sse2_load_ ## NAME(p + 8 * stride, stride)),                                \
+				sse2_trunc(sse2_load_ ## NAME(p + 12 * stride, stride)));                              \
+	}                                                                                            \
+	conv_ ## NAME ## _trunc_ref(out + i, in + i * stride, n - i, stride);                        \
+}
+
+SSE2_CONV_LE(s16le)
+SSE2_CONV_LE(s24le)
+SSE2_CONV_LE(f32le)
+
+SSE2 static inline __m128i sse2_rint(const float *p) {
+	const __m128d k127 = _mm_set1_pd(127.0);
+	const __m128d k128 = _mm_set1_pd(128.0);
+	const __m128 f = _mm_loadu_ps(p);
+	const __m128d lo = _mm_add_pd(_mm_mul_pd(_mm_cvtps_pd(f), k127), k128);
+	const __m128d hi = _mm_add_pd(_mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(f, f)), k127), k128);
+	/* cvtpd uses the current rounding mode, same as rint() */
+	const __m128i v = _mm_unpacklo_epi64(_mm_cvtpd_epi32(lo), _mm_cvtpd_epi32(hi));
+	return _mm_and_si128(v, _mm_set1_epi32(0xff));
+}
+
+SSE2 static void conv_float_rint_sse2(ltcsnd_sample_t *out, const float *in, size_t n) {
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		sse2_store16(out + i,
+				sse2_rint(in + i), sse2_rint(in + i + 4),
+				sse2_rint(in + i + 8), sse2_rint(in + i + 12));
+	}
+	conv_float_rint_ref(out + i, in + i, n - i);
+}
+
+AVX2 static inline __m256i avx2_trunc(__m256 f) {
+	f = _mm256_add_ps(_mm256_mul_ps(f, _mm256_set1_ps(127.f)), _mm256_set1_ps(128.f));
+	return _mm256_and_si256(_mm256_cvttps_epi32(f), _mm256_set1_epi32(0xff));
+}
+
+AVX2 static inline void avx2_store32(ltcsnd_sample_t *out, __m256i a, __m256i b, __m256i c, __m256i d) {
+	/* packs/packus operate per 128 bit lane, restore the order afterwards */
+	const __m256i v = _mm256_packus_epi16(_mm256_packs_epi32(a, b), _mm256_packs_epi32(c, d));
+	_mm256_storeu_si256((__m256i *) out, _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7)));
+}
+
+AVX2 static inline __m256 avx2_load_float(const float *p, __m256i idx, size_t s) {
+	if (s == 1) return _mm256_loadu_ps(p);
+	return _mm256_i32gather_ps(p, idx, 4);
+}
+
+/* the integer gathers load 4 bytes per sample, the caller makes sure
+ * that this does not read beyond the end of the buffer */
+AVX2 static inline __m256 avx2_load_s16le(const uint8_t *p, __m256i idx) {
+	__m256i v = _mm256_i32gather_epi32((const int *) p, idx, 1);
+	v = _mm256_srai_epi32(_mm256_slli_epi32(v, 16), 16);
+	return _mm256_mul_ps(_mm256_cvtepi32_ps(v), _mm256_set1_ps(1.f / 0x8000));
+}
+
+AVX2 static inline __m256 avx2_load_s24le(const uint8_t *p, __m256i idx) {
+	__m256i v = _mm256_i32gather_epi32((const int *) p, idx, 1);
+	v = _mm256_slli_epi32(v, 8);
+	return _mm256_mul_ps(_mm256_cvtepi32_ps(v), _mm256_set1_ps(1.f / 0x80000000));
+}
+
+AVX2 static inline __m256 avx2_load_f32le(const uint8_t *p, __m256i idx, size_t s) {
+	if (s == 4) return _mm256_loadu_ps((const float *) p);
+	return _mm256_castsi256_ps(_mm256_i32gather_epi32((const int *) p, idx, 1));
+}
+
+AVX2 static void conv_float_trunc_avx2(ltcsnd_sample_t *out, const float *in, size_t n, size_t stride) {
+	size_t i = 0;
+	if (stride <= 0x7fffffff / 32) {
+		const __m256i idx = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(stride));
+		for (; i + 32 <= n; i += 32) {
+			const float *p = in + i * stride;
+			avx2_store32(out + i,
+					avx2_trunc(avx2_load_float(p, idx, stride)),
+					avx2_trunc(avx2_load_float(p + 8 * stride, idx, stride)),
+					avx2_trunc(avx2_load_float(p + 16 * stride, idx, stride)),
+					avx2_trunc(avx2_load_float(p + 24 * stride, idx, stride)));
+		}
+	}
+	conv_float_trunc_sse2(out + i, in + i * stride, n - i, stride);
+}
+
+#define AVX2_LOAD_S16LE(P) avx2_load_s16le(P, idx)
+#define AVX2_LOAD_S24LE(P) avx2_load_s24le(P, idx)
+#define AVX2_LOAD_F32LE(P) avx2_load_f32le(P, idx, stride)
+
+#define AVX2_CONV_LE(NAME, LOAD)                                                               \
+AVX2 static void conv_ ## NAME ## _trunc_avx2(ltcsnd_sample_t *out, const uint8_t *in, size_t n, size_t stride) { \
+	size_t i = 0;                                                                                \
+	if (stride <= 0x7fffffff / 32) {                                                             \
+		const __m256i idx = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(stride)); \
+		/* "<" not "<=": the last sample is converted by the SSE2 code */                          \
+		for (; i + 32 < n; i += 32) {                                                              \
+			const uint8_t *p = in + i * stride;                                                      \
+			avx2_store32(out + i,                                                                    \
+					avx2_trunc(LOAD(p)),                                                                 \
+					avx2_trunc(LOAD(p + 8 * stride)),                                                    \
+					avx2_trunc(LOAD(p + 16 * stride)),                                                   \
+					avx2_trunc(LOAD(p + 24 * stride)));                                                  \
+		}                                                                                          \
+	}                                                                                            \
+	conv_ ## NAME ## _trunc_sse2(out + i, in + i * stride, n - i, stride);                       \
+}
+
+AVX2_CONV_LE(s16le, AVX2_LOAD_S16LE)
+AVX2_CONV_LE(s24le, AVX2_LOAD_S24LE)
+AVX2_CONV_LE(f32le, AVX2_LOAD_F32LE)
+
+AVX2 static inline __m128i avx2_rint(const float *p) {
+	__m256d d = _mm256_cvtps_pd(_mm_loadu_ps(p));
+	d = _mm256_add_pd(_mm256_mul_pd(d, _mm256_set1_pd(127.0)), _mm256_set1_pd(128.0));
+	return _mm_and_si128(_mm256_cvtpd_epi32(d), _mm_set1_epi32(0xff));
+}
+
+AVX2 static void conv_float_rint_avx2(ltcsnd_sample_t *out, const float *in, size_t n) {
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		const __m128i a = avx2_rint(in + i);
+		const __m128i b = avx2_rint(in + i + 4);
+		const __m128i c = avx2_rint(in + i + 8);
+		const __m128i d = avx2_rint(in + i + 12);
+		_mm_storeu_si128((__m128i *)(out + i), _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d)));
+	}
+	conv_float_rint_ref(out + i, in + i, n - i);
+}
+
+#endif /* HAVE_X86_KERNELS */
+
+/*****************************************************************************
+ * ARM NEON
+ */
+
+#ifdef HAVE_NEON_KERNELS
+
+static inline int32x4_t neon_trunc(float32x4_t f) {
+	f = vaddq_f32(vmulq_f32(f, vdupq_n_f32(127.f)), vdupq_n_f32(128.f));
+	return vandq_s32(vcvtq_s32_f32(f), vdupq_n_s32(0xff));
+}
+
+static inline void neon_store16(ltcsnd_sample_t *out, int32x4_t a, int32x4_t b, int32x4_t c, int32x4_t d) {
+	const int16x8_t ab = vcombine_s16(vmovn_s32(a), vmovn_s32(b));
+	const int16x8_t cd = vcombine_s16(vmovn_s32(c), vmovn_s32(d));
+	vst1q_u8(out, vcombine_u8(vqmovun_s16(ab), vqmovun_s16(cd)));
+}
+
+static inline float32x4_t neon_load_float(const float *p, size_t s) {
+	float32x4_t f;
+	if (s == 1) return vld1q_f32(p);
+	f = vdupq_n_f32(p[0]);
+	f = vsetq_lane_f32(p[s], f, 1);
+	f = vsetq_lane_f32(p[2 * s], f, 2);
+	f = vsetq_lane_f32(p[3 * s], f, 3);
+	return f;
+}
+
+static inline float32x4_t neon_load_s16le(const uint8_t *p, size_t s) {
+	return (float32x4_t) { rd_s16le(p), rd_s16le(p + s), rd_s16le(p + 2 * s), rd_s16le(p + 3 * s) };
+}
+
+static inline float32x4_t neon_load_s24le(const uint8_t *p, size_t s) {
+	return (float32x4_t) { rd_s24le(p), rd_s24le(p + s), rd_s24le(p + 2 * s), rd_s24le(p + 3 * s) };
+}
+
+static inline float32x4_t neon_load_f32le(const uint8_t *p, size_t s) {
+	return (float32x4_t) { rd_f32le(p), rd_f32le(p + s), rd_f32le(p + 2 * s), rd_f32le(p + 3 * s) };
+}
+
+static void conv_float_trunc_neon(ltcsnd_sample_t *out, const float *in, size_t n, size_t stride) {
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		const float *p = in + i * stride;
+		neon_store16(out + i,
+				neon_trunc(neon_load_float(p, stride)),
+				neon_trunc(neon_load_float(p + 4 * stride, stride)),
+				neon_trunc(neon_load_float(p + 8 * stride, stride)),
+				neon_trunc(neon_load_float(p + 12 * stride, stride)));
+	}
+	conv_float_trunc_ref(out + i, in + i * stride, n - i, stride);
+}
+
+#define NEON_CONV_LE(NAME)                                                                     \
+static void conv_ ## NAME ## _trunc_neon(ltcsnd_sample_t *out, const uint8_t *in, size_t n, size_t stride) { \
+	size_t i = 0;                                                                                \
+	for (; i + 16 <= n; i += 16) {                                                               \
+		const uint8_t *p = in + i * stride;                                                        \
+		neon_store16(out + i,                                                                      \
+				neon_trunc(neon_load_ ## NAME(p, stride)),                                             \
+				neon_trunc(neon_load_ ## NAME(p + 4 * stride, stride)),                                \
+				neon_trunc(neon_load_ ## NAME(p + 8 * stride, stride)),                                \
+				neon_trunc(neon_load_ ## NAME(p + 12 * stride, stride)));                              \
+	}                                                                                            \
+	conv_ ## NAME ## _trunc_ref(out + i, in + i * stride, n - i, stride);                        \
+}
+
+NEON_CONV_LE(s16le)
+NEON_CONV_LE(s24le)
+NEON_CONV_LE(f32le)
+
+#ifdef __aarch64__
+static inline int32x4_t neon_rint(const float *p) {
+	const float32x4_t f = vld1q_f32(p);
+	const float64x2_t k127 = vdupq_n_f64(127.0);
+	const float64x2_t k128 = vdupq_n_f64(128.0);
+	const float64x2_t lo = vaddq_f64(vmulq_f64(vcvt_f64_f32(vget_low_f32(f)), k127), k128);
+	const float64x2_t hi = vaddq_f64(vmulq_f64(vcvt_high_f64_f32(f), k127), k128);
+	/* round to nearest, ties to even: same as rint() in the default rounding mode */
+	const int32x4_t v = vcombine_s32(vmovn_s64(vcvtnq_s64_f64(lo)), vmovn_s64(vcvtnq_s64_f64(hi)));
+	return vandq_s32(v, vdupq_n_s32(0xff));
+}
+
+static void conv_float_rint_neon(ltcsnd_sample_t *out, const float *in, size_t n) {
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		neon_store16(out + i,
+				neon_rint(in + i), neon_rint(in + i + 4),
+				neon_rint(in + i + 8), neon_rint(in + i + 12));
+	}
+	conv_float_rint_ref(out + i, in + i, n - i);
+}
+#endif
+
+#endif /* HAVE_NEON_KERNELS */
+
+/*****************************************************************************
+ * runtime selection
+ */
+
+static void (*k_float_trunc)(ltcsnd_sample_t *, const float *, size_t, size_t) = conv_float_trunc_ref;
+static void (*k_float_rint)(ltcsnd_sample_t *, const float *, size_t) = conv_float_rint_ref;
+static void (*k_s16le_trunc)(ltcsnd_sample_t *, const uint8_t *, size_t, size_t) = conv_s16le_trunc_ref;
+static void (*k_s24le_trunc)(ltcsnd_sample_t *, const uint8_t *, size_t, size_t) = conv_s24le_trunc_ref;
+static void (*k_f32le_trunc)(ltcsnd_sample_t *, const uint8_t *, size_t, size_t) = conv_f32le_trunc_ref;
+static const char *k_name = "scalar";
+
+/* use the given implementation ("scalar", "SSE2", "AVX2" or "NEON").
+ * returns 0 on success, -1 if it is not available on this CPU.
+ */
+int sampleconv_select(const char *name) {
+	if (!strcmp(name, "scalar")) {
+		k_float_trunc = conv_float_trunc_ref;
+		k_float_rint  = conv_float_rint_ref;
+		k_s16le_trunc = conv_s16le_trunc_ref;
+		k_s24le_trunc = conv_s24le_trunc_ref;
+		k_f32le_trunc = conv_f32le_trunc_ref;
+		k_name = "scalar";
+		return 0;
+	}
+#ifdef HAVE_X86_KERNELS
+	__builtin_cpu_init();
+	if (!strcmp(name, "AVX2") && __builtin_cpu_supports("avx2")) {
+		k_float_trunc = conv_float_trunc_avx2;
+		k_float_rint  = conv_float_rint_avx2;
+		k_s16le_trunc = conv_s16le_trunc_avx2;
+		k_s24le_trunc = conv_s24le_trunc_avx2;
+		k_f32le_trunc = conv_f32le_trunc_avx2;
+		k_name = "AVX2";
+		return 0;
+	}
+	if (!strcmp(name, "SSE2") && __builtin_cpu_supports("sse2")) {
+		k_float_trunc = conv_float_trunc_sse2;
+		k_float_rint  = conv_float_rint_sse2;
+		k_s16le_trunc = conv_s16le_trunc_sse2;
+		k_s24le_trunc = conv_s24le_trunc_sse2;
+		k_f32le_trunc = conv_f32le_trunc_sse2;
+		k_name = "SSE2";
+		return 0;
+	}
+#elif defined HAVE_NEON_KERNELS
+	if (!strcmp(name, "NEON")) {
+		k_float_trunc = conv_float_trunc_neon;
+#ifdef __aarch64__
+		k_float_rint  = conv_float_rint_neon;
+#else
+		k_float_rint  = conv_float_rint_ref;
+#endif
+		k_s16le_trunc = conv_s16le_trunc_neon;
+		k_s24le_trunc = conv_s24le_trunc_neon;
+		k_f32le_trunc = conv_f32le_trunc_neon;
+		k_name = "NEON";
+		return 0;
+	}
+#endif
+	return -1;
+}
+
+/* select the fastest implementation */
+void sampleconv_init(void) {
+	if (sampleconv_select("AVX2") && sampleconv_select("SSE2") && sampleconv_select("NEON")) {
+		sampleconv_select("scalar");
+	}
+}
+
+const char *sampleconv_kernel(void) {
+	return k_name;
+}
+
+void conv_float_trunc(ltcsnd_sample_t *out, const float *in, size_t n, size_t stride) {
+	k_float_trunc(out, in, n, stride);
+}
+
+void conv_float_rint(ltcsnd_sample_t *out, const float *in, size_t n) {
+	k_float_rint(out, in, n);
+}
+
+void conv_s16le_trunc(ltcsnd_sample_t *out, const uint8_t *in, size_t n, size_t stride) {
+	k_s16le_trunc(out, in, n, stride);
+}
+
+void conv_s24le_trunc(ltcsnd_sample_t *out, const uint8_t *in, size_t n, size_t stride) {
+	k_s24le_trunc(out, in, n, stride);
+}
+
+void conv_f32le_trunc(ltcsnd_sample_t *out, const uint8_t *in, size_t n, size_t stride) {
+	k_f32le_trunc(out, in, n, stride);
+}
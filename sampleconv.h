@@ -0,0 +1,47 @@
+#ifndef SAMPLECONV_H
+#define SAMPLECONV_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <ltc.h>
+
+/* Conversion of audio-samples to the LTC decoder's 8 bit format.
+ *
+ * The _trunc variants compute (ltcsnd_sample_t)(128 + f * 127) in single
+ * precision, that is what ltcdump always used. Integer input is first
+ * normalized to float the way libsndfile does it.
+ * The _rint variant computes rint(127.0 * f + 128.0) & 0xff in double
+ * precision, as used by the JACK clients.
+ *
+ * stride is given in samples for float input and in bytes for
+ * little-endian integer/float input.
+ *
+ * sampleconv_init() selects the fastest implementation (SSE2, AVX2 or
+ * NEON) at runtime, all of them produce output identical to the
+ * scalar reference implementation (see test/test_sampleconv.c).
+ */
+
+void sampleconv_init(void);
+int sampleconv_select(const char *name);
+const char *sampleconv_kernel(void);
+
+void conv_float_trunc(ltcsnd_sample_t *out, const float *in, size_t n, size_t stride);
+void conv_float_rint(ltcsnd_sample_t *out, const float *in, size_t n);
+void conv_s16le_trunc(ltcsnd_sample_t *out, const uint8_t *in, size_t n, size_t stride);
+void conv_s24le_trunc(ltcsnd_sample_t *out, const uint8_t *in, size_t n, size_t stride);
+void conv_f32le_trunc(ltcsnd_sample_t *out, const uint8_t *in, size_t n, size_t stride);
+
+/* little-endian input to float, normalized like the _trunc variants,
+ * e.g. for the decimator (see decimate.h). stride is given in bytes. */
+void conv_s16le_float(float *out, const uint8_t *in, size_t n, size_t stride);
+void conv_s24le_float(float *out, const uint8_t *in, size_t n, size_t stride);
+void conv_f32le_float(float *out, const uint8_t *in, size_t n, size_t stride);
+
+/* scalar reference implementation */
+void conv_float_trunc_ref(ltcsnd_sample_t *out, const float *in, size_t n, size_t stride);
+void conv_float_rint_ref(ltcsnd_sample_t *out, const float *in, size_t n);
+void conv_s16le_trunc_ref(ltcsnd_sample_t *out, const uint8_t *in, size_t n, size_t stride);
+void conv_s24le_trunc_ref(ltcsnd_sample_t *out, const uint8_t *in, size_t n, size_t stride);
+void conv_f32le_trunc_ref(ltcsnd_sample_t *out, const uint8_t *in, size_t n, size_t stride);
+
+#endif
@@ -0,0 +1,314 @@
+/* throughput and accuracy of the decimating pre-filter
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* LTC is encoded with libltc at high sample-rates, stored as PCM16 and
+ * decoded the way ltcdump does it for memory-mapped files: converted
+ * directly to the decoder's 8 bit format at the full rate, or converted
+ * to float, decimated (see decimate.h) and decoded at <= 48kHz.
+ *
+ *  full, decim: input samples per second (millions), best of -n runs,
+ *               conversion and decoding
+ *  frames:      frames found at the full rate / after decimation
+ *  start, end:  mean and max. |difference| of off_start and off_end
+ *               of the same frame, in samples at the full rate
+ *
+ * The filter length is a compile-time constant, e.g.
+ *   make bench CFLAGS+="-DDECIMATE_TAPS_PER_PHASE=16"
+ * The noise is seeded, a run is reproducible on every platform.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <time.h>
+#include <math.h>
+#include <ltc.h>
+#include "../decimate.h"
+#include "../ltcwave.h"
+#include "../sampleconv.h"
+
+#define BLOCK_SIZE 1024 ///< as ltcdump
+#define QUEUE_LENGTH 16
+
+struct framerate {
+	int fps_num;
+	int fps_den;
+	int drop;
+	enum LTC_TV_STANDARD tv;
+	const char *name;
+};
+
+static const struct framerate framerates[] = {
+	{ 25, 1, 0, LTC_TV_625_50, "25" },
+	{ 30000, 1001, 1, LTC_TV_525_60, "29.97df" },
+};
+
+static const int samplerates[] = { 88200, 96000, 176400, 192000 };
+static const double noise_levels[] = { -INFINITY, -40 }; ///< dBFS
+
+static int seconds = 60;
+static int n_runs = 5;
+
+static uint32_t rnd_state = 1;
+
+static uint32_t rnd(void) {
+	/* xorshift32, reproducible on every platform */
+	rnd_state ^= rnd_state << 13;
+	rnd_state ^= rnd_state >> 17;
+	rnd_state ^= rnd_state << 5;
+	return rnd_state;
+}
+
+struct frames {
+	LTCFrameExt *f;
+	size_t n;
+	size_t n_alloc;
+};
+
+static void frames_add(struct frames *fr, LTCFrameExt *frame) {
+	if (fr->n == fr->n_alloc) {
+		fr->n_alloc = fr->n_alloc ? 2 * fr->n_alloc : 1024;
+		fr->f = realloc(fr->f, fr->n_alloc * sizeof(LTCFrameExt));
+	}
+	memcpy(&fr->f[fr->n++], frame, sizeof(LTCFrameExt));
+}
+
+static double now(void) {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + 1e-9 * t.tv_nsec;
+}
+
+/* mono PCM16 little-endian, returns the number of samples */
+static size_t encode(uint8_t **pcm, int samplerate, const struct framerate *fr, double noise_dbfs) {
+	const double fps = fr->fps_num / (double) fr->fps_den;
+	const double noise = 32767 * pow(10, noise_dbfs / 20);
+	LTCEncoder *e = ltc_encoder_create(samplerate, fps, fr->tv, 0);
+	const size_t n_alloc = (size_t) (seconds + 1) * samplerate;
+	ltcsnd_sample_t *buf;
+	SMPTETimecode st;
+	size_t n = 0;
+	int i;
+
+	if (!e) {
+		return 0;
+	}
+	ltc_encoder_set_volume(e, LTCWAVE_VOLUME_DBFS);
+	ltc_encoder_set_filter(e, LTCWAVE_RISE_TIME);
+
+	memset(&st, 0, sizeof(SMPTETimecode));
+	strcpy(st.timezone, "+0000");
+	st.hours = 1;
+	ltc_encoder_set_timecode(e, &st);
+	if (fr->drop) {
+		LTCFrame lf;
+		ltc_encoder_get_frame(e, &lf);
+		lf.dfbit = 1;
+		ltc_encoder_set_frame(e, &lf);
+	}
+
+	buf = calloc(ltc_encoder_get_buffersize(e), sizeof(ltcsnd_sample_t));
+	*pcm = malloc(2 * n_alloc);
+	rnd_state = 1;
+
+	while (n < n_alloc - (size_t) samplerate / 20) {
+		int len;
+		ltc_encoder_encode_frame(e);
+		len = ltc_encoder_copy_buffer(e, buf);
+		for (i = 0; i < len && n < n_alloc; ++i, ++n) {
+			double v = (buf[i] - 128) * 256.0;
+			int s;
+			if (noise > 0) {
+				v += noise * (((int32_t) rnd()) / 2147483648.0);
+			}
+			s = lrint(v);
+			if (s > 32767) s = 32767;
+			if (s < -32768) s = -32768;
+			(*pcm)[2 * n] = s & 0xff;
+			(*pcm)[2 * n + 1] = (s >> 8) & 0xff;
+		}
+		ltc_encoder_inc_timecode(e);
+	}
+
+	free(buf);
+	ltc_encoder_free(e);
+	return n;
+}
+
+static double decode_full(const uint8_t *pcm, size_t n, int apv, struct frames *out) {
+	LTCDecoder *d = ltc_decoder_create(apv, QUEUE_LENGTH);
+	ltcsnd_sample_t sound[BLOCK_SIZE];
+	LTCFrameExt frame;
+	double t0 = now();
+	size_t pos;
+
+	for (pos = 0; pos < n; pos += BLOCK_SIZE) {
+		const size_t len = n - pos < BLOCK_SIZE ? n - pos : BLOCK_SIZE;
+		conv_s16le_trunc(sound, pcm + 2 * pos, len, 2);
+		ltc_decoder_write(d, sound, len, pos);
+		while (ltc_decoder_read(d, &frame)) {
+			if (out) frames_add(out, &frame);
+		}
+	}
+	ltc_decoder_free(d);
+	return now() - t0;
+}
+
+static double decode_decimated(const uint8_t *pcm, size_t n, int apv, int factor, struct frames *out) {
+	LTCDecoder *d = ltc_decoder_create(apv / factor, QUEUE_LENGTH);
+	ltcsnd_sample_t sound[BLOCK_SIZE];
+	float decimated[BLOCK_SIZE];
+	struct decimator dec;
+	LTCFrameExt frame;
+	double t0 = now();
+	size_t pos;
+
+	decimator_init(&dec, factor);
+	decimator_reset(&dec, 0);
+	for (pos = 0; pos < n; pos += BLOCK_SIZE) {
+		const size_t len = n - pos < BLOCK_SIZE ? n - pos : BLOCK_SIZE;
+		const int64_t out_pos = dec.out_pos;
+		size_t n_out;
+		conv_s16le_float(decimated, pcm + 2 * pos, len, 2);
+		n_out = decimator_process(&dec, decimated, decimated, len);
+		conv_float_trunc(sound, decimated, n_out, 1);
+		ltc_decoder_write(d, sound, n_out, out_pos);
+		while (ltc_decoder_read(d, &frame)) {
+			frame.off_start = decimator_input_pos(&dec, frame.off_start);
+			frame.off_end = decimator_input_pos(&dec, frame.off_end);
+			if (out) frames_add(out, &frame);
+		}
+	}
+	ltc_decoder_free(d);
+	decimator_free(&dec);
+	return now() - t0;
+}
+
+static int same_frame(const LTCFrameExt *a, const LTCFrameExt *b) {
+	return a->ltc.frame_units == b->ltc.frame_units && a->ltc.frame_tens == b->ltc.frame_tens
+		&& a->ltc.secs_units == b->ltc.secs_units && a->ltc.secs_tens == b->ltc.secs_tens
+		&& a->ltc.mins_units == b->ltc.mins_units && a->ltc.mins_tens == b->ltc.mins_tens
+		&& a->ltc.hours_units == b->ltc.hours_units && a->ltc.hours_tens == b->ltc.hours_tens;
+}
+
+static void run(int samplerate, const struct framerate *fr, double noise_dbfs) {
+	const int apv = samplerate * fr->fps_den / fr->fps_num;
+	const int factor = decimator_factor(samplerate);
+	struct frames full, decim;
+	double t_full = 1e9, t_decim = 1e9;
+	double sum_start = 0, sum_end = 0;
+	long long int max_start = 0, max_end = 0;
+	size_t n, i, j, matched = 0;
+	uint8_t *pcm;
+	char noise[16];
+	int r;
+
+	n = encode(&pcm, samplerate, fr, noise_dbfs);
+	if (n == 0) {
+		fprintf(stderr, "Error: cannot create the encoder\n");
+		return;
+	}
+
+	memset(&full, 0, sizeof(struct frames));
+	memset(&decim, 0, sizeof(struct frames));
+	decode_full(pcm, n, apv, &full);
+	decode_decimated(pcm, n, apv, factor, &decim);
+	for (r = 0; r < n_runs; ++r) {
+		double t = decode_full(pcm, n, apv, NULL);
+		if (t < t_full) t_full = t;
+		t = decode_decimated(pcm, n, apv, factor, NULL);
+		if (t < t_decim) t_decim = t;
+	}
+
+	/* both are in order, the decimated decoder may miss or add a frame */
+	for (i = j = 0; i < full.n && j < decim.n; ) {
+		if (same_frame(&full.f[i], &decim.f[j])) {
+			const long long int ds = llabs((long long int) (decim.f[j].off_start - full.f[i].off_start));
+			const long long int de = llabs((long long int) (decim.f[j].off_end - full.f[i].off_end));
+			sum_start += ds;
+			sum_end += de;
+			if (ds > max_start) max_start = ds;
+			if (de > max_end) max_end = de;
+			++matched;
+			++i; ++j;
+		} else if (full.f[i].off_start < decim.f[j].off_start) {
+			++i;
+		} else {
+			++j;
+		}
+	}
+
+	if (isinf(noise_dbfs)) {
+		snprintf(noise, sizeof(noise), "-");
+	} else {
+		snprintf(noise, sizeof(noise), "%.0f", noise_dbfs);
+	}
+	printf(" %6d %-8s %5s %3d %7.1f %7.1f %5.2fx %6zu %6zu %6zu %6.2f %5lld %6.2f %5lld\n",
+			samplerate, fr->name, noise, factor,
+			n / t_full * 1e-6, n / t_decim * 1e-6, t_full / t_decim,
+			full.n, decim.n, matched,
+			matched ? sum_start / matched : 0, max_start,
+			matched ? sum_end / matched : 0, max_end);
+
+	free(full.f);
+	free(decim.f);
+	free(pcm);
+}
+
+static void usage(void) {
+	printf("Usage: bench_decimate [-d <seconds>] [-n <runs>]\n");
+}
+
+int main(int argc, char **argv) {
+	size_t s, f, l;
+	int c;
+
+	while ((c = getopt(argc, argv, "d:hn:")) != -1) {
+		switch (c) {
+			case 'd':
+				seconds = atoi(optarg);
+				break;
+			case 'n':
+				n_runs = atoi(optarg);
+				break;
+			default:
+				usage();
+				return c == 'h' ? 0 : 1;
+		}
+	}
+	if (seconds < 1 || n_runs < 1) {
+		usage();
+		return 1;
+	}
+
+	sampleconv_init();
+	printf("# DECIMATE_TAPS_PER_PHASE = %d, %s kernels\n", DECIMATE_TAPS_PER_PHASE, sampleconv_kernel());
+	printf("# %d seconds of PCM16 LTC at %.0f dBFS, best of %d runs\n", seconds, LTCWAVE_VOLUME_DBFS, n_runs);
+	printf("#%6s %-8s %5s %3s %7s %7s %6s %6s %6s %6s %6s %5s %6s %5s\n",
+			"rate", "fps", "noise", "1/n", "full", "decim", "gain", "frames", "decim", "match",
+			"start", "max", "end", "max");
+
+	for (s = 0; s < sizeof(samplerates) / sizeof(int); ++s) {
+		for (f = 0; f < sizeof(framerates) / sizeof(struct framerate); ++f) {
+			for (l = 0; l < sizeof(noise_levels) / sizeof(double); ++l) {
+				run(samplerates[s], &framerates[f], noise_levels[l]);
+			}
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,293 @@
+/* time-to-lock of the framerate detector
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Synthetic LTC frames are passed to fps_detector_add(), starting at
+ * ltcdump's default of 25 fps. For every framerate, frame-length jitter,
+ * varispeed and cut the number of frames until the detector reports the
+ * correct rate is measured, with the frame period (as ltcdump -F) and
+ * with the frame-number rollover only (as jltc2mtc).
+ *
+ *  locked: trials that found the rate within -f frames
+ *  median, max: frames until the rate is reported, counted from the
+ *               start or from the cut
+ *  wrong: trials that switched to a wrong rate at any point
+ *
+ * The detector's parameters are compile-time constants, e.g.
+ *   make bench CFLAGS+="-DLTC_FPS_PERIOD_FRAMES=6 -DLTC_FPS_PERIOD_JITTER=0.03"
+ * The frames are seeded, a run is reproducible on every platform.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <time.h>
+#include <ltc.h>
+#include "../ltcframeutil.h"
+
+struct scenario {
+	double fps;      ///< frames per second of the audio, before varispeed
+	int df;
+	double fps2;     ///< after a cut in the middle, 0: no cut
+	double jitter;   ///< max. deviation of a frame's length
+	double speed;    ///< varispeed
+};
+
+static const struct scenario jitter_table[] = {
+	{ 24000 / 1001.0, 0, 0, 0, 1 }, { 24000 / 1001.0, 0, 0, .005, 1 }, { 24000 / 1001.0, 0, 0, .01, 1 }, { 24000 / 1001.0, 0, 0, .02, 1 }, { 24000 / 1001.0, 0, 0, .03, 1 },
+	{ 24, 0, 0, 0, 1 }, { 24, 0, 0, .005, 1 }, { 24, 0, 0, .01, 1 }, { 24, 0, 0, .02, 1 }, { 24, 0, 0, .03, 1 },
+	{ 25, 0, 0, 0, 1 }, { 25, 0, 0, .005, 1 }, { 25, 0, 0, .01, 1 }, { 25, 0, 0, .02, 1 }, { 25, 0, 0, .03, 1 },
+	{ 30000 / 1001.0, 1, 0, 0, 1 }, { 30000 / 1001.0, 1, 0, .005, 1 }, { 30000 / 1001.0, 1, 0, .01, 1 }, { 30000 / 1001.0, 1, 0, .02, 1 }, { 30000 / 1001.0, 1, 0, .03, 1 },
+	{ 30000 / 1001.0, 0, 0, 0, 1 }, { 30000 / 1001.0, 0, 0, .005, 1 }, { 30000 / 1001.0, 0, 0, .01, 1 }, { 30000 / 1001.0, 0, 0, .02, 1 }, { 30000 / 1001.0, 0, 0, .03, 1 },
+	{ 30, 0, 0, 0, 1 }, { 30, 0, 0, .005, 1 }, { 30, 0, 0, .01, 1 }, { 30, 0, 0, .02, 1 }, { 30, 0, 0, .03, 1 },
+};
+
+static const struct scenario speed_table[] = {
+	{ 24, 0, 0, .005, .97 }, { 24, 0, 0, .005, .99 }, { 24, 0, 0, .005, 1.01 }, { 24, 0, 0, .005, 1.02 },
+	{ 25, 0, 0, .005, .97 }, { 25, 0, 0, .005, .99 }, { 25, 0, 0, .005, 1.01 }, { 25, 0, 0, .005, 1.02 },
+	{ 30, 0, 0, .005, .97 }, { 30, 0, 0, .005, .99 }, { 30, 0, 0, .005, 1.01 }, { 30, 0, 0, .005, 1.02 },
+};
+
+static const struct scenario cut_table[] = {
+	{ 25, 0, 30, .005, 1 }, { 30, 0, 25, .005, 1 },
+	{ 24, 0, 25, .005, 1 }, { 25, 0, 24, .005, 1 },
+	{ 24, 0, 30, .005, 1 }, { 30, 0, 24, .005, 1 },
+};
+
+struct result {
+	int n_locked;
+	int n_wrong;
+	int *lock; ///< frames until locked, per locked trial
+};
+
+static int samplerate = 48000;
+static int n_trials = 200;
+static int n_frames = 250; ///< per section, 10 sec at 25 fps
+
+static LTCFrameExt *frames;
+static SMPTETimecode *stime;
+
+static uint32_t rnd_state = 1;
+
+static uint32_t rnd(void) {
+	/* xorshift32, reproducible on every platform */
+	rnd_state ^= rnd_state << 13;
+	rnd_state ^= rnd_state >> 17;
+	rnd_state ^= rnd_state << 5;
+	return rnd_state;
+}
+
+static int nominal(double fps) {
+	return fps < 24.5 ? 24 : (fps < 27.5 ? 25 : 30);
+}
+
+static enum LTC_TV_STANDARD tv_standard(int fps) {
+	switch (fps) {
+		case 24: return LTC_TV_FILM_24;
+		case 25: return LTC_TV_625_50;
+		default: return LTC_TV_525_60;
+	}
+}
+
+/* starts at a random frame of the given hour */
+static void set_time(LTCFrame *f, int fps, int df, int hour) {
+	SMPTETimecode st;
+	memset(&st, 0, sizeof(SMPTETimecode));
+	strcpy(st.timezone, "+0000");
+	st.hours = hour;
+	st.secs = rnd() % 60;
+	st.frame = rnd() % fps;
+	if (df && st.secs == 0 && st.frame < 2) st.frame = 2;
+	memset(f, 0, sizeof(LTCFrame));
+	ltc_time_to_frame(f, &st, tv_standard(fps), 0);
+	f->dfbit = df;
+}
+
+/* returns the number of frames, the cut is at n_frames */
+static int make_frames(const struct scenario *sc) {
+	const int n = sc->fps2 > 0 ? 2 * n_frames : n_frames;
+	LTCFrame f;
+	double pos = rnd() % 1000;
+	double fps = sc->fps;
+	int i;
+
+	set_time(&f, nominal(fps), sc->df, 1);
+	for (i = 0; i < n; ++i) {
+		double len;
+		if (i == n_frames && sc->fps2 > 0) {
+			fps = sc->fps2;
+			set_time(&f, nominal(fps), sc->df, 10);
+		}
+		len = samplerate / (fps * sc->speed);
+		len *= 1.0 + sc->jitter * (((int) (rnd() % 20001) - 10000) / 10000.0);
+
+		memset(&frames[i], 0, sizeof(LTCFrameExt));
+		memcpy(&frames[i].ltc, &f, sizeof(LTCFrame));
+		frames[i].off_start = pos;
+		frames[i].off_end = pos + len - 1;
+		pos += len;
+		ltc_frame_to_time(&stime[i], &f, 0);
+		ltc_frame_increment(&f, nominal(fps), tv_standard(nominal(fps)), 0);
+	}
+	return n;
+}
+
+static void detect(const struct scenario *sc, int n, int rate, struct result *r) {
+	const int start = sc->fps2 > 0 ? n_frames : 0;
+	const int expect = nominal(sc->fps2 > 0 ? sc->fps2 : sc->fps);
+	LTCFpsDetector d;
+	int fps = 25;
+	int i, lock = -1, wrong = 0;
+
+	fps_detector_init(&d, rate);
+	for (i = 0; i < n; ++i) {
+		const int rv = fps_detector_add(&d, &fps, &frames[i], &stime[i], NULL);
+		const int want = i < start ? nominal(sc->fps) : expect;
+		if ((rv & LTC_FPS_CHANGED) && fps != want) {
+			wrong = 1;
+		}
+		if (lock < 0 && i >= start && fps == expect && (rv & (LTC_FPS_MEASURED | LTC_FPS_CONFIRMED))) {
+			lock = i - start + 1;
+		}
+	}
+	if (lock > 0) {
+		r->lock[r->n_locked++] = lock;
+	}
+	r->n_wrong += wrong;
+}
+
+static int cmp_int(const void *a, const void *b) {
+	return *(const int *) a - *(const int *) b;
+}
+
+static void print_result(struct result *r) {
+	if (r->n_locked == 0) {
+		printf("   %5.1f%% %6s %5s %5d", 0.0, "-", "-", r->n_wrong);
+		return;
+	}
+	qsort(r->lock, r->n_locked, sizeof(int), cmp_int);
+	printf("   %5.1f%% %6d %5d %5d", 100.0 * r->n_locked / n_trials,
+			r->lock[r->n_locked / 2], r->lock[r->n_locked - 1], r->n_wrong);
+}
+
+static void run_table(const char *title, const struct scenario *table, size_t n_sc) {
+	struct result period, rollover;
+	size_t s;
+
+	printf("\n# %s\n", title);
+	printf("#%-14s %7s %6s   %7s %6s %5s %5s   %7s %6s %5s %5s\n", "fps", "jitter", "speed",
+			"period", "median", "max", "wrong", "rollovr", "median", "max", "wrong");
+
+	period.lock = malloc(n_trials * sizeof(int));
+	rollover.lock = malloc(n_trials * sizeof(int));
+
+	for (s = 0; s < n_sc; ++s) {
+		const struct scenario *sc = &table[s];
+		char name[32];
+		int t;
+
+		period.n_locked = period.n_wrong = 0;
+		rollover.n_locked = rollover.n_wrong = 0;
+		rnd_state = 1 + s;
+		for (t = 0; t < n_trials; ++t) {
+			const int n = make_frames(sc);
+			detect(sc, n, samplerate, &period);
+			detect(sc, n, 0, &rollover);
+		}
+
+		if (sc->fps2 > 0) {
+			snprintf(name, sizeof(name), "%.3g -> %.3g", sc->fps, sc->fps2);
+		} else {
+			snprintf(name, sizeof(name), "%.5g%s", sc->fps, sc->df ? "df" : "");
+		}
+		printf(" %-14s %6.1f%% %6.2f", name, 100 * sc->jitter, sc->speed);
+		print_result(&period);
+		print_result(&rollover);
+		printf("\n");
+	}
+	free(period.lock);
+	free(rollover.lock);
+}
+
+/* CPU time per frame, of the detector alone */
+static void run_timing(void) {
+	const struct scenario sc = { 25, 0, 0, .005, 1 };
+	struct timespec t0, t1;
+	LTCFpsDetector d;
+	long long int calls = 0;
+	int fps = 25;
+	int i, n, t;
+
+	rnd_state = 1;
+	n = make_frames(&sc);
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (t = 0; t < n_trials; ++t) {
+		fps_detector_init(&d, samplerate);
+		for (i = 0; i < n; ++i) {
+			fps_detector_add(&d, &fps, &frames[i], &stime[i], NULL);
+		}
+		calls += n;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	printf("\n# fps_detector_add: %.1f ns/frame\n",
+			((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / calls);
+}
+
+static void usage(void) {
+	printf("Usage: bench_fpsdetect [-f <frames>] [-n <trials>] [-s <samplerate>]\n");
+}
+
+int main(int argc, char **argv) {
+	int c;
+
+	while ((c = getopt(argc, argv, "f:hn:s:")) != -1) {
+		switch (c) {
+			case 'f':
+				n_frames = atoi(optarg);
+				break;
+			case 'n':
+				n_trials = atoi(optarg);
+				break;
+			case 's':
+				samplerate = atoi(optarg);
+				break;
+			default:
+				usage();
+				return c == 'h' ? 0 : 1;
+		}
+	}
+	if (n_frames < 1 || n_trials < 1 || samplerate < 1) {
+		usage();
+		return 1;
+	}
+
+	frames = malloc(2 * n_frames * sizeof(LTCFrameExt));
+	stime = malloc(2 * n_frames * sizeof(SMPTETimecode));
+
+	printf("# LTC_FPS_PERIOD_FRAMES = %d, LTC_FPS_PERIOD_JITTER = %g, LTC_FPS_PERIOD_TOLERANCE = %g\n",
+			LTC_FPS_PERIOD_FRAMES, LTC_FPS_PERIOD_JITTER, LTC_FPS_PERIOD_TOLERANCE);
+	printf("# %d Hz, %d trials of %d frames, starting at 25 fps\n", samplerate, n_trials, n_frames);
+
+	run_table("frame-length jitter", jitter_table, sizeof(jitter_table) / sizeof(struct scenario));
+	run_table("varispeed", speed_table, sizeof(speed_table) / sizeof(struct scenario));
+	run_table("cut, counted from the cut", cut_table, sizeof(cut_table) / sizeof(struct scenario));
+	run_timing();
+
+	free(frames);
+	free(stime);
+	return 0;
+}
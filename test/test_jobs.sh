@@ -0,0 +1,85 @@
+#!/bin/sh
+# ltcdump --jobs: decode LTC with cuts, reverse, varispeed and silence
+# serially and with 2..8 jobs, the outputs must be identical.
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+
+LTCGEN=${LTCGEN:-./ltcgen}
+LTCDUMP=${LTCDUMP:-./ltcdump}
+
+tmp=$(mktemp -d) || exit 1
+trap 'rm -rf "$tmp"' EXIT
+rv=0
+
+# little-endian integer of n bytes
+le() {
+	le_v=$1 le_n=$2
+	while [ $le_n -gt 0 ]; do
+		printf "\\$(printf %o $((le_v & 255)))"
+		le_v=$((le_v >> 8)) le_n=$((le_n - 1))
+	done
+}
+
+# append a piece rendered at the given rate, played at the file's rate
+piece() {
+	$LTCGEN -R -f 25 "$@" "$tmp/piece" >/dev/null || exit 1
+	cat "$tmp/piece" >> "$tmp/raw"
+}
+
+# mono PCM16 WAV at the given rate, the pieces are raw ltcgen output
+mkfile() {
+	rate=$1 out=$2
+	: > "$tmp/raw"
+	piece -s $rate -t 01:00:00:00 -l 00:00:20:00
+	# cut to a reverse run
+	piece -s $rate -t 02:00:00:00 -l 00:00:10:00 -r
+	# one second of silence
+	dd if=/dev/zero bs=$((2 * rate)) count=1 2>/dev/null >> "$tmp/raw"
+	# varispeed: rendered at a lower and a higher rate
+	piece -s $((rate * 11 / 12)) -t 03:00:00:00 -l 00:00:15:00
+	piece -s $((rate * 11 / 10)) -t 04:00:00:00 -l 00:00:15:00
+	# cut in the middle of a frame
+	$LTCGEN -R -f 25 -s $rate -t 05:00:00:00 -l 00:00:05:00 "$tmp/piece" >/dev/null || exit 1
+	dd if="$tmp/piece" bs=2 count=$((5 * rate - 777)) 2>/dev/null >> "$tmp/raw"
+	piece -s $rate -t 06:00:00:00 -l 00:00:10:00
+
+	n=$(wc -c < "$tmp/raw")
+	{
+		printf 'RIFF'; le $((36 + n)) 4; printf 'WAVEfmt '
+		le 16 4; le 1 2; le 1 2; le $rate 4; le $((2 * rate)) 4; le 2 2; le 16 2
+		printf 'data'; le $n 4
+		cat "$tmp/raw"
+	} > "$out"
+}
+
+# -v also prints the "No LTC frame found" report
+compare() {
+	file=$1; shift
+	$LTCDUMP "$@" "$file" > "$tmp/serial.txt" 2>/dev/null
+	for j in 2 3 4 5 6 7 8; do
+		$LTCDUMP -j $j "$@" "$file" > "$tmp/jobs.txt" 2>/dev/null
+		if ! cmp -s "$tmp/serial.txt" "$tmp/jobs.txt"; then
+			echo "FAIL: ltcdump -j $j $* differs from a serial run:"
+			diff "$tmp/serial.txt" "$tmp/jobs.txt" | head -n 10
+			rv=1
+		fi
+	done
+}
+
+mkfile 48000 "$tmp/48k.wav"
+compare "$tmp/48k.wav" -v
+compare "$tmp/48k.wav" -v -g -40
+compare "$tmp/48k.wav" -s
+compare "$tmp/48k.wav" -v -B 30s -E 70s
+
+mkfile 96000 "$tmp/96k.wav"
+compare "$tmp/96k.wav" -v
+compare "$tmp/96k.wav" -v -D
+
+if [ $rv = 0 ]; then
+	echo "jobs ok"
+fi
+exit $rv
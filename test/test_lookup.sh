@@ -0,0 +1,40 @@
+#!/bin/sh
+# --lookup on a 30 fps file, without -f: the index must be built at the
+# detected framerate, not at ltcdump's default of 25 fps.
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+
+LTCGEN=${LTCGEN:-./ltcgen}
+LTCDUMP=${LTCDUMP:-./ltcdump}
+
+tmp=$(mktemp -d) || exit 1
+trap 'rm -rf "$tmp"' EXIT
+rv=0
+
+# expect "<timecode> | <sample>", the sample within a frame of the given one
+lookup() {
+	query=$1 tc=$2 sample=$3
+	out=$($LTCDUMP --lookup "$query" "$tmp/30.wav" 2>/dev/null)
+	if ! echo "$out" | awk -v tc="$tc" -v s="$sample" \
+			'$1 == tc && $3 - s < 1600 && s - $3 < 1600 { ok = 1 } END { exit !ok }'; then
+		echo "FAIL: --lookup $query: '$out', expected $tc | $sample"
+		rv=1
+	fi
+}
+
+$LTCGEN -f 30 -s 48000 -t 01:00:00:00 -l 00:01:00:00 "$tmp/30.wav" >/dev/null || exit 1
+
+# 1600 samples per frame at 48kHz, the frames of the first second may
+# not be decoded, the positions are extrapolated
+lookup 01:00:10:29 01:00:10:29 $(( (10 * 30 + 29) * 1600 ))
+lookup 01:00:30:00 01:00:30:00 $(( 30 * 30 * 1600 ))
+lookup 960800 01:00:20:00 960800
+lookup 1727000 01:00:35:29 1727000
+
+if [ $rv = 0 ]; then
+	echo "lookup ok"
+fi
+exit $rv
@@ -0,0 +1,236 @@
+/* run framerate detectors and discontinuity trackers concurrently
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Synthetic 24, 25, 29.97df and 30 fps streams (and one that changes
+ * from 25 to 30 fps after a jump) are passed through fps_detector_add()
+ * and discontinuity_add(), first serially, then on -j threads at the
+ * same time, each thread with its own detector and its own stream.
+ * The result of every frame must be identical to the serial run, and
+ * the serial run must end at the stream's framerate.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <ltc.h>
+#include "../ltcframeutil.h"
+
+#define SAMPLERATE 48000
+#define N_FRAMES   3000  ///< per stream, two minutes at 25 fps
+
+static const struct {
+	int fps;   ///< of the first half
+	int fps2;  ///< after the jump in the middle
+	int df;
+	const char *name;
+} streams[] = {
+	{ 24, 24, 0, "24" },
+	{ 25, 25, 0, "25" },
+	{ 30, 30, 1, "29.97df" },
+	{ 30, 30, 0, "30" },
+	{ 25, 30, 0, "25->30" },
+};
+
+#define N_STREAMS (sizeof(streams) / sizeof(streams[0]))
+
+struct stream {
+	LTCFrameExt frames[N_FRAMES];
+	SMPTETimecode stime[N_FRAMES];
+};
+
+/* what the detector returned for every frame */
+struct trace {
+	int rv[N_FRAMES];
+	int fps[N_FRAMES];
+	int disc[N_FRAMES];
+};
+
+struct job {
+	pthread_t thread;
+	const struct stream *s;
+	const struct trace *ref;
+	int repeat;
+	int n_fail;
+};
+
+static uint32_t rnd(uint32_t *state) {
+	/* xorshift32, reproducible on every platform */
+	*state ^= *state << 13;
+	*state ^= *state >> 17;
+	*state ^= *state << 5;
+	return *state;
+}
+
+static enum LTC_TV_STANDARD tv_standard(int fps) {
+	switch (fps) {
+		case 24: return LTC_TV_FILM_24;
+		case 25: return LTC_TV_625_50;
+		default: return LTC_TV_525_60;
+	}
+}
+
+static void set_time(LTCFrame *f, int fps, int df, int h, int m, int s) {
+	SMPTETimecode st;
+	memset(&st, 0, sizeof(SMPTETimecode));
+	strcpy(st.timezone, "+0000");
+	st.hours = h; st.mins = m; st.secs = s;
+	memset(f, 0, sizeof(LTCFrame));
+	ltc_time_to_frame(f, &st, tv_standard(fps), 0);
+	f->dfbit = df;
+}
+
+/* frames of stream k, with up to 0.5% jitter of the frame length */
+static void make_stream(struct stream *s, size_t k, uint32_t seed) {
+	LTCFrame f;
+	double pos = 0;
+	int fps = streams[k].fps;
+	int i;
+
+	set_time(&f, fps, streams[k].df, 1, 0, 0);
+	for (i = 0; i < N_FRAMES; ++i) {
+		LTCFrameExt *fe = &s->frames[i];
+		double len = SAMPLERATE / (double) fps * (streams[k].df ? 1.001 : 1.0);
+		len *= 1.0 + ((int) (rnd(&seed) % 1001) - 500) / 100000.0;
+
+		if (i == N_FRAMES / 2) {
+			fps = streams[k].fps2;
+			set_time(&f, fps, streams[k].df, 10, 0, 0);
+		}
+
+		memset(fe, 0, sizeof(LTCFrameExt));
+		memcpy(&fe->ltc, &f, sizeof(LTCFrame));
+		fe->off_start = pos;
+		fe->off_end = pos + len - 1;
+		pos += len;
+		ltc_frame_to_time(&s->stime[i], &f, 0);
+		ltc_frame_increment(&f, fps, tv_standard(fps), 0);
+	}
+}
+
+static void run(const struct stream *s, struct trace *t) {
+	LTCFpsDetector d;
+	LTCDiscontinuity disc;
+	int fps = 25; // ltcdump's default
+	int i;
+
+	fps_detector_init(&d, SAMPLERATE);
+	discontinuity_init(&disc, 0, 0);
+	for (i = 0; i < N_FRAMES; ++i) {
+		LTCFrameExt frame = s->frames[i];
+		SMPTETimecode stime = s->stime[i];
+		t->rv[i] = fps_detector_add(&d, &fps, &frame, &stime, NULL);
+		t->fps[i] = fps;
+		t->disc[i] = i > 0 ? discontinuity_add(&disc, &frame, fps) : 0;
+		discontinuity_set(&disc, &frame);
+	}
+}
+
+static void *worker(void *arg) {
+	struct job *job = (struct job *) arg;
+	struct trace *t = malloc(sizeof(struct trace));
+	int r;
+
+	for (r = 0; r < job->repeat; ++r) {
+		run(job->s, t);
+		if (memcmp(t, job->ref, sizeof(struct trace))) {
+			++job->n_fail;
+		}
+	}
+	free(t);
+	return NULL;
+}
+
+static void usage(void) {
+	printf("Usage: test_ltcframeutil [-j <threads>] [-r <repeat>]\n");
+}
+
+int main(int argc, char **argv) {
+	struct stream *s;
+	struct trace *ref;
+	struct job *jobs;
+	int n_threads = 8;
+	int repeat = 20;
+	int c, n_fail = 0;
+	size_t k;
+
+	while ((c = getopt(argc, argv, "hj:r:")) != -1) {
+		switch (c) {
+			case 'j':
+				n_threads = atoi(optarg);
+				break;
+			case 'r':
+				repeat = atoi(optarg);
+				break;
+			default:
+				usage();
+				return c == 'h' ? 0 : 1;
+		}
+	}
+	if (n_threads < 1 || repeat < 1) {
+		usage();
+		return 1;
+	}
+
+	/* one stream per thread, the framerates alternate */
+	s = malloc(n_threads * sizeof(struct stream));
+	ref = malloc(n_threads * sizeof(struct trace));
+	jobs = calloc(n_threads, sizeof(struct job));
+
+	for (c = 0; c < n_threads; ++c) {
+		int i, locked = -1;
+		k = c % N_STREAMS;
+		make_stream(&s[c], k, 1 + c);
+		run(&s[c], &ref[c]);
+
+		for (i = 0; i < N_FRAMES && locked < 0; ++i) {
+			if (ref[c].rv[i] & LTC_FPS_MEASURED) locked = i;
+		}
+		if (ref[c].fps[N_FRAMES - 1] != streams[k].fps2 || locked < 0) {
+			fprintf(stderr, "FAIL: %s fps stream %d: serial run ends at %d fps\n",
+					streams[k].name, c, ref[c].fps[N_FRAMES - 1]);
+			++n_fail;
+		}
+	}
+
+	for (c = 0; c < n_threads; ++c) {
+		jobs[c].s = &s[c];
+		jobs[c].ref = &ref[c];
+		jobs[c].repeat = repeat;
+		if (pthread_create(&jobs[c].thread, NULL, worker, &jobs[c])) {
+			fprintf(stderr, "Error: cannot start thread %d\n", c);
+			return 1;
+		}
+	}
+	for (c = 0; c < n_threads; ++c) {
+		pthread_join(jobs[c].thread, NULL);
+		k = c % N_STREAMS;
+		printf("thread %2d %-7s fps: %s\n", c, streams[k].name, jobs[c].n_fail ? "FAILED" : "ok");
+		if (jobs[c].n_fail) {
+			fprintf(stderr, "FAIL: %s fps stream %d: %d of %d runs differ from the serial run\n",
+					streams[k].name, c, jobs[c].n_fail, repeat);
+			++n_fail;
+		}
+	}
+
+	printf("%d threads, %d runs each, %d failed\n", n_threads, repeat, n_fail);
+	free(s);
+	free(ref);
+	free(jobs);
+	return n_fail ? 1 : 0;
+}
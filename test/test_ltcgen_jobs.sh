@@ -0,0 +1,38 @@
+#!/bin/sh
+# ltcgen --jobs: the file must be identical to a serial render, for every
+# sample format, reverse, and drop-frame LTC with date user bits that
+# cross midnight.
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+
+LTCGEN=${LTCGEN:-./ltcgen}
+
+tmp=$(mktemp -d) || exit 1
+trap 'rm -rf "$tmp"' EXIT
+rv=0
+
+compare() {
+	$LTCGEN "$@" "$tmp/serial.wav" >/dev/null || exit 1
+	for j in 2 3 8; do
+		$LTCGEN -j $j "$@" "$tmp/jobs.wav" >/dev/null || exit 1
+		if ! cmp -s "$tmp/serial.wav" "$tmp/jobs.wav"; then
+			echo "FAIL: ltcgen -j $j $* differs from a serial render"
+			rv=1
+		fi
+	done
+}
+
+for fmt in pcm16 pcm24 float; do
+	compare -F $fmt -f 25 -t 01:00:00:00 -l 00:01:00:00
+done
+compare -f 25 -t 01:00:00:00 -l 00:01:00:00 -r
+compare -F pcm24 -s 44100 -f 30000/1001df -t 23:59:30:00 -d 12/31/99 -l 00:01:00:00
+compare -f 30000/1001df -t 23:59:30:00 -d 12/31/99 -l 00:01:00:00 -r
+
+if [ $rv = 0 ]; then
+	echo "ltcgen jobs ok"
+fi
+exit $rv
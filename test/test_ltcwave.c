@@ -0,0 +1,203 @@
+/* compare the table-driven LTC encoder to libltc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Every byte is encoded with ltc_encoder_encode_byte() and with
+ * ltcwave_encode_byte_raw()/ltcwave_encode_byte(), the samples must be
+ * identical, for all sample-rates and framerates, forward and reverse.
+ *
+ * Each combination is run forward and backward from 00:00:00:00 for -m
+ * minutes (default 11: ten drop-frame minute boundaries and the 00:10:00
+ * one, where no frames are dropped), and across midnight into a new year
+ * (date rollover) in both directions.
+ * The fractional sample position accumulates over the whole run, use
+ * e.g. -m 240 to check for drift over hours.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <ltc.h>
+#include "../ltcwave.h"
+
+static const int samplerates[] = { 44100, 48000, 96000 };
+
+static const struct {
+	int fps_num;
+	int fps_den;
+	int drop;
+	enum LTC_TV_STANDARD tv;
+	const char *name;
+} framerates[] = {
+	{ 24, 1, 0, LTC_TV_FILM_24, "24" },
+	{ 25, 1, 0, LTC_TV_625_50, "25" },
+	{ 30000, 1001, 1, LTC_TV_525_60, "29.97df" },
+	{ 30, 1, 0, LTC_TV_1125_60, "30" },
+};
+
+static int n_fail = 0;
+
+static void frame_to_str(char *s, const LTCFrame *f) {
+	SMPTETimecode st;
+	ltc_frame_to_time(&st, (LTCFrame *) f, LTC_USE_DATE);
+	sprintf(s, "%02d/%02d/%02d %02d:%02d:%02d%c%02d",
+			st.years, st.months, st.days, st.hours, st.mins, st.secs, f->dfbit ? '.' : ':', st.frame);
+}
+
+/* encode n_frames from the given date and time, returns 0 if libltc
+ * and the table produce the same samples */
+static int compare(int samplerate, int fr, int reverse, int y, int mo, int d, int h, int mi, int s, int f, long long int n_frames) {
+	const double fps = framerates[fr].fps_num / (double) framerates[fr].fps_den;
+	LTCEncoder *e = ltc_encoder_create(samplerate, fps, framerates[fr].tv, LTC_USE_DATE);
+	struct ltcwave w;
+	SMPTETimecode st;
+	ltcsnd_sample_t *a, *b;
+	short conv[256], *pcm;
+	long long int i, pos = 0;
+	int k, rv = 0;
+
+	if (!e) {
+		fprintf(stderr, "Error: cannot create the encoder\n");
+		return -1;
+	}
+	ltc_encoder_set_volume(e, LTCWAVE_VOLUME_DBFS);
+	ltc_encoder_set_filter(e, LTCWAVE_RISE_TIME);
+
+	/* as ltcgen does it at 0dBFS */
+	for (k = 0; k < 256; ++k) {
+		conv[k] = (k - 128) * 32767 / 90;
+	}
+	if (ltcwave_init(&w, samplerate, fps, conv)) {
+		fprintf(stderr, "Error: cannot create the lookup-table\n");
+		ltc_encoder_free(e);
+		return -1;
+	}
+
+	memset(&st, 0, sizeof(SMPTETimecode));
+	strcpy(st.timezone, "+0000");
+	st.years = y; st.months = mo; st.days = d;
+	st.hours = h; st.mins = mi; st.secs = s; st.frame = f;
+	ltc_encoder_set_timecode(e, &st);
+	if (framerates[fr].drop) {
+		LTCFrame lf;
+		ltc_encoder_get_frame(e, &lf);
+		lf.dfbit = 1;
+		ltc_encoder_set_frame(e, &lf);
+	}
+
+	a = calloc(ltc_encoder_get_buffersize(e), sizeof(ltcsnd_sample_t));
+	b = calloc(16 * w.n_max, sizeof(ltcsnd_sample_t));
+	pcm = calloc(16 * w.n_max, sizeof(short));
+
+	for (i = 0; rv == 0 && i < n_frames; ++i) {
+		LTCFrame lf;
+		ltc_encoder_get_frame(e, &lf);
+		for (k = 0; k < 10; ++k) {
+			const int byte_cnt = reverse ? 9 - k : k;
+			const uint8_t byte = ((uint8_t *) &lf)[byte_cnt];
+			/* copies share the tables, and encode from the same position */
+			struct ltcwave wl = w, wp = w;
+			int len, n, j;
+
+			ltc_encoder_encode_byte(e, byte_cnt, reverse ? -1.0 : 1.0);
+			len = ltc_encoder_copy_buffer(e, a);
+
+			if (ltcwave_byte_length(&wl, byte, reverse) != len) {
+				rv = -1;
+			}
+			ltcwave_encode_byte(&wp, byte, reverse, pcm);
+			n = ltcwave_encode_byte_raw(&w, byte, reverse, b);
+			if (n != len || memcmp(a, b, len)) {
+				rv = -1;
+			}
+			for (j = 0; j < n && rv == 0; ++j) {
+				if (pcm[j] != conv[b[j]]) rv = -1;
+			}
+			if (rv) {
+				char tc[32];
+				frame_to_str(tc, &lf);
+				fprintf(stderr, "FAIL: %d Hz, %s fps%s: frame %lld (%s), byte %d at sample %lld: libltc %d samples, table %d\n",
+						samplerate, framerates[fr].name, reverse ? " reverse" : "", i, tc, byte_cnt, pos, len, n);
+				break;
+			}
+			pos += len;
+		}
+
+		if (reverse) {
+			ltc_frame_decrement(&lf, ceil(fps), framerates[fr].tv, LTC_USE_DATE);
+			ltc_encoder_set_frame(e, &lf);
+		} else {
+			ltc_encoder_inc_timecode(e);
+		}
+	}
+
+	free(a);
+	free(b);
+	free(pcm);
+	ltcwave_free(&w);
+	ltc_encoder_free(e);
+	return rv;
+}
+
+static void usage(void) {
+	printf("Usage: test_ltcwave [-m <minutes>]\n");
+}
+
+int main(int argc, char **argv) {
+	int minutes = 11;
+	size_t r, fr;
+	int c, n_comb = 0;
+
+	while ((c = getopt(argc, argv, "hm:")) != -1) {
+		switch (c) {
+			case 'm':
+				minutes = atoi(optarg);
+				if (minutes < 1) {
+					usage();
+					return 1;
+				}
+				break;
+			default:
+				usage();
+				return c == 'h' ? 0 : 1;
+		}
+	}
+
+	for (r = 0; r < sizeof(samplerates) / sizeof(int); ++r) {
+		for (fr = 0; fr < sizeof(framerates) / sizeof(framerates[0]); ++fr) {
+			const int fps = ceil(framerates[fr].fps_num / (double) framerates[fr].fps_den);
+			/* 29.97df: 17982 frames per 10 minutes */
+			const long long int n_long = framerates[fr].drop
+				? (long long int) minutes * 1798 + (minutes / 10) * 2
+				: (long long int) minutes * 60 * fps;
+			const long long int n_midnight = 20 * fps;
+			int rv = 0;
+
+			rv |= compare(samplerates[r], fr, 0, 99, 12, 31, 0, 0, 0, 0, n_long);
+			rv |= compare(samplerates[r], fr, 1, 99, 12, 31, 0, 0, 0, 0, n_long);
+			rv |= compare(samplerates[r], fr, 0, 99, 12, 31, 23, 59, 50, 0, n_midnight);
+			rv |= compare(samplerates[r], fr, 1, 0, 1, 1, 0, 0, 10, 0, n_midnight);
+			++n_comb;
+
+			printf("%5d Hz %-7s fps: %s\n", samplerates[r], framerates[fr].name, rv ? "FAILED" : "ok");
+			if (rv) ++n_fail;
+		}
+	}
+
+	printf("%d combinations, %d failed\n", n_comb, n_fail);
+	return n_fail ? 1 : 0;
+}
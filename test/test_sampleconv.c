@@ -0,0 +1,212 @@
+/* compare the SIMD sample-conversion kernels to the scalar reference
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../sampleconv.h"
+
+static const char *kernels[] = { "scalar", "SSE2", "AVX2", "NEON" };
+
+static const size_t lengths[] = { 0, 1, 2, 3, 7, 15, 16, 17, 31, 32, 33, 47, 63, 64, 65, 95, 127, 129, 1023, 4097 };
+
+enum SIGNAL {
+	SIG_RANDOM = 0,  ///< -1..+1, or random bytes
+	SIG_FULLSCALE,   ///< only the most negative and most positive value
+	SIG_OVERRANGE,   ///< float beyond -1..+1
+	SIG_LAST
+};
+
+static const char *signal_names[] = { "random", "full-scale", "out-of-range" };
+
+static int n_fail = 0;
+static int n_test = 0;
+
+static uint32_t rnd_state = 1;
+
+static uint32_t rnd(void) {
+	/* xorshift32, reproducible on every platform */
+	rnd_state ^= rnd_state << 13;
+	rnd_state ^= rnd_state >> 17;
+	rnd_state ^= rnd_state << 5;
+	return rnd_state;
+}
+
+static float rnd_float(int sig) {
+	static const float overrange[] = { 1.f, -1.f, 1.0001f, -1.0001f, 1.5f, -1.5f, 2.f, -2.f, 16.f, -16.f, 1000.f, -1000.f };
+	switch (sig) {
+		case SIG_FULLSCALE:
+			return (rnd() & 1) ? 1.f : -1.f;
+		case SIG_OVERRANGE:
+			if (rnd() & 1) {
+				return overrange[rnd() % (sizeof(overrange) / sizeof(float))];
+			}
+			return ((int32_t) rnd() / 2147483648.f) * 4.f;
+		default:
+			return (int32_t) rnd() / 2147483648.f;
+	}
+}
+
+static void fill_float(float *buf, size_t n, int sig) {
+	size_t i;
+	for (i = 0; i < n; ++i) buf[i] = rnd_float(sig);
+}
+
+/* n little-endian samples of the given width, stride bytes apart.
+ * Integer samples can't be out of range, they are random then. */
+static void fill_le(uint8_t *buf, size_t size, size_t n, size_t stride, int width, int sig) {
+	size_t i;
+	for (i = 0; i < size; ++i) buf[i] = rnd();
+	for (i = 0; i < n; ++i) {
+		uint8_t *p = buf + i * stride;
+		if (width == 4) {
+			const float f = rnd_float(sig);
+			uint32_t v;
+			memcpy(&v, &f, 4);
+			p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24;
+		} else if (sig == SIG_FULLSCALE) {
+			const int neg = rnd() & 1;
+			memset(p, neg ? 0x00 : 0xff, width - 1);
+			p[width - 1] = neg ? 0x80 : 0x7f;
+		}
+	}
+}
+
+static void check(const char *kernel, const char *func, int sig, size_t n, size_t stride,
+		const ltcsnd_sample_t *out, const ltcsnd_sample_t *ref) {
+	size_t i;
+	++n_test;
+	for (i = 0; i < n; ++i) {
+		if (out[i] != ref[i]) {
+			fprintf(stderr, "FAIL: %s %s, %s input, n = %zu, stride = %zu: sample %zu is %d, expected %d\n",
+					kernel, func, signal_names[sig], n, stride, i, out[i], ref[i]);
+			++n_fail;
+			return;
+		}
+	}
+}
+
+static void test_float(const char *kernel, int sig, size_t n) {
+	static const size_t strides[] = { 1, 2, 3, 5, 8 };
+	ltcsnd_sample_t *out = malloc(n + 1);
+	ltcsnd_sample_t *ref = malloc(n + 1);
+	size_t s;
+
+	for (s = 0; s < sizeof(strides) / sizeof(size_t); ++s) {
+		const size_t stride = strides[s];
+		/* exactly as large as needed, a kernel reading too far is caught by valgrind or ASan */
+		const size_t len = n > 0 ? (n - 1) * stride + 1 : 1;
+		float *in = malloc(len * sizeof(float));
+		fill_float(in, len, sig);
+
+		conv_float_trunc_ref(ref, in, n, stride);
+		conv_float_trunc(out, in, n, stride);
+		check(kernel, "float_trunc", sig, n, stride, out, ref);
+
+		if (stride == 1) {
+			conv_float_rint_ref(ref, in, n);
+			conv_float_rint(out, in, n);
+			check(kernel, "float_rint", sig, n, stride, out, ref);
+		}
+		free(in);
+	}
+	free(out);
+	free(ref);
+}
+
+static void test_le(const char *kernel, int sig, size_t n, int width,
+		void (*conv)(ltcsnd_sample_t *, const uint8_t *, size_t, size_t),
+		void (*conv_ref)(ltcsnd_sample_t *, const uint8_t *, size_t, size_t), const char *func) {
+	ltcsnd_sample_t *out = malloc(n + 1);
+	ltcsnd_sample_t *ref = malloc(n + 1);
+	size_t stride;
+
+	/* interleaved mono .. 5 channels, and odd strides */
+	for (stride = width; stride <= 5 * (size_t) width + 1; ++stride) {
+		const size_t size = n > 0 ? (n - 1) * stride + width : 1;
+		uint8_t *in = malloc(size);
+		fill_le(in, size, n, stride, width, sig);
+
+		conv_ref(ref, in, n, stride);
+		conv(out, in, n, stride);
+		check(kernel, func, sig, n, stride, out, ref);
+		free(in);
+	}
+	free(out);
+	free(ref);
+}
+
+/* the float converters normalize like the _trunc reference */
+static void test_le_float(int sig, size_t n, int width,
+		void (*conv)(float *, const uint8_t *, size_t, size_t),
+		void (*conv_ref)(ltcsnd_sample_t *, const uint8_t *, size_t, size_t), const char *func) {
+	ltcsnd_sample_t *out = malloc(n + 1);
+	ltcsnd_sample_t *ref = malloc(n + 1);
+	float *f = malloc((n + 1) * sizeof(float));
+	size_t stride;
+
+	for (stride = width; stride <= 5 * (size_t) width + 1; ++stride) {
+		const size_t size = n > 0 ? (n - 1) * stride + width : 1;
+		uint8_t *in = malloc(size);
+		fill_le(in, size, n, stride, width, sig);
+
+		conv_ref(ref, in, n, stride);
+		conv(f, in, n, stride);
+		conv_float_trunc_ref(out, f, n, 1);
+		check("scalar", func, sig, n, stride, out, ref);
+		free(in);
+	}
+	free(out);
+	free(ref);
+	free(f);
+}
+
+int main(void) {
+	size_t k, l;
+	int sig, n_kernels = 0;
+
+	for (k = 0; k < sizeof(kernels) / sizeof(char *); ++k) {
+		int n_fail_before;
+		if (sampleconv_select(kernels[k])) {
+			printf("%-6s not available\n", kernels[k]);
+			continue;
+		}
+		n_fail_before = n_fail;
+		++n_kernels;
+		for (sig = 0; sig < SIG_LAST; ++sig) {
+			for (l = 0; l < sizeof(lengths) / sizeof(size_t); ++l) {
+				const size_t n = lengths[l];
+				test_float(kernels[k], sig, n);
+				test_le(kernels[k], sig, n, 2, conv_s16le_trunc, conv_s16le_trunc_ref, "s16le_trunc");
+				test_le(kernels[k], sig, n, 3, conv_s24le_trunc, conv_s24le_trunc_ref, "s24le_trunc");
+				test_le(kernels[k], sig, n, 4, conv_f32le_trunc, conv_f32le_trunc_ref, "f32le_trunc");
+			}
+		}
+		printf("%-6s %s\n", kernels[k], n_fail > n_fail_before ? "FAILED" : "ok");
+	}
+
+	for (sig = 0; sig < SIG_LAST; ++sig) {
+		for (l = 0; l < sizeof(lengths) / sizeof(size_t); ++l) {
+			const size_t n = lengths[l];
+			test_le_float(sig, n, 2, conv_s16le_float, conv_s16le_trunc_ref, "s16le_float");
+			test_le_float(sig, n, 3, conv_s24le_float, conv_s24le_trunc_ref, "s24le_float");
+			test_le_float(sig, n, 4, conv_f32le_float, conv_f32le_trunc_ref, "f32le_float");
+		}
+	}
+
+	printf("%d kernels, %d tests, %d failed\n", n_kernels, n_test, n_fail);
+	return n_fail ? 1 : 0;
+}
@@ -49,3 +49,35 @@ double frame_to_ms(LTCFrame *f, int fps_num, int fps_den) {
   long long int frame_count = ltcframe_to_framecnt(f, fps);
   return ((double)(1000.0 * frame_count) / fps);
 }
+
+/* integer frame-number <> timecode conversion for nominal (integer) fps.
+ * drop-frame timecode skips fps/15 frame numbers every minute,
+ * except every tenth minute.
+ */
+long long int smpte_to_framecnt(int fps, int df, int h, int m, int s, int f) {
+  long long int cnt = ((h * 60LL + m) * 60 + s) * fps + f;
+  if (df) {
+    const int drop = fps / 15;
+    const long long int mins = h * 60LL + m;
+    cnt -= drop * (mins - mins / 10);
+  }
+  return cnt;
+}
+
+void framecnt_to_smpte(int fps, int df, long long int cnt, int *h, int *m, int *s, int *f) {
+  if (df) {
+    const int drop = fps / 15;
+    const long long int fpm   = fps * 60 - drop;
+    const long long int fp10m = fps * 600 - drop * 9;
+    const long long int d = cnt / fp10m;
+    const long long int r = cnt % fp10m;
+    cnt += drop * 9 * d;
+    if (r > drop) cnt += drop * ((r - drop) / fpm);
+  }
+  *f = cnt % fps;
+  cnt /= fps;
+  *s = cnt % 60;
+  cnt /= 60;
+  *m = cnt % 60;
+  *h = (cnt / 60) % 24;
+}
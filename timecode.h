@@ -7,5 +7,7 @@ long long int do_drop_frames (double fps, int f, int s, int m, int h);
 long long int bcd_to_framecnt(double fps, int df, int f, int s, int m, int h);
 long long int ltcframe_to_framecnt(LTCFrame *lf, double fps);
 double frame_to_ms(LTCFrame *f, int fps_num, int fps_den);
+long long int smpte_to_framecnt(int fps, int df, int h, int m, int s, int f);
+void framecnt_to_smpte(int fps, int df, long long int cnt, int *h, int *m, int *s, int *f);
 
 #endif
@@ -0,0 +1,278 @@
+/* minimal RIFF/RF64 WAV parser and memory-mapped PCM reader
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "wavfile.h"
+#include "sampleconv.h"
+
+#define WAVE_FORMAT_PCM        0x0001
+#define WAVE_FORMAT_IEEE_FLOAT 0x0003
+#define WAVE_FORMAT_EXTENSIBLE 0xFFFE
+
+static inline uint16_t rd_le16(const uint8_t *p) {
+	return p[0] | (p[1] << 8);
+}
+
+static inline uint32_t rd_le32(const uint8_t *p) {
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline uint64_t rd_le64(const uint8_t *p) {
+	return rd_le32(p) | ((uint64_t)rd_le32(p + 4) << 32);
+}
+
+static inline void wr_le16(uint8_t *p, uint16_t v) {
+	p[0] = v; p[1] = v >> 8;
+}
+
+static inline void wr_le32(uint8_t *p, uint32_t v) {
+	p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24;
+}
+
+static inline void wr_le64(uint8_t *p, uint64_t v) {
+	wr_le32(p, v);
+	wr_le32(p + 4, v >> 32);
+}
+
+/* iterate over the chunks of a RIFF file.
+ * *pos is the file-offset of the next chunk-header, the first one is at 12.
+ * returns 0 if a chunk was found, -1 at the end of the buffer.
+ */
+int wav_next_chunk(const uint8_t *buf, size_t len, uint64_t *pos, struct wavchunk *chunk) {
+	if (*pos + 8 > len) {
+		return -1;
+	}
+	memcpy(chunk->id, buf + *pos, 4);
+	chunk->size = rd_le32(buf + *pos + 4);
+	chunk->offset = *pos + 8;
+	*pos = chunk->offset + chunk->size + (chunk->size & 1);
+	return 0;
+}
+
+/* parse the header of a PCM16, PCM24 or float32 RIFF/RF64 file.
+ * buf must contain the file up to (and including) the data-chunk header.
+ * returns 0 on success, -1 if the file is not supported.
+ */
+int wav_parse_header(const uint8_t *buf, size_t len, uint64_t filesize, struct wavinfo *wi) {
+	struct wavchunk chunk;
+	uint64_t pos = 12;
+	uint64_t ds64_data_size = 0;
+	int have_fmt = 0;
+	int tag, bits;
+
+	memset(wi, 0, sizeof(struct wavinfo));
+	if (len < 12 || memcmp(buf + 8, "WAVE", 4)) {
+		return -1;
+	}
+	if (!memcmp(buf, "RF64", 4)) {
+		wi->rf64 = 1;
+	} else if (memcmp(buf, "RIFF", 4)) {
+		return -1;
+	}
+
+	while (!wav_next_chunk(buf, len, &pos, &chunk)) {
+		if (!memcmp(chunk.id, "ds64", 4)) {
+			if (chunk.offset + 24 > len) return -1;
+			ds64_data_size = rd_le64(buf + chunk.offset + 8);
+		}
+		else if (!memcmp(chunk.id, "fmt ", 4)) {
+			if (chunk.size < 16 || chunk.offset + chunk.size > len) return -1;
+			const uint8_t *fmt = buf + chunk.offset;
+			tag = rd_le16(fmt);
+			wi->channels = rd_le16(fmt + 2);
+			wi->samplerate = rd_le32(fmt + 4);
+			bits = rd_le16(fmt + 14);
+			if (tag == WAVE_FORMAT_EXTENSIBLE) {
+				/* the first two bytes of the sub-format GUID are the format tag */
+				if (chunk.size < 40) return -1;
+				tag = rd_le16(fmt + 24);
+			}
+			if (tag == WAVE_FORMAT_PCM && bits == 16) {
+				wi->format = WAV_PCM_16;
+			} else if (tag == WAVE_FORMAT_PCM && bits == 24) {
+				wi->format = WAV_PCM_24;
+			} else if (tag == WAVE_FORMAT_IEEE_FLOAT && bits == 32) {
+				wi->format = WAV_FLOAT_32;
+			} else {
+				return -1;
+			}
+			wi->bytes_per_sample = bits / 8;
+			if (wi->channels < 1 || wi->samplerate < 1 || rd_le16(fmt + 12) != wi->channels * wi->bytes_per_sample) {
+				return -1;
+			}
+			have_fmt = 1;
+		}
+		else if (!memcmp(chunk.id, "data", 4)) {
+			if (!have_fmt) return -1;
+			wi->data_offset = chunk.offset;
+			wi->data_size = chunk.size;
+			if (wi->rf64 && chunk.size == 0xffffffff) {
+				wi->data_size = ds64_data_size;
+			}
+			/* unfinished recording: use the remainder of the file */
+			if (wi->data_size == 0 || wi->data_offset + wi->data_size > filesize) {
+				wi->data_size = filesize - wi->data_offset;
+			}
+			wi->frames = wi->data_size / (wi->channels * wi->bytes_per_sample);
+			return 0;
+		}
+	}
+	return -1;
+}
+
+/* write the header of a file with the given format and data_size,
+ * up to and including the data-chunk header: RIFF with a plain fmt chunk,
+ * or RF64 with a ds64 chunk if wi->rf64 is set. With reserve, a RIFF
+ * file has a JUNK chunk in place of the ds64 chunk, so that it can be
+ * turned into RF64 later on.
+ * buf must hold WAV_HEADER_MAX bytes, returns the size of the header
+ * (the file-offset of the audio data).
+ */
+size_t wav_make_header(uint8_t *buf, const struct wavinfo *wi, int reserve) {
+	const int bps = wi->bytes_per_sample;
+	const uint64_t pad = wi->data_size & 1;
+	uint8_t *p = buf;
+
+	memset(buf, 0, WAV_HEADER_MAX);
+	memcpy(p, wi->rf64 ? "RF64" : "RIFF", 4);
+	memcpy(p + 8, "WAVE", 4);
+	p += 12;
+
+	if (wi->rf64) {
+		memcpy(p, "ds64", 4);
+		wr_le32(p + 4, 28);
+		wr_le64(p + 8, 72 + wi->data_size + pad); // RIFF size
+		wr_le64(p + 16, wi->data_size);
+		wr_le64(p + 24, wi->data_size / (wi->channels * bps)); // sample count
+		wr_le32(p + 32, 0); // table length
+		p += 36;
+	} else if (reserve) {
+		memcpy(p, "JUNK", 4);
+		wr_le32(p + 4, 28);
+		p += 36;
+	}
+
+	memcpy(p, "fmt ", 4);
+	wr_le32(p + 4, 16);
+	wr_le16(p + 8, wi->format == WAV_FLOAT_32 ? WAVE_FORMAT_IEEE_FLOAT : WAVE_FORMAT_PCM);
+	wr_le16(p + 10, wi->channels);
+	wr_le32(p + 12, wi->samplerate);
+	wr_le32(p + 16, wi->samplerate * wi->channels * bps);
+	wr_le16(p + 20, wi->channels * bps);
+	wr_le16(p + 22, 8 * bps);
+	p += 24;
+
+	memcpy(p, "data", 4);
+	p += 8;
+
+	if (wi->rf64) {
+		wr_le32(buf + 4, 0xffffffff);
+		wr_le32(p - 4, 0xffffffff);
+	} else {
+		wr_le32(buf + 4, (p - buf) - 8 + wi->data_size + pad);
+		wr_le32(p - 4, wi->data_size);
+	}
+	return p - buf;
+}
+
+int wavmap_open(struct wavmap *wm, const char *filename) {
+	struct stat st;
+	void *map;
+
+	memset(wm, 0, sizeof(struct wavmap));
+	wm->fd = open(filename, O_RDONLY);
+	if (wm->fd < 0) {
+		return -1;
+	}
+	if (fstat(wm->fd, &st) || st.st_size < 44 || (uint64_t) st.st_size > SIZE_MAX) {
+		close(wm->fd);
+		return -1;
+	}
+
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, wm->fd, 0);
+	if (map == MAP_FAILED) {
+		close(wm->fd);
+		return -1;
+	}
+	wm->map = (const uint8_t *) map;
+	wm->map_len = st.st_size;
+
+	if (wav_parse_header(wm->map, wm->map_len, st.st_size, &wm->info) || wm->info.frames == 0) {
+		wavmap_close(wm);
+		return -1;
+	}
+	wm->data = wm->map + wm->info.data_offset;
+
+	madvise(map, wm->map_len, MADV_SEQUENTIAL);
+	return 0;
+}
+
+void wavmap_close(struct wavmap *wm) {
+	if (wm->map) {
+		munmap((void *) wm->map, wm->map_len);
+	}
+	if (wm->fd >= 0) {
+		close(wm->fd);
+	}
+	wm->map = NULL;
+	wm->fd = -1;
+}
+
+/* convert n_frames of the given channel (first = 0), starting at audio-frame pos,
+ * to the decoder's sample format. The conversion is identical to
+ * libsndfile's float conversion followed by "128 + f * 127".
+ */
+void wavmap_read(struct wavmap *wm, ltcsnd_sample_t *sound, int64_t pos, size_t n_frames, int channel) {
+	const size_t stride = wm->info.channels * wm->info.bytes_per_sample;
+	const uint8_t *p = wm->data + pos * stride + channel * wm->info.bytes_per_sample;
+
+	switch (wm->info.format) {
+		case WAV_PCM_16:
+			conv_s16le_trunc(sound, p, n_frames, stride);
+			break;
+		case WAV_PCM_24:
+			conv_s24le_trunc(sound, p, n_frames, stride);
+			break;
+		case WAV_FLOAT_32:
+			conv_f32le_trunc(sound, p, n_frames, stride);
+			break;
+	}
+}
+
+/* as wavmap_read(), normalized to float */
+void wavmap_read_float(struct wavmap *wm, float *out, int64_t pos, size_t n_frames, int channel) {
+	const size_t stride = wm->info.channels * wm->info.bytes_per_sample;
+	const uint8_t *p = wm->data + pos * stride + channel * wm->info.bytes_per_sample;
+
+	switch (wm->info.format) {
+		case WAV_PCM_16:
+			conv_s16le_float(out, p, n_frames, stride);
+			break;
+		case WAV_PCM_24:
+			conv_s24le_float(out, p, n_frames, stride);
+			break;
+		case WAV_FLOAT_32:
+			conv_f32le_float(out, p, n_frames, stride);
+			break;
+	}
+}
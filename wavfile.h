@@ -0,0 +1,52 @@
+#ifndef WAVFILE_H
+#define WAVFILE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <ltc.h>
+
+enum WAV_SAMPLE_FORMAT {
+	WAV_PCM_16 = 0,
+	WAV_PCM_24,
+	WAV_FLOAT_32,
+};
+
+/* RIFF/RF64 chunk header */
+struct wavchunk {
+	char     id[4];
+	uint64_t offset; ///< file-offset of the chunk's data
+	uint64_t size;   ///< size of the chunk's data (not padded)
+};
+
+struct wavinfo {
+	enum WAV_SAMPLE_FORMAT format;
+	int      channels;
+	int      samplerate;
+	int      bytes_per_sample;
+	int      rf64;
+	uint64_t data_offset;
+	uint64_t data_size;
+	int64_t  frames;
+};
+
+/* memory-mapped PCM file */
+struct wavmap {
+	int            fd;
+	const uint8_t *map;
+	size_t         map_len;
+	const uint8_t *data;
+	struct wavinfo info;
+};
+
+#define WAV_HEADER_MAX 80 ///< size of the header written by wav_make_header()
+
+int wav_next_chunk(const uint8_t *buf, size_t len, uint64_t *pos, struct wavchunk *chunk);
+int wav_parse_header(const uint8_t *buf, size_t len, uint64_t filesize, struct wavinfo *wi);
+size_t wav_make_header(uint8_t *buf, const struct wavinfo *wi, int reserve);
+
+int wavmap_open(struct wavmap *wm, const char *filename);
+void wavmap_close(struct wavmap *wm);
+void wavmap_read(struct wavmap *wm, ltcsnd_sample_t *sound, int64_t pos, size_t n_frames, int channel);
+void wavmap_read_float(struct wavmap *wm, float *out, int64_t pos, size_t n_frames, int channel);
+
+#endif
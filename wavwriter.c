@@ -0,0 +1,287 @@
+/* buffered WAV/RF64 writer
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // O_DIRECT
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "wavwriter.h"
+
+#define RIFF_MAX 0xffffffffULL
+
+/* reserve the space of a file, returns 0 on success */
+int wav_preallocate(int fd, uint64_t len) {
+#ifdef __APPLE__
+	return ftruncate(fd, len);
+#else
+	if (posix_fallocate(fd, 0, len) == 0) {
+		return 0;
+	}
+	/* not supported by the file-system */
+	return ftruncate(fd, len);
+#endif
+}
+
+/* convert 16 bit samples to the file's little-endian format, the way
+ * libsndfile does it: PCM24 is shifted, float32 is normalized to +-1.
+ * returns the number of bytes */
+size_t wav_encode_s16(uint8_t *out, const short *in, size_t n, enum WAV_SAMPLE_FORMAT format) {
+	size_t i;
+	switch (format) {
+		case WAV_PCM_24:
+			for (i = 0; i < n; ++i) {
+				out[3 * i]     = 0;
+				out[3 * i + 1] = in[i];
+				out[3 * i + 2] = in[i] >> 8;
+			}
+			return 3 * n;
+		case WAV_FLOAT_32:
+			for (i = 0; i < n; ++i) {
+				union { float f; uint32_t u; } v;
+				v.f = in[i] / 32768.f;
+				out[4 * i]     = v.u;
+				out[4 * i + 1] = v.u >> 8;
+				out[4 * i + 2] = v.u >> 16;
+				out[4 * i + 3] = v.u >> 24;
+			}
+			return 4 * n;
+		default:
+			for (i = 0; i < n; ++i) {
+				out[2 * i]     = in[i];
+				out[2 * i + 1] = in[i] >> 8;
+			}
+			return 2 * n;
+	}
+}
+
+static int write_all(int fd, const uint8_t *p, size_t len) {
+	while (len > 0) {
+		ssize_t rv = write(fd, p, len);
+		if (rv < 0 && errno == EINTR) {
+			continue;
+		}
+		if (rv <= 0) {
+			return -1;
+		}
+		p += rv;
+		len -= rv;
+	}
+	return 0;
+}
+
+/* write len bytes at pos, continuing after short writes.
+ * returns 0 on success */
+int wav_pwrite_all(int fd, const void *buf, size_t len, off_t pos) {
+	const uint8_t *p = (const uint8_t*) buf;
+	while (len > 0) {
+		ssize_t rv = pwrite(fd, p, len, pos);
+		if (rv < 0 && errno == EINTR) {
+			continue;
+		}
+		if (rv <= 0) {
+			return -1;
+		}
+		p += rv;
+		pos += rv;
+		len -= rv;
+	}
+	return 0;
+}
+
+/* write the buffer, with O_DIRECT only whole blocks */
+static void flush(struct wavwriter *ww) {
+	size_t len = ww->fill;
+	if (ww->direct) {
+		len -= len % WAVWRITER_ALIGN;
+	}
+	if (len == 0 || ww->error) {
+		return;
+	}
+	if (write_all(ww->fd, ww->buf, len)) {
+#ifdef O_DIRECT
+		if (ww->direct && errno == EINVAL) {
+			/* the file-system accepts O_DIRECT on open, but not on write */
+			fcntl(ww->fd, F_SETFL, fcntl(ww->fd, F_GETFL) & ~O_DIRECT);
+			ww->direct = 0;
+			flush(ww);
+			return;
+		}
+#endif
+		ww->error = errno ? errno : EIO;
+		return;
+	}
+	memmove(ww->buf, ww->buf + len, ww->fill - len);
+	ww->fill -= len;
+}
+
+static int init(struct wavwriter *ww, const struct wavinfo *wi, size_t buf_size, int flags) {
+	memset(ww, 0, sizeof(struct wavwriter));
+	ww->info = *wi;
+	ww->fd = -1;
+	ww->raw = flags & WAVWRITER_RAW;
+
+	if (wi->data_size > 0) {
+		ww->info.rf64 = wi->data_size + 44 > RIFF_MAX;
+	} else {
+		ww->info.rf64 = 0;
+		ww->reserve = 1;
+	}
+
+	buf_size -= buf_size % WAVWRITER_ALIGN;
+	if (buf_size < WAVWRITER_ALIGN) {
+		buf_size = WAVWRITER_ALIGN;
+	}
+	if (posix_memalign((void**)&ww->buf, WAVWRITER_ALIGN, buf_size)) {
+		ww->buf = NULL;
+		return -1;
+	}
+	ww->buf_size = buf_size;
+
+	/* the header is the start of the first block */
+	if (!ww->raw) {
+		ww->hdr_len = wav_make_header(ww->buf, &ww->info, ww->reserve);
+		ww->fill = ww->hdr_len;
+	}
+	return 0;
+}
+
+int wavwriter_open(struct wavwriter *ww, const char *path, const struct wavinfo *wi, size_t buf_size, int flags) {
+	int oflags = O_WRONLY | O_CREAT | O_TRUNC;
+
+	if (init(ww, wi, buf_size, flags)) {
+		return -1;
+	}
+
+#ifdef O_DIRECT
+	if (flags & WAVWRITER_DIRECT) {
+		ww->fd = open(path, oflags | O_DIRECT, 0644);
+		ww->direct = ww->fd >= 0;
+	}
+#endif
+	if (ww->fd < 0) {
+		ww->fd = open(path, oflags, 0644);
+	}
+	if (ww->fd < 0) {
+		free(ww->buf);
+		ww->buf = NULL;
+		return -1;
+	}
+	ww->seekable = 1;
+
+	if (wi->data_size > 0) {
+		wav_preallocate(ww->fd, ww->hdr_len + wi->data_size + (wi->data_size & 1));
+	}
+	return 0;
+}
+
+/* write to an open file-descriptor, e.g. a pipe. Unless the writer is
+ * raw, the header can only be finalized if the fd is seekable. */
+int wavwriter_open_fd(struct wavwriter *ww, int fd, const struct wavinfo *wi, size_t buf_size, int flags) {
+	if (init(ww, wi, buf_size, flags & ~WAVWRITER_DIRECT)) {
+		return -1;
+	}
+	ww->fd = fd;
+	ww->seekable = lseek(fd, 0, SEEK_CUR) == 0;
+	return 0;
+}
+
+int wavwriter_write(struct wavwriter *ww, const void *data, size_t len) {
+	const uint8_t *p = (const uint8_t*) data;
+	ww->data_size += len;
+	while (len > 0 && !ww->error) {
+		size_t n = ww->buf_size - ww->fill;
+		if (n > len) {
+			n = len;
+		}
+		memcpy(ww->buf + ww->fill, p, n);
+		ww->fill += n;
+		p += n;
+		len -= n;
+		if (ww->fill == ww->buf_size) {
+			flush(ww);
+		}
+	}
+	return ww->error ? -1 : 0;
+}
+
+/* write 16 bit samples in the file's format */
+int wavwriter_write_s16(struct wavwriter *ww, const short *data, size_t n_samples) {
+	uint8_t tmp[4096];
+	const size_t step = sizeof(tmp) / 4;
+	while (n_samples > 0 && !ww->error) {
+		const size_t n = n_samples < step ? n_samples : step;
+		wavwriter_write(ww, tmp, wav_encode_s16(tmp, data, n, ww->info.format));
+		data += n;
+		n_samples -= n;
+	}
+	return ww->error ? -1 : 0;
+}
+
+/* write the remaining data, update the header with the final size */
+int wavwriter_close(struct wavwriter *ww) {
+	uint8_t hdr[WAV_HEADER_MAX];
+	size_t hdr_len;
+	int rv;
+
+	if (ww->fd < 0) {
+		return -1;
+	}
+#ifdef O_DIRECT
+	if (ww->direct) {
+		/* the tail is not block aligned */
+		flush(ww);
+		fcntl(ww->fd, F_SETFL, fcntl(ww->fd, F_GETFL) & ~O_DIRECT);
+		ww->direct = 0;
+	}
+#endif
+	if ((ww->data_size & 1) && !ww->raw) {
+		const uint8_t pad = 0;
+		wavwriter_write(ww, &pad, 1);
+		ww->data_size -= 1;
+	}
+	flush(ww);
+
+	if (!ww->raw && ww->seekable) {
+		ww->info.data_size = ww->data_size;
+		if (ww->reserve && ww->data_size + 80 > RIFF_MAX) {
+			ww->info.rf64 = 1;
+		}
+		hdr_len = wav_make_header(hdr, &ww->info, ww->reserve);
+		if (hdr_len != ww->hdr_len || wav_pwrite_all(ww->fd, hdr, hdr_len, 0)) {
+			ww->error = EIO;
+		}
+	}
+	/* less than expected, or interrupted */
+	if (ww->seekable && ftruncate(ww->fd, ww->hdr_len + ww->data_size + ((ww->data_size & 1) && !ww->raw))) {
+		ww->error = EIO;
+	}
+
+	if (close(ww->fd) && !ww->error) {
+		ww->error = errno ? errno : EIO;
+	}
+	rv = ww->error ? -1 : 0;
+	free(ww->buf);
+	ww->buf = NULL;
+	ww->fd = -1;
+	return rv;
+}
@@ -0,0 +1,49 @@
+#ifndef WAVWRITER_H
+#define WAVWRITER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/types.h>
+#include "wavfile.h"
+
+/* buffered WAV/RF64 writer.
+ *
+ * The header and the audio data are collected in one large buffer that
+ * is written in blocks. If the length of the data is known in advance,
+ * the file is preallocated. Otherwise space for a ds64 chunk is
+ * reserved (as JUNK) and the file becomes RF64 if it grows beyond 4GB.
+ * The header is finalized by wavwriter_close().
+ * A raw writer writes the audio data only.
+ */
+
+#define WAVWRITER_DIRECT 1 ///< bypass the page-cache (O_DIRECT), if supported
+#define WAVWRITER_RAW    2 ///< headerless PCM
+
+#define WAVWRITER_ALIGN 4096 ///< block size for O_DIRECT
+
+struct wavwriter {
+	int      fd;
+	int      direct;
+	int      reserve;    ///< the header has a JUNK chunk for ds64
+	int      raw;
+	int      seekable;   ///< header and length can be fixed up on close
+	struct wavinfo info; ///< info.data_size: expected size, 0: unknown
+	size_t   hdr_len;
+	uint8_t *buf;
+	size_t   buf_size;
+	size_t   fill;
+	uint64_t data_size;  ///< bytes of audio written
+	int      error;      ///< errno of the first failed write, 0: ok
+};
+
+int  wav_preallocate(int fd, uint64_t len);
+int  wav_pwrite_all(int fd, const void *buf, size_t len, off_t pos);
+size_t wav_encode_s16(uint8_t *out, const short *in, size_t n, enum WAV_SAMPLE_FORMAT format);
+
+int  wavwriter_open(struct wavwriter *ww, const char *path, const struct wavinfo *wi, size_t buf_size, int flags);
+int  wavwriter_open_fd(struct wavwriter *ww, int fd, const struct wavinfo *wi, size_t buf_size, int flags);
+int  wavwriter_write(struct wavwriter *ww, const void *data, size_t len);
+int  wavwriter_write_s16(struct wavwriter *ww, const short *data, size_t n_samples);
+int  wavwriter_close(struct wavwriter *ww);
+
+#endif